@@ -0,0 +1,441 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2023, Christoph Stiller. All rights reserved.
+// 
+// Redistribution and use in next and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of next code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation 
+//    and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "execution-flow.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#pragma warning (push, 0)
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wall"
+#pragma GCC diagnostic ignored "-Wextra"
+#endif
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/bit.h"
+#ifdef _MSC_VER
+#pragma warning (pop)
+#else
+#pragma GCC diagnostic pop
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define FATAL(x, ...) do { printf(x "\n", __VA_ARGS__); exit(-1); } while (0)
+#define FATAL_IF(conditional, x, ...) do { if (conditional) { FATAL(x, __VA_ARGS__); } } while (0)
+
+static const char *_ArgumentInstructions = "-instructions";
+static const char *_ArgumentIterations = "-iter";
+static const char *_ArgumentRuns = "-runs";
+static const char *_ArgumentLookupOnly = "-lookup";
+static const char *_ArgumentCheckFlowFile = "-check-flowfile";
+
+constexpr size_t DefaultInstructionCount = 4096;
+constexpr size_t DefaultIterations = 100;
+constexpr size_t DefaultRuns = 5;
+constexpr size_t LookupCount = 1024 * 1024 * 64;
+constexpr size_t CheckIterations = 4;
+
+// Independent integer, load, store, shift & AVX instructions, so every port of the usual models is hit.
+static const uint8_t BlockPattern[] =
+{
+  0x48, 0x01, 0xD8,             // add rax, rbx
+  0x48, 0x0F, 0xAF, 0xCA,       // imul rcx, rdx
+  0x4C, 0x8B, 0x44, 0x24, 0x08, // mov r8, qword ptr [rsp + 8]
+  0xC5, 0xF4, 0x58, 0xC2,       // vaddps ymm0, ymm1, ymm2
+  0x48, 0x8D, 0x74, 0x87, 0x10, // lea rsi, [rdi + 4*rax + 16]
+  0x4C, 0x89, 0x4C, 0x24, 0x10, // mov qword ptr [rsp + 16], r9
+  0x48, 0xC1, 0xE2, 0x03,       // shl rdx, 3
+  0xC5, 0xDC, 0x59, 0xDD,       // vmulps ymm3, ymm4, ymm5
+};
+
+constexpr size_t BlockPatternInstructionCount = 8;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static double bench_seconds_since(const std::chrono::high_resolution_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Simulates a large block end to end. Every issued instruction triggers an `Issued` event, that looks up every resource it uses.
+static void bench_simulate(const size_t instructionCount, const size_t iterations, const size_t runs)
+{
+  std::vector<uint8_t> block;
+
+  for (size_t i = 0; i < instructionCount; i += BlockPatternInstructionCount)
+    block.insert(block.end(), BlockPattern, BlockPattern + sizeof(BlockPattern));
+
+  ExecutionFlowContext *pContext = nullptr;
+  FATAL_IF(!execution_flow_context_create(&pContext, CoreArchitecture::SkylakeClient), "Failed to create execution flow context. Aborting.");
+
+  double bestSeconds = 0;
+  size_t issuedUOps = 0;
+
+  for (size_t run = 0; run < runs; run++)
+  {
+    PortUsageFlow flow;
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    const bool result = execution_flow_create(pContext, block.data(), block.size(), &flow, iterations, 0);
+    const double seconds = bench_seconds_since(start);
+
+    FATAL_IF(!result, "Failed to simulate the block. Aborting.");
+
+    issuedUOps = 0;
+
+    for (const auto &_instruction : flow.instructionExecutionInfo)
+      issuedUOps += _instruction.uOpCount * iterations;
+
+    if (run == 0 || seconds < bestSeconds)
+      bestSeconds = seconds;
+  }
+
+  execution_flow_context_destroy(&pContext);
+
+  printf("Simulated %" PRIu64 " instructions x %" PRIu64 " iterations in %.3f s (best of %" PRIu64 "): %.2f M issued uOps / s.\n", instructionCount, iterations, bestSeconds, runs, issuedUOps / bestSeconds * 1e-6);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// A resource model shaped like the x86 ones: mostly single unit ports, some resources with a few units & groups that aren't ports.
+struct BenchResource
+{
+  uint32_t units;
+  bool isPort;
+};
+
+static void bench_get_resource_model(std::vector<BenchResource> &resources)
+{
+  resources.push_back({ 0, false }); // index 0 is the `null`-index.
+
+  for (size_t i = 0; i < 10; i++)
+    resources.push_back({ 1, true });
+
+  resources.push_back({ 2, true });
+  resources.push_back({ 4, true });
+  resources.push_back({ 3, true });
+
+  for (size_t i = 0; i < 12; i++)
+    resources.push_back({ 4, false });
+}
+
+// The `(resource index, unit mask) => port index` map that was queried with `contains` & `operator[]` before the flat table.
+static size_t bench_lookup_map(const llvm::SmallDenseMap<std::pair<uint64_t, uint64_t>, size_t, 32U> &map, const std::pair<uint64_t, uint64_t> &key)
+{
+  if (!map.contains(key))
+    return (size_t)-1;
+
+  return map.find(key)->second;
+}
+
+// Same as `FlowView::getPortIndex`.
+static size_t bench_lookup_table(const std::vector<uint32_t> &table, const size_t stride, const uint64_t llvmResourceIndex, const uint64_t unitMask)
+{
+  if (unitMask == 0 || (unitMask & (unitMask - 1)) != 0)
+    return (size_t)-1;
+
+  const uint64_t unitBit = (uint64_t)llvm::countr_zero(unitMask);
+
+  if (unitBit >= stride || llvmResourceIndex * stride + unitBit >= table.size())
+    return (size_t)-1;
+
+  const uint32_t portIndex = table[llvmResourceIndex * stride + unitBit];
+
+  return portIndex == UINT32_MAX ? (size_t)-1 : (size_t)portIndex;
+}
+
+// Isolates the port lookup of the `Issued` event: the previous map against the flat table, on the same stream of used resources.
+static void bench_lookup()
+{
+  std::vector<BenchResource> resources;
+  bench_get_resource_model(resources);
+
+  llvm::SmallDenseMap<std::pair<uint64_t, uint64_t>, size_t, 32U> map;
+  std::vector<uint32_t> table;
+  size_t stride = 0;
+  size_t portCount = 0;
+
+  for (const auto &_resource : resources)
+    stride = std::max(stride, (size_t)_resource.units);
+
+  table.resize(resources.size() * stride, UINT32_MAX);
+
+  for (size_t i = 1; i < resources.size(); i++)
+  {
+    if (!resources[i].isPort)
+      continue;
+
+    for (size_t j = 0; j < resources[i].units; j++)
+    {
+      map.insert({ { i, (uint64_t)1 << j }, portCount });
+      table[i * stride + j] = (uint32_t)portCount;
+      portCount++;
+    }
+  }
+
+  // Issued events only ever reference single units of the resources.
+  std::vector<std::pair<uint64_t, uint64_t>> keys(4096);
+  std::mt19937_64 random(0x5EED);
+
+  for (auto &_key : keys)
+  {
+    size_t resourceIndex = 0;
+
+    do
+    {
+      resourceIndex = 1 + random() % (resources.size() - 1);
+    } while (!resources[resourceIndex].isPort);
+
+    _key = { resourceIndex, (uint64_t)1 << (random() % resources[resourceIndex].units) };
+  }
+
+  size_t checksum = 0;
+
+  const auto mapStart = std::chrono::high_resolution_clock::now();
+
+  for (size_t i = 0; i < LookupCount; i++)
+    checksum += bench_lookup_map(map, keys[i & (keys.size() - 1)]);
+
+  const double mapSeconds = bench_seconds_since(mapStart);
+
+  const auto tableStart = std::chrono::high_resolution_clock::now();
+
+  for (size_t i = 0; i < LookupCount; i++)
+    checksum -= bench_lookup_table(table, stride, keys[i & (keys.size() - 1)].first, keys[i & (keys.size() - 1)].second);
+
+  const double tableSeconds = bench_seconds_since(tableStart);
+
+  FATAL_IF(checksum != 0, "The lookups disagree (%" PRIu64 "). Aborting.", checksum);
+
+  printf("Port lookups: map %.2f M / s, flat table %.2f M / s (%.2fx).\n", LookupCount / mapSeconds * 1e-6, LookupCount / tableSeconds * 1e-6, mapSeconds / tableSeconds);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool bench_flows_equal(const PortUsageFlow &a, const PortUsageFlow &b)
+{
+  if (a.ports.size() != b.ports.size() || a.instructionExecutionInfo.size() != b.instructionExecutionInfo.size() || a.statistics.totalUOps != b.statistics.totalUOps || a.statistics.portBusyCycles != b.statistics.portBusyCycles)
+    return false;
+
+  for (size_t i = 0; i < a.ports.size(); i++)
+    if (a.ports[i].name != b.ports[i].name || a.ports[i].resourceTypeIndex != b.ports[i].resourceTypeIndex)
+      return false;
+
+  for (size_t i = 0; i < a.instructionExecutionInfo.size(); i++)
+  {
+    const InstructionInfo &instructionA = a.instructionExecutionInfo[i];
+    const InstructionInfo &instructionB = b.instructionExecutionInfo[i];
+
+    if (instructionA.instructionIndex != instructionB.instructionIndex || instructionA.disassembly != instructionB.disassembly || instructionA.perIteration.size() != instructionB.perIteration.size())
+      return false;
+
+    for (size_t j = 0; j < instructionA.perIteration.size(); j++)
+    {
+      const LoopInstructionInfo &recordA = instructionA.perIteration[j];
+      const LoopInstructionInfo &recordB = instructionB.perIteration[j];
+
+      if (recordA.clockIssued != recordB.clockIssued || recordA.clockRetired != recordB.clockRetired || recordA.usage.size() != recordB.usage.size() || recordA.resourcePressure.associatedResources.size() != recordB.resourcePressure.associatedResources.size())
+        return false;
+
+      for (size_t k = 0; k < recordA.usage.size(); k++)
+        if (recordA.usage[k].resourceIndex != recordB.usage[k].resourceIndex || recordA.usage[k].pressure != recordB.usage[k].pressure)
+          return false;
+    }
+  }
+
+  return true;
+}
+
+static bool bench_flow_file_loads(const std::vector<uint64_t> &buffer, const size_t size)
+{
+  FlowFileView *pView = nullptr;
+
+  if (!execution_flow_load(buffer.data(), size, &pView))
+    return false;
+
+  execution_flow_view_destroy(&pView);
+
+  return true;
+}
+
+// Overwrites the `uint64_t` at `fieldOffset` of element `index` of a section with `value`, expects the file to be rejected & restores it.
+static bool bench_flow_file_rejects(std::vector<uint64_t> &buffer, const size_t size, const FlowFileSectionType type, const size_t elementSize, const size_t index, const size_t fieldOffset, const uint64_t value)
+{
+  const FlowFileHeader &header = *reinterpret_cast<const FlowFileHeader *>(buffer.data());
+
+  // Nothing to corrupt, if the simulation didn't produce any elements of that type.
+  if (header.sections[type].count <= index)
+    return true;
+
+  uint8_t *pField = reinterpret_cast<uint8_t *>(buffer.data()) + header.sections[type].offset + elementSize * index + fieldOffset;
+
+  uint64_t original;
+  memcpy(&original, pField, sizeof(original));
+  memcpy(pField, &value, sizeof(value));
+
+  const bool loaded = bench_flow_file_loads(buffer, size);
+
+  memcpy(pField, &original, sizeof(original));
+
+  return !loaded;
+}
+
+// Saves a simulated flow, loads it back & compares it, then checks that indices pointing outside of their sections are rejected when loading.
+static void bench_check_flow_file(const char *filename)
+{
+  std::vector<uint8_t> block(BlockPattern, BlockPattern + sizeof(BlockPattern));
+
+  ExecutionFlowContext *pContext = nullptr;
+  FATAL_IF(!execution_flow_context_create(&pContext, CoreArchitecture::SkylakeClient), "Failed to create execution flow context. Aborting.");
+
+  PortUsageFlow flow;
+  FATAL_IF(!execution_flow_create(pContext, block.data(), block.size(), &flow, CheckIterations, 0), "Failed to simulate the block. Aborting.");
+
+  execution_flow_context_destroy(&pContext);
+
+  FATAL_IF(!execution_flow_save(flow, filename), "Failed to save flow to '%s'. Aborting.", filename);
+
+  FlowFileView *pView = nullptr;
+  FATAL_IF(!execution_flow_load(filename, &pView), "Failed to load flow from '%s'. Aborting.", filename);
+
+  PortUsageFlow loadedFlow;
+  const bool result = execution_flow_view_get_flow(pView, &loadedFlow);
+  execution_flow_view_destroy(&pView);
+
+  FATAL_IF(!result, "Failed to deserialize flow. Aborting.");
+  FATAL_IF(!bench_flows_equal(flow, loadedFlow), "The loaded flow differs from the saved one. Aborting.");
+
+  // Load the file into 8 byte aligned memory, so it can be corrupted in place.
+  FILE *pFile = fopen(filename, "rb");
+  FATAL_IF(pFile == nullptr, "Failed to open '%s'. Aborting.", filename);
+
+  fseek(pFile, 0, SEEK_END);
+  const size_t size = (size_t)ftell(pFile);
+  fseek(pFile, 0, SEEK_SET);
+
+  std::vector<uint64_t> buffer((size + 7) / 8);
+  const size_t readBytes = fread(buffer.data(), 1, size, pFile);
+  fclose(pFile);
+  remove(filename);
+
+  FATAL_IF(readBytes != size, "Failed to read '%s'. Aborting.", filename);
+  FATAL_IF(!bench_flow_file_loads(buffer, size), "Failed to load flow from memory. Aborting.");
+
+  const uint64_t instructionCount = flow.instructionExecutionInfo.size();
+  const uint64_t portCount = flow.ports.size();
+
+  FATAL_IF(!bench_flow_file_rejects(buffer, size, FFS_Instructions, sizeof(FlowFileInstruction), 0, offsetof(FlowFileInstruction, instructionIndex), instructionCount), "Out of range instruction index was accepted. Aborting.");
+  FATAL_IF(!bench_flow_file_rejects(buffer, size, FFS_Instructions, sizeof(FlowFileInstruction), 0, offsetof(FlowFileInstruction, instructionIndex), 1), "Instruction index not matching its position was accepted. Aborting.");
+  FATAL_IF(!bench_flow_file_rejects(buffer, size, FFS_Usage, sizeof(FlowFileUsage), 0, offsetof(FlowFileUsage, portIndex), portCount), "Out of range port index was accepted. Aborting.");
+  FATAL_IF(!bench_flow_file_rejects(buffer, size, FFS_Records, sizeof(FlowFileRecord), 0, offsetof(FlowFileRecord, registerOrigin) + offsetof(FlowFileOrigin, instructionIndex), instructionCount), "Out of range register origin was accepted. Aborting.");
+  FATAL_IF(!bench_flow_file_rejects(buffer, size, FFS_Records, sizeof(FlowFileRecord), 0, offsetof(FlowFileRecord, memoryOrigin) + offsetof(FlowFileOrigin, instructionIndex), instructionCount), "Out of range memory origin was accepted. Aborting.");
+  FATAL_IF(!bench_flow_file_rejects(buffer, size, FFS_ResourceDependencies, sizeof(FlowFileResourceDependency), 0, offsetof(FlowFileResourceDependency, origin) + offsetof(FlowFileOrigin, instructionIndex), instructionCount), "Out of range resource origin was accepted. Aborting.");
+  FATAL_IF(!bench_flow_file_rejects(buffer, size, FFS_ResourceDependencies, sizeof(FlowFileResourceDependency), 0, offsetof(FlowFileResourceDependency, firstMatchingPortIndex), portCount), "Out of range resource port index was accepted. Aborting.");
+
+  // The file has to still be valid after all fields have been restored.
+  FATAL_IF(!bench_flow_file_loads(buffer, size), "Failed to load restored flow from memory. Aborting.");
+
+  printf("Flow file round trip & validation checks passed (%" PRIu64 " bytes).\n", size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **pArgv)
+{
+  size_t instructionCount = DefaultInstructionCount;
+  size_t iterations = DefaultIterations;
+  size_t runs = DefaultRuns;
+  bool lookupOnly = false;
+  const char *checkFilename = nullptr;
+
+  for (int argIdx = 1; argIdx < argc;)
+  {
+    const int argsRemaining = argc - argIdx;
+
+    if (argsRemaining >= 2 && strcmp(_ArgumentInstructions, pArgv[argIdx]) == 0)
+    {
+      instructionCount = strtoull(pArgv[argIdx + 1], nullptr, 10);
+      argIdx += 2;
+    }
+    else if (argsRemaining >= 2 && strcmp(_ArgumentIterations, pArgv[argIdx]) == 0)
+    {
+      iterations = strtoull(pArgv[argIdx + 1], nullptr, 10);
+      argIdx += 2;
+    }
+    else if (argsRemaining >= 2 && strcmp(_ArgumentRuns, pArgv[argIdx]) == 0)
+    {
+      runs = strtoull(pArgv[argIdx + 1], nullptr, 10);
+      argIdx += 2;
+    }
+    else if (strcmp(_ArgumentLookupOnly, pArgv[argIdx]) == 0)
+    {
+      lookupOnly = true;
+      argIdx++;
+    }
+    else if (argsRemaining >= 2 && strcmp(_ArgumentCheckFlowFile, pArgv[argIdx]) == 0)
+    {
+      checkFilename = pArgv[argIdx + 1];
+      argIdx += 2;
+    }
+    else
+    {
+      printf("Usage: execution-flow-bench [%s <count>] [%s <count>] [%s <count>] [%s] [%s <temporary file>]\n", _ArgumentInstructions, _ArgumentIterations, _ArgumentRuns, _ArgumentLookupOnly, _ArgumentCheckFlowFile);
+      printf("\t%s: instructions of the simulated block (default: %" PRIu64 ")\n", _ArgumentInstructions, DefaultInstructionCount);
+      printf("\t%s: simulated iterations (default: %" PRIu64 ")\n", _ArgumentIterations, DefaultIterations);
+      printf("\t%s: the fastest of this many simulations is reported (default: %" PRIu64 ")\n", _ArgumentRuns, DefaultRuns);
+      printf("\t%s: only compares the port lookup of the previous map & the flat table, without simulating\n", _ArgumentLookupOnly);
+      printf("\t%s: saves & loads a flow through the file, checks that it's unchanged & that corrupted files are rejected, instead of benchmarking\n", _ArgumentCheckFlowFile);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (checkFilename != nullptr)
+  {
+    bench_check_flow_file(checkFilename);
+    return 0;
+  }
+
+  FATAL_IF(instructionCount == 0 || iterations == 0 || runs == 0, "Instruction count, iterations & runs must not be 0. Aborting.");
+
+  bench_lookup();
+
+  if (!lookupOnly)
+    bench_simulate(instructionCount, iterations, runs);
+
+  return 0;
+}
@@ -15,6 +15,7 @@ project(ProjectName)
 
     ignoredefaultlibraries { "msvcrt" }
   filter { "system:linux" }
+    links { "pthread" }
 
   filter { }
   
@@ -31,10 +32,8 @@ project(ProjectName)
   files { "project.lua" }
   
   includedirs { "../execution-flow/include" }
-  includedirs { "../3rdParty/Zydis/include" }
 
   links { "../builds/lib/execution-flow.lib" }
-  links { "../3rdParty/zydis/lib/Zydis.lib" }
 
   filter { "configurations:Debug", "system:Windows" }
     ignoredefaultlibraries { "libcmt" }
@@ -28,12 +28,7 @@
 
 #include "execution-flow.h"
 #include "html_static.h"
-
-extern "C"
-{
-#define ZYDIS_STATIC_BUILD
-#include "Zydis.h"
-}
+#include "html_writer.h"
 
 #include <stdio.h>
 #include <inttypes.h>
@@ -52,6 +47,49 @@ extern "C"
 
 static const char *_ArgumentTargetCpu = "-march";
 static const char *_ArgumentIterations = "-iter";
+static const char *_ArgumentTargetCpuAll = "all";
+static const char *_ArgumentIterationsConverge = "converge";
+static const char *_ArgumentCanvas = "-canvas";
+static const char *_ArgumentCache = "-cache";
+static const char *_ArgumentSave = "-save";
+static const char *_ArgumentSymbol = "-symbol";
+static const char *_ArgumentSection = "-section";
+static const char *_ArgumentAddress = "-address";
+static const char *_ArgumentAssembly = "-asm";
+static const char *_ArgumentAssemblyATT = "att";
+static const char *_ArgumentAssemblyIntel = "intel";
+static const char *_ArgumentCorpus = "-corpus";
+static const char *_ArgumentAssumeAlias = "-alias";
+static const char *_ArgumentSweep = "-sweep";
+static const char *_ArgumentSensitivity = "-sensitivity";
+static const char *_ArgumentBounds = "-bounds";
+
+struct PipelineArgument
+{
+  const char *name;
+  uint32_t PipelineOptions::*pValue;
+  const char *description;
+};
+
+static const PipelineArgument PipelineArguments[] =
+{
+  { "-dispatch", &PipelineOptions::dispatchWidth, "instructions dispatched per cycle" },
+  { "-uopqueue", &PipelineOptions::microOpQueueSize, "micro-ops buffered between the decoders & dispatch, 0 doesn't model the queue" },
+  { "-decoders", &PipelineOptions::decodersThroughput, "instructions decoded per cycle, only applies with '-uopqueue', 0 is unlimited" },
+  { "-registers", &PipelineOptions::registerFileSize, "physical registers of the default register file, 0 is unlimited" },
+  { "-loadqueue", &PipelineOptions::loadQueueSize, "load queue entries, 0 uses the load queue of the scheduling model or is unlimited" },
+  { "-storequeue", &PipelineOptions::storeQueueSize, "store queue entries, 0 uses the store queue of the scheduling model or is unlimited" },
+};
+
+static const char *SweepParameterNames[] = { "dispatch", "uopqueue", "decoders", "registers", "loadqueue", "storequeue", "rob", "units" };
+static_assert(std::size(SweepParameterNames) == _SPT_Count);
+
+static const char *ThroughputBoundNames[] = { "port pressure", "loop-carried dependencies", "dispatch width" };
+static_assert(std::size(ThroughputBoundNames) == _TBT_Count);
+
+constexpr size_t ConvergedDisplayedIterations = 8;
+constexpr size_t DefaultWhatIfIterations = 100;
+constexpr uint64_t RawCodeDisplayAddress = 0x140000000; // raw blobs don't have an address, so they're displayed like code in the first section of an executable image.
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -95,580 +133,1251 @@ static_assert(std::size(TargetLookup) == (size_t)CoreArchitecture::_Count);
 
 ////////////////////////////////////////////////////////////////////////////////
 
+struct DependencyReference
+{
+  size_t iteration, instructionIndex; // of the origin, relative to `PortUsageFlow::firstRetainedIteration`.
+  const char *type;
+  size_t cycles;
+
+  inline DependencyReference(const size_t iteration, const size_t instructionIndex, const char *type, const size_t cycles) :
+    iteration(iteration),
+    instructionIndex(instructionIndex),
+    type(type),
+    cycles(cycles)
+  { }
+};
+
 #ifdef _MSC_VER
 #pragma optimize("", off)
 #endif
 
-int main(int argc, char **pArgv)
+// `pSensitivity` is either `nullptr` or indexed by instruction and adds a heat column to the disassembly.
+static void write_html(const char *outFilename, const PortUsageFlow &flow, const size_t loopIterations, const uint64_t codeAddress, const bool canvas, const std::vector<InstructionSensitivity> *pSensitivity = nullptr)
 {
-  if (argc < 3)
-  {
-    puts("Usage: execution-flow-html <RawAssembledBinaryFile> <AnalysisFile.html>");
-    puts("\n\t Optional Parameters:\n");
-    
-    printf("\t\t%s <target cpu core architecture> (defaults to current cpu if not specified)\n", _ArgumentTargetCpu);
-    
-    for (size_t i = 1; i < (size_t)CoreArchitecture::_Count; i++)
-      printf("\t\t\t%s\n", TargetLookup[i]);
+  HtmlWriter writer;
+  FATAL_IF(!writer.open(outFilename), "Failed to create output file. Aborting.");
 
-    puts("");
-    printf("\t\t%s <number of iterations to simulate>\n\t\t\t", _ArgumentIterations);
-
-    return 0;
-  }
+  writer.write(_HtmlDocumentSetup);
+  writer.write("<style>\n:root {--lane-count: ", flow.ports.size(), ";\n}\n</style>");
 
-  const char *inFilename = pArgv[1];
-  const char *outFilename = pArgv[2];
-  CoreArchitecture targetCpu = CoreArchitecture::_CurrentCPU;
-  size_t loopIterations = 8;
+  std::vector<std::vector<DependencyReference>> dependencies(flow.instructionExecutionInfo.size());
 
-  for (size_t argIdx = 3; argIdx < (size_t)argc; /* Iterated manually, as arg sizes are context dependent. */)
+  // Add disassembly.
   {
-    const size_t argsRemaining = (size_t)argc - argIdx;
+    writer.write("<div class=\"disasmcontainer\">\n<div class=\"disasm\">\n");
+
+    // The heat is relative to the instruction with the largest potential speed-up.
+    double maxSpeedUp = 0;
+
+    if (pSensitivity != nullptr)
+      for (const auto &_sensitivity : *pSensitivity)
+        if (_sensitivity.succeeded)
+          maxSpeedUp = std::max(maxSpeedUp, -_sensitivity.bestDelta());
 
-    if (argsRemaining >= 2 && strncmp(_ArgumentIterations, pArgv[argIdx], sizeof(_ArgumentIterations)) == 0)
+    // The instructions have already been decoded & printed while creating the flow.
+    for (size_t instructionIndex = 0; instructionIndex < flow.instructionExecutionInfo.size(); instructionIndex++)
     {
-      loopIterations = strtoull(pArgv[argIdx + 1], nullptr, 10);
+      const auto &instructionInfo = flow.instructionExecutionInfo[instructionIndex];
+      const size_t virtualAddress = instructionInfo.instructionByteOffset;
 
-      if (loopIterations == 0)
+      const char *subVariant = instructionInfo.stallInfo.size() > 0 ? " highlighted" : (instructionInfo.usage.size() == 0 && instructionInfo.clockExecuted - instructionInfo.clockIssued == 0 ? " null" : "");
+
+      writer.write("<div class=\"disasmline\" idx=\"", instructionIndex, "\">");
+
+      if (pSensitivity != nullptr)
       {
-        printf("Invalid iteration count '%s'. Aborting.\n", pArgv[argIdx + 1]);
-        return EXIT_FAILURE;
+        const InstructionSensitivity &sensitivity = (*pSensitivity)[instructionIndex];
+
+        if (!sensitivity.succeeded)
+          writer.write("<span class=\"speedup\" style=\"--heat: 0;\" title=\"Couldn't be analyzed\">?</span>");
+        else
+          writer.write("<span class=\"speedup\" style=\"--heat: ", FixedPoint(maxSpeedUp > 0 ? std::max(-sensitivity.bestDelta(), 0.0) / maxSpeedUp : 0, 3), ";\" title=\"Change in cycles per iteration if this instruction had half the latency (", FixedPoint(sensitivity.halvedLatencyDelta, 2), ") or half the resource cycles (", FixedPoint(sensitivity.halvedResourceCyclesDelta, 2), ")\">", FixedPoint(sensitivity.bestDelta(), 2), "</span>");
       }
 
-      argIdx += 2;
-    }
-    else if (argsRemaining >= 2 && strncmp(_ArgumentTargetCpu, pArgv[argIdx], sizeof(_ArgumentTargetCpu)) == 0)
-    {
-      for (size_t i = 1; i < (size_t)CoreArchitecture::_Count; i++)
+      writer.write("<span class=\"linenum", subVariant, "\">0x", HexValue(codeAddress + virtualAddress, 8), "&emsp;</span><span class=\"asm", subVariant, "\" style=\"--exec: ", instructionInfo.clockExecuted - instructionInfo.clockIssued, ";\">", instructionInfo.disassembly, "</span>");
+
+      size_t dispatched = 0;
+      size_t pending = 0;
+      size_t ready = 0;
+      size_t executing = 0;
+      size_t retiring = 0;
+      const size_t iterations = instructionInfo.perIteration.size();
+
+      // Add Dependency Arrows & Calculate Average Clocks.
       {
-        if (strcmp(TargetLookup[i], pArgv[argIdx + 1]) == 0)
+        for (size_t iteration = 0; iteration < iterations; iteration++)
         {
-          targetCpu = (CoreArchitecture)i;
-          break;
+          const auto &it = instructionInfo.perIteration[iteration];
+         
+          dispatched += it.clockPending - it.clockDispatched;
+          pending += it.clockReady - it.clockPending;
+          ready += it.clockIssued - it.clockReady;
+          executing += it.clockExecuted - it.clockIssued;
+          retiring += it.clockRetired - it.clockExecuted;
+          
+          const auto &regP = it.registerPressure;
+
+          if (regP.selfPressureCycles > 0 && regP.origin.has_value() && regP.origin.value().iterationIndex != (size_t)-1)
+            writer.write("<div class=\"depptr register\" style=\"--e: ", (int64_t)instructionInfo.instructionIndex - regP.origin.value().instructionIndex, "\"></div>");
+
+          const auto &memP = it.memoryPressure;
+
+          if (memP.selfPressureCycles > 0 && memP.origin.has_value() && memP.origin.value().iterationIndex != (size_t)-1)
+            writer.write("<div class=\"depptr memory\" style=\"--e: ", (int64_t)instructionInfo.instructionIndex - memP.origin.value().instructionIndex, "\"></div>");
+
+          const auto &rsrcP = it.resourcePressure;
+
+          for (const auto &_port : rsrcP.associatedResources)
+            if (_port.pressureCycles > 0 && _port.origin.has_value())
+              writer.write("<div class=\"depptr resource\" style=\"--e: ", (int64_t)instructionInfo.instructionIndex - _port.origin.value().instructionIndex, "\"></div>");
         }
       }
 
-      if (targetCpu == CoreArchitecture::_CurrentCPU)
+      writer.write("<div class=\"extra_info\">");
+
+      const double iterationsF = (double)iterations;
+
+      writer.write("<div class=\"uops\">", instructionInfo.uOpCount, " uOps</div>");
+
+      if (pSensitivity != nullptr && (*pSensitivity)[instructionIndex].succeeded)
       {
-        printf("Invalid target cpu core architecture '%s'. Aborting.\n", pArgv[argIdx + 1]);
-        return EXIT_FAILURE;
+        writer.write("<div class=\"cycleInfo\">half latency: ", FixedPoint((*pSensitivity)[instructionIndex].halvedLatencyDelta, 2), " cycles/iteration</div>");
+        writer.write("<div class=\"cycleInfo\">half resource cycles: ", FixedPoint((*pSensitivity)[instructionIndex].halvedResourceCyclesDelta, 2), " cycles/iteration</div>");
       }
+      writer.write("<div class=\"cycleInfo\">dispatched: ", FixedPoint(dispatched / iterationsF, 1), " cycles</div>");
+      writer.write("<div class=\"cycleInfo\">pending: ", FixedPoint(pending / iterationsF, 1), " cycles</div>");
+      writer.write("<div class=\"cycleInfo\">ready: ", FixedPoint(ready / iterationsF, 1), " cycles</div>");
+      writer.write("<div class=\"cycleInfo\">executing: ", FixedPoint(executing / iterationsF, 1), " cycles</div>");
+      writer.write("<div class=\"cycleInfo\">retiring: ", FixedPoint(retiring / iterationsF, 1), " cycles</div>");
 
-      argIdx += 2;
-    }
-    else
-    {
-      printf("Unexpected parameter '%s'. Aborting.\n", pArgv[argIdx]);
-      return EXIT_FAILURE;
-    }
-  }
+      for (size_t j = 0; j < instructionInfo.physicalRegistersObstructedPerRegisterType.size(); j++)
+      {
+        if (instructionInfo.physicalRegistersObstructedPerRegisterType[j] == 0)
+          continue;
 
-  uint8_t *pData = nullptr;
-  size_t fileSize = 0;
+        if (flow.hardwareRegisters.size() > j)
+          writer.write("<div class=\"registers\">", instructionInfo.physicalRegistersObstructedPerRegisterType[j], " ", flow.hardwareRegisters[j].registerTypeName, " registers used (total: ", flow.hardwareRegisters[j].count, ")</div>");
+        else
+          writer.write("<div class=\"registers\">", instructionInfo.physicalRegistersObstructedPerRegisterType[j], " registers used</div>");
+      }
 
-  // Read the input file.
-  {
-    FILE *pInFile = fopen(inFilename, "rb");
-    FATAL_IF(pInFile == nullptr, "Failed to open file. Aborting.");
+      if (instructionInfo.usage.size() != 0)
+      {
+        writer.write("<div class=\"resourcecontainer\">\n");
 
-    fseek(pInFile, 0, SEEK_END);
-    fileSize = _ftelli64(pInFile);
-    FATAL_IF(fileSize == 0, "The specified file is empty. Aborting.");
+        for (const auto &_rsrcIdx : instructionInfo.usage)
+          writer.write("<span class=\"rsrc\" style=\"--lane: ", _rsrcIdx.resourceIndex, "\">", flow.ports[_rsrcIdx.resourceIndex].name, ": ", FixedPoint(_rsrcIdx.pressure, 1), "</span>");
 
-    fseek(pInFile, 0, SEEK_SET);
+        writer.write("</div>\n");
+      }
 
-    pData = reinterpret_cast<uint8_t *>(malloc(fileSize));
-    FATAL_IF(pData == nullptr, "Memory allocation failure. Aborting.");
-    FATAL_IF(fileSize != fread(pData, 1, fileSize, pInFile), "Failed to read file contents. Aborting.");
+      // Add Stall Info.
+      for (const auto &_b : instructionInfo.stallInfo)
+        writer.write("<div class=\"stall\">", _b, "</div>");
 
-    fclose(pInFile);
-  }
+      // Add Dependency Info.
+      {
+        for (size_t iteration = 0; iteration < instructionInfo.perIteration.size(); iteration++)
+        {
+          const auto &regP = instructionInfo.perIteration[iteration].registerPressure;
 
-  // Create flow.
-  PortUsageFlow flow;
-  const bool result = execution_flow_create(pData, fileSize, &flow, targetCpu, loopIterations, 0);
+          if (regP.selfPressureCycles > 0 && regP.origin.has_value() && regP.origin.value().iterationIndex != (size_t)-1)
+            writer.write("<div class=\"dependency register\">", regP.selfPressureCycles, " cycle(s) on <span class=\"press_obj\">", regP.registerName, "</span> <span class=\"loop\">", flow.firstRetainedIteration + iteration, "</span></div>");
 
-  if (!result)
-    puts("Failed to create port usage flow correctly. This could mean that the provided file wasn't valid.");
+          const auto &memP = instructionInfo.perIteration[iteration].memoryPressure;
 
-  printf("%" PRIu64 " Instructions decoded.\n", flow.instructionExecutionInfo.size());
+          if (memP.selfPressureCycles > 0 && memP.origin.has_value() && memP.origin.value().iterationIndex != (size_t)-1)
+            writer.write("<div class=\"dependency memory\">", memP.selfPressureCycles, " cycle(s) on memory <span class=\"loop\">", flow.firstRetainedIteration + iteration, "</span></div>");
 
-  if (flow.instructionExecutionInfo.size() == 0)
-  {
-    puts("Aborting.");
-    return 1;
-  }
+          const auto &rsrcP = instructionInfo.perIteration[iteration].resourcePressure;
 
-  // Write HTML Flow.
-  {
-    FILE *pOutFile = fopen(outFilename, "w");
-    FATAL_IF(pOutFile == nullptr, "Failed to create output file. Aborting.");
+          for (const auto &_port : rsrcP.associatedResources)
+          {
+            if (_port.pressureCycles > 0 && _port.origin.has_value())
+            {
+              if (_port.origin.value().iterationIndex == flow.firstRetainedIteration + iteration)
+                writer.write("<div class=\"dependency resource\">", _port.pressureCycles, " cycle(s) on <span class=\"press_obj\">", _port.resourceName, "</span> <span class=\"loop\" title=\"Loop Index\">", flow.firstRetainedIteration + iteration, "</span></div>");
+              else
+                writer.write("<div class=\"dependency resource\">", _port.pressureCycles, " cycle(s) on <span class=\"press_obj\">", _port.resourceName, "</span> <span class=\"loop\" title=\"Loop Index\">", flow.firstRetainedIteration + iteration, "</span> <span class=\"loop_origin\" title=\"Dependency Origin Loop Index\">", _port.origin.value().iterationIndex, "</span></div>");
+            }
+          }
+        }
+      }
 
-    fputs(_HtmlDocumentSetup, pOutFile);
-    fprintf(pOutFile, "<style>\n:root {--lane-count: %" PRIu64 ";\n}\n</style>", flow.ports.size());
+      writer.write("</div>\n");
 
-    std::vector<std::string> disassemblyLines;
+      // Collect the Dependencies for the hover index.
+      {
+        for (size_t iteration = 0; iteration < instructionInfo.perIteration.size(); iteration++)
+        {
+          const auto &regP = instructionInfo.perIteration[iteration].registerPressure;
 
-    // Add disassembly.
-    {
-      fputs("<div class=\"disasmcontainer\">\n<div class=\"disasm\">\n", pOutFile);
+          if (regP.selfPressureCycles > 0 && regP.origin.has_value() && regP.origin.value().iterationIndex != (size_t)-1 && regP.origin.value().iterationIndex >= flow.firstRetainedIteration)
+            dependencies[instructionIndex].emplace_back(regP.origin.value().iterationIndex - flow.firstRetainedIteration, regP.origin.value().instructionIndex, "reg", regP.selfPressureCycles);
 
-      ZydisDecoder decoder;
-      ZydisFormatter formatter;
+          const auto &memP = instructionInfo.perIteration[iteration].memoryPressure;
 
-      FATAL_IF(!ZYAN_SUCCESS(ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64)), "Failed to initialize disassembler.");
-      FATAL_IF(!ZYAN_SUCCESS(ZydisFormatterInit(&formatter, ZYDIS_FORMATTER_STYLE_INTEL)) || !ZYAN_SUCCESS(ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SEGMENT, ZYAN_TRUE)) || !ZYAN_SUCCESS(ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SIZE, ZYAN_TRUE)), "Failed to initialize instruction formatter.");
+          if (memP.selfPressureCycles > 0 && memP.origin.has_value() && memP.origin.value().iterationIndex != (size_t)-1 && memP.origin.value().iterationIndex >= flow.firstRetainedIteration)
+            dependencies[instructionIndex].emplace_back(memP.origin.value().iterationIndex - flow.firstRetainedIteration, memP.origin.value().instructionIndex, "mem", memP.selfPressureCycles);
 
-      ZydisDecodedInstruction instruction;
-      ZydisDecodedOperand operands[10];
+          const auto &rsrcP = instructionInfo.perIteration[iteration].resourcePressure;
 
-      size_t virtualAddress = 0;
-      constexpr size_t addressDisplayOffset = 0x140000000;
+          for (const auto &_port : rsrcP.associatedResources)
+          {
+            // Streamed flows may no longer contain the origin iteration.
+            if (_port.pressureCycles > 0 && _port.origin.has_value() && _port.origin.value().iterationIndex >= flow.firstRetainedIteration)
+            {
+              const size_t originIteration = _port.origin.value().iterationIndex - flow.firstRetainedIteration;
+              const auto &otherInstruction = flow.instructionExecutionInfo[_port.origin.value().instructionIndex];
 
-      char disasmBuffer[1024] = "";
-      size_t instructionIndex = (size_t)-1;
+              // The lanes of the origin are highlighted regardless of the resource, so only the origin itself matters.
+              if (otherInstruction.perIteration.size() <= originIteration || otherInstruction.perIteration[originIteration].usage.empty())
+                continue;
 
-      while (virtualAddress < fileSize)
-      {
-        ++instructionIndex;
+              dependencies[instructionIndex].emplace_back(originIteration, _port.origin.value().instructionIndex, "rsc", _port.pressureCycles);
+            }
+          }
+        }
+      }
 
-        FATAL_IF(!(ZYAN_SUCCESS(ZydisDecoderDecodeFull(&decoder, pData + virtualAddress, fileSize - virtualAddress, &instruction, operands))), "Invalid Instruction at 0x%" PRIX64 ".", virtualAddress);
-        FATAL_IF(!ZYAN_SUCCESS(ZydisFormatterFormatInstruction(&formatter, &instruction, operands, sizeof(operands) / sizeof(operands[0]), disasmBuffer, sizeof(disasmBuffer), virtualAddress + addressDisplayOffset, nullptr)), "Failed to Format Instruction at 0x%" PRIX64 ".", virtualAddress);
+      writer.write("</div>\n");
+    }
 
-        disassemblyLines.push_back(disasmBuffer);
+    writer.write("<div class=\"stats\">\n");
 
-        const auto &instructionInfo = flow.instructionExecutionInfo[instructionIndex];
+    // The statistics are computed from the columnar layout.
+    FlowColumns convertedColumns;
+    const FlowColumns *pColumns = &flow.columns;
 
-        const char *subVariant = instructionInfo.stallInfo.size() > 0 ? " highlighted" : (instructionInfo.usage.size() == 0 && instructionInfo.clockExecuted - instructionInfo.clockIssued == 0 ? " null" : "");
+    if (flow.columns.iterationCount == 0)
+    {
+      FATAL_IF(!execution_flow_get_columns(flow, &convertedColumns), "Failed to convert flow to columns.");
+      pColumns = &convertedColumns;
+    }
 
-        fprintf(pOutFile, "<div class=\"disasmline\" idx=\"%" PRIu64 "\"><span class=\"linenum%s\">0x%08" PRIX64 "&emsp;</span><span class=\"asm%s\" style=\"--exec: %" PRIu64 ";\">%s</span>", instructionIndex, subVariant, virtualAddress + addressDisplayOffset, subVariant, instructionInfo.clockExecuted - instructionInfo.clockIssued, disasmBuffer);
+    FlowStateStatistics stateStatistics;
+    FATAL_IF(!execution_flow_get_state_statistics(*pColumns, flow.ports.size(), &stateStatistics, loopIterations), "Failed to compute the execution state statistics.");
 
-        size_t dispatched = 0;
-        size_t pending = 0;
-        size_t ready = 0;
-        size_t executing = 0;
-        size_t retiring = 0;
-        const size_t iterations = instructionInfo.perIteration.size();
+    for (size_t i = 0; i < stateStatistics.perIteration.size(); i++)
+    {
+      const ExecutionStateStatistics &stats = stateStatistics.perIteration[i];
 
-        // Add Dependency Arrows & Calculate Average Clocks.
-        {
-          for (size_t iteration = 0; iteration < iterations; iteration++)
-          {
-            const auto &it = instructionInfo.perIteration[iteration];
-           
-            dispatched += it.clockPending - it.clockDispatched;
-            pending += it.clockReady - it.clockPending;
-            ready += it.clockIssued - it.clockReady;
-            executing += it.clockExecuted - it.clockIssued;
-            retiring += it.clockRetired - it.clockExecuted;
-            
-            const auto &regP = it.registerPressure;
+      writer.write("<div class=\"stats_it\"><h2>Iteration ", flow.firstRetainedIteration + i + 1, "</h2>");
 
-            if (regP.selfPressureCycles > 0 && regP.origin.has_value() && regP.origin.value().iterationIndex != (size_t)-1)
-              fprintf(pOutFile, "<div class=\"depptr register\" style=\"--e: %" PRIi64 "\"></div>", (int64_t)instructionInfo.instructionIndex - regP.origin.value().instructionIndex);
+      writer.write("<b>", stats.lastRetire - stats.earliestDispatch, " Cycles (first dispatch -> last retire)</b><b>", stats.lastExecuted - stats.earliestIssued, " Cycles (first issued -> last executed)</b>");
+      writer.write("<i>Dispatched: ", stats.distinctStateCycles[ES_Dispatched], " distinct Cycles <i>(", stats.totalStateCycles[ES_Dispatched], " total)</i></i>");
+      writer.write("<i>Pending: ", stats.distinctStateCycles[ES_Pending], " distinct Cycles <i>(", stats.totalStateCycles[ES_Pending], " total)</i></i>");
+      writer.write("<i>Ready: ", stats.distinctStateCycles[ES_Ready], " distinct Cycles <i>(", stats.totalStateCycles[ES_Ready], " total)</i></i>");
+      writer.write("<i>Executing: ", stats.distinctStateCycles[ES_Executing], " distinct Cycles <i>(", stats.totalStateCycles[ES_Executing], " total)</i></i>");
+      writer.write("<i>Retiring: ", stats.distinctStateCycles[ES_Retiring], " distinct Cycles <i>(", stats.totalStateCycles[ES_Retiring], " total)</i></i>");
 
-            const auto &memP = it.memoryPressure;
+      for (size_t port = 0; port < stats.distinctPortCycles.size(); port++)
+        writer.write("<i class=\"s\" style=\"--h:", FixedPoint((double)stats.distinctPortCycles[port] / (stats.lastExecuted - stats.earliestIssued), 4), ";\">", flow.ports[port].name, ": ", FixedPoint((100.0 * stats.distinctPortCycles[port]) / (stats.lastExecuted - stats.earliestIssued), 2), "%</i>");
 
-            if (memP.selfPressureCycles > 0 && memP.origin.has_value() && memP.origin.value().iterationIndex != (size_t)-1)
-              fprintf(pOutFile, "<div class=\"depptr memory\" style=\"--e: %" PRIi64 "\"></div>", (int64_t)instructionInfo.instructionIndex - memP.origin.value().instructionIndex);
+      writer.write("</div>\n");
+    }
 
-            const auto &rsrcP = it.resourcePressure;
+    writer.write("</div>\n");
 
-            for (const auto &_port : rsrcP.associatedResources)
-              if (_port.pressureCycles > 0 && _port.origin.has_value())
-                fprintf(pOutFile, "<div class=\"depptr resource\" style=\"--e: %" PRIi64 "\"></div>", (int64_t)instructionInfo.instructionIndex - _port.origin.value().instructionIndex);
-          }
-        }
+    // Total
+    {
+      const ExecutionStateStatistics &stats = stateStatistics.total;
+      const double invLoopItsF = 1.0 / (double)loopIterations;
 
-        fputs("<div class=\"extra_info\">", pOutFile);
+      writer.write("<div class=\"stats total\">\n");
 
-        const double iterationsF = (double)iterations;
+      writer.write("<div class=\"stats_it\"><h2>Across all Iterations</h2>");
+      writer.write("<b>", FixedPoint((stats.lastRetire - stats.earliestDispatch) * invLoopItsF, 1), " Cycles (", stats.lastRetire - stats.earliestDispatch, " total) (first dispatch -> last retire)</b><b>", FixedPoint((stats.lastExecuted - stats.earliestIssued) * invLoopItsF, 1), " Cycles (", stats.lastExecuted - stats.earliestIssued, " total) (first issued -> last executed)</b>");
+      writer.write("<i>Dispatched: ", FixedPoint(stats.distinctStateCycles[ES_Dispatched] * invLoopItsF, 1), " avg distinct Cycles <i>(", stats.totalStateCycles[ES_Dispatched], " total)</i></i>");
+      writer.write("<i>Pending: ", FixedPoint(stats.distinctStateCycles[ES_Pending] * invLoopItsF, 1), " avg distinct Cycles <i>(", stats.totalStateCycles[ES_Pending], " total)</i></i>");
+      writer.write("<i>Ready: ", FixedPoint(stats.distinctStateCycles[ES_Ready] * invLoopItsF, 1), " avg distinct Cycles <i>(", stats.totalStateCycles[ES_Ready], " total)</i></i>");
+      writer.write("<i>Executing: ", FixedPoint(stats.distinctStateCycles[ES_Executing] * invLoopItsF, 1), " avg distinct Cycles <i>(", stats.totalStateCycles[ES_Executing], " total)</i></i>");
+      writer.write("<i>Retiring: ", FixedPoint(stats.distinctStateCycles[ES_Retiring] * invLoopItsF, 1), " avg distinct Cycles <i>(", stats.totalStateCycles[ES_Retiring], " total)</i></i>");
 
-        fprintf(pOutFile, "<div class=\"uops\">%" PRIu64 " uOps</div>", instructionInfo.uOpCount);
-        fprintf(pOutFile, "<div class=\"cycleInfo\">dispatched: %3.1f cycles</div>", dispatched / iterationsF);
-        fprintf(pOutFile, "<div class=\"cycleInfo\">pending: %3.1f cycles</div>", pending / iterationsF);
-        fprintf(pOutFile, "<div class=\"cycleInfo\">ready: %3.1f cycles</div>", ready / iterationsF);
-        fprintf(pOutFile, "<div class=\"cycleInfo\">executing: %3.1f cycles</div>", executing / iterationsF);
-        fprintf(pOutFile, "<div class=\"cycleInfo\">retiring: %3.1f cycles</div>", retiring / iterationsF);
+      if (flow.statistics.simulatedCycles > 0)
+      {
+        const double avgInFlightUOps = (double)flow.statistics.totalInFlightUOpCycles / (double)flow.statistics.simulatedCycles;
 
-        for (size_t j = 0; j < instructionInfo.physicalRegistersObstructedPerRegisterType.size(); j++)
-        {
-          if (instructionInfo.physicalRegistersObstructedPerRegisterType[j] == 0)
-            continue;
+        if (flow.statistics.reorderBufferSize > 0)
+          writer.write("<i>In Flight: ", FixedPoint(avgInFlightUOps, 1), " avg uOps <i>(max ", flow.statistics.maxInFlightUOps, ", ", FixedPoint((100.0 * avgInFlightUOps) / flow.statistics.reorderBufferSize, 1), "% of the ", flow.statistics.reorderBufferSize, " entry reorder buffer)</i></i>");
+        else
+          writer.write("<i>In Flight: ", FixedPoint(avgInFlightUOps, 1), " avg uOps <i>(max ", flow.statistics.maxInFlightUOps, ")</i></i>");
+      }
 
-          if (flow.hardwareRegisters.size() > j)
-            fprintf(pOutFile, "<div class=\"registers\">%" PRIu64 " %s registers used (total: %" PRIu64 ")</div>", instructionInfo.physicalRegistersObstructedPerRegisterType[j], flow.hardwareRegisters[j].registerTypeName.c_str(), flow.hardwareRegisters[j].count);
-          else
-            fprintf(pOutFile, "<div class=\"registers\">%" PRIu64 " registers used</div>", instructionInfo.physicalRegistersObstructedPerRegisterType[j]);
-        }
+      for (size_t port = 0; port < stats.distinctPortCycles.size(); port++)
+        writer.write("<i class=\"s\" style=\"--h:", FixedPoint((double)stats.distinctPortCycles[port] / (stats.lastExecuted - stats.earliestIssued), 4), ";\">", flow.ports[port].name, ": ", FixedPoint((100.0 * stats.distinctPortCycles[port]) / (stats.lastExecuted - stats.earliestIssued), 2), "%</i>");
 
-        if (instructionInfo.usage.size() != 0)
-        {
-          fputs("<div class=\"resourcecontainer\">\n", pOutFile);
+      writer.write("</div>\n");
 
-          for (const auto &_rsrcIdx : instructionInfo.usage)
-            fprintf(pOutFile, "<span class=\"rsrc\" style=\"--lane: %" PRIu64 "\">%s: %3.1f</span>", _rsrcIdx.resourceIndex, flow.ports[_rsrcIdx.resourceIndex].name.c_str(), _rsrcIdx.pressure);
+      if (flow.steadyState.simulatedIterations > 0)
+      {
+        writer.write("<div class=\"stats_it\"><h2>Steady State</h2>");
 
-          fputs("</div>\n", pOutFile);
-        }
+        if (flow.steadyState.converged)
+          writer.write("<b>", FixedPoint(flow.steadyState.cyclesPerIteration, 2), " Cycles per Iteration</b><b>", FixedPoint(flow.steadyState.iterationLatency, 1), " Cycles (first dispatch -> last retire)</b><i>", flow.steadyState.warmUpIterations, " warm-up Iterations</i><i>", flow.steadyState.simulatedIterations, " Iterations simulated</i>");
+        else
+          writer.write("<b>Not converged after ", flow.steadyState.simulatedIterations, " Iterations</b><i>", FixedPoint(flow.steadyState.cyclesPerIteration, 2), " Cycles per Iteration</i>");
 
-        // Add Stall Info.
-        for (const auto &_b : instructionInfo.stallInfo)
-          fprintf(pOutFile, "<div class=\"stall\">%s</div>", _b.c_str());
+        writer.write("</div>\n");
+      }
 
-        // Add Dependency Info.
-        {
-          for (size_t iteration = 0; iteration < instructionInfo.perIteration.size(); iteration++)
-          {
-            const auto &regP = instructionInfo.perIteration[iteration].registerPressure;
+      writer.write("</div>\n");
+    }
 
-            if (regP.selfPressureCycles > 0 && regP.origin.has_value() && regP.origin.value().iterationIndex != (size_t)-1)
-              fprintf(pOutFile, "<div class=\"dependency register\">%" PRIu64 " cycle(s) on <span class=\"press_obj\">%s</span> <span class=\"loop\">%" PRIu64 "</span></div>", regP.selfPressureCycles, regP.registerName.c_str(), iteration);
+    writer.write("<div class=\"spacer\"></div></div>\n</div>\n");
+  }
 
-            const auto &memP = instructionInfo.perIteration[iteration].memoryPressure;
+  // Add flow graph.
+  {
+    // Streamed flows don't start at clock 0.
+    size_t firstClock = 0;
 
-            if (memP.selfPressureCycles > 0 && memP.origin.has_value() && memP.origin.value().iterationIndex != (size_t)-1)
-              fprintf(pOutFile, "<div class=\"dependency memory\">%" PRIu64 " cycle(s) on memory <span class=\"loop\">%" PRIu64 "</span></div>", memP.selfPressureCycles, iteration);
+    if (flow.firstRetainedIteration != 0)
+    {
+      firstClock = (size_t)-1;
 
-            const auto &rsrcP = instructionInfo.perIteration[iteration].resourcePressure;
+      for (const auto &_inst : flow.instructionExecutionInfo)
+        for (const auto &_iter : _inst.perIteration)
+          firstClock = std::min(firstClock, _iter.clockDispatched);
+    }
 
-            for (const auto &_port : rsrcP.associatedResources)
-            {
-              if (_port.pressureCycles > 0 && _port.origin.has_value())
-              {
-                if (_port.origin.value().iterationIndex == iteration)
-                  fprintf(pOutFile, "<div class=\"dependency resource\">%" PRIu64 " cycle(s) on <span class=\"press_obj\">%s</span> <span class=\"loop\" title=\"Loop Index\">%" PRIu64 "</span></div>", _port.pressureCycles, _port.resourceName.c_str(), iteration);
-                else
-                  fprintf(pOutFile, "<div class=\"dependency resource\">%" PRIu64 " cycle(s) on <span class=\"press_obj\">%s</span> <span class=\"loop\" title=\"Loop Index\">%" PRIu64 "</span> <span class=\"loop_origin\" title=\"Dependency Origin Loop Index\">%" PRIu64 "</span></div>", _port.pressureCycles, _port.resourceName.c_str(), iteration, _port.origin.value().iterationIndex);
-              }
-            }
-          }
-        }
+    size_t iterationCount = 0;
 
-        fputs("</div>\n<div class=\"dependency_data\">\n", pOutFile);
+    for (const auto &_inst : flow.instructionExecutionInfo)
+      iterationCount = std::max(iterationCount, _inst.perIteration.size());
 
-        // Add Dependency Info.
-        {
-          for (size_t iteration = 0; iteration < instructionInfo.perIteration.size(); iteration++)
-          {
-            const auto &regP = instructionInfo.perIteration[iteration].registerPressure;
+    std::vector<std::vector<size_t>> laneElements;
 
-            if (regP.selfPressureCycles > 0 && regP.origin.has_value() && regP.origin.value().iterationIndex != (size_t)-1)
-              fprintf(pOutFile, "<div class=\"__reg\" cycles=\"%" PRIu64 "\" desc=\"%s\" iteration=\"%" PRIu64 "\" index=\"%" PRIu64 "\"></div>", regP.selfPressureCycles, regP.registerName.c_str(), regP.origin.value().iterationIndex, regP.origin.value().instructionIndex);
+    if (canvas)
+    {
+      // `_HtmlCanvasScript` draws the lanes from the payload below, the graph only reserves the space.
+      size_t lastClock = 0;
 
-            const auto &memP = instructionInfo.perIteration[iteration].memoryPressure;
+      for (const auto &_inst : flow.instructionExecutionInfo)
+        for (const auto &_iter : _inst.perIteration)
+          lastClock = std::max(lastClock, _iter.clockRetired - firstClock);
 
-            if (memP.selfPressureCycles > 0 && memP.origin.has_value() && memP.origin.value().iterationIndex != (size_t)-1)
-              fprintf(pOutFile, "<div class=\"__mem\" cycles=\"%" PRIu64 "\" iteration=\"%" PRIu64 "\" index=\"%" PRIu64 "\"></div>", memP.selfPressureCycles, memP.origin.value().iterationIndex, memP.origin.value().instructionIndex);
+      writer.write("<div class=\"flowgraph\" id=\"flowgraph\"><canvas class=\"flowcanvas\" id=\"flowcanvas\"></canvas><table class=\"flow\"><tr>\n");
 
-            const auto &rsrcP = instructionInfo.perIteration[iteration].resourcePressure;
+      for (const auto &_port : flow.ports)
+        writer.write("<th>", _port.name, "<div class=\"th_float\">", _port.name, "</div></th>\n");
 
-            for (const auto &_port : rsrcP.associatedResources)
-            {
-              if (_port.pressureCycles > 0 && _port.origin.has_value())
-              {
-                const auto other = flow.instructionExecutionInfo[_port.origin.value().instructionIndex].perIteration[_port.origin.value().iterationIndex];
-
-                for (const auto &_otherPort : other.usage)
-                {
-                  // if (flow.ports[_otherPort.resourceIndex].resourceTypeIndex == flow.ports[_port.firstMatchingPortIndex].resourceTypeIndex) // <- this doesn't match anything quite often, as apparently instructions have dependencies on resources they don't use and depend on instructions on that port, that also didn't use this resource.
-                    fprintf(pOutFile, "<div class=\"__rsc\" cycles=\"%" PRIu64 "\" desc=\"%s\" iteration=\"%" PRIu64 "\" index=\"%" PRIu64 "\" lane=\"%" PRIu64 "\"></div>", _port.pressureCycles, _port.resourceName.c_str(), _port.origin.value().iterationIndex, _port.origin.value().instructionIndex, _otherPort.resourceIndex);
-                }
-              }
-            }
-          }
-        }
+      writer.write("</tr>\n</table>\n<div style=\"height: calc(", lastClock, " * 20pt + 100pt);\"></div>\n");
 
-        fputs("\n</div></div>\n", pOutFile);
+      // `flowRecords` holds `flowRecordStride` values per (iteration, instruction) in dispatch order: instruction index, iteration, dispatch clock & the cycles spent dispatched, pending, ready, executing and retiring.
+      writer.write("<script>\nvar flowRecordStride = 8;\nvar flowInstructionLanes = [");
 
-        virtualAddress += instruction.length;
-      }
+      for (const auto &_inst : flow.instructionExecutionInfo)
+      {
+        writer.write(_inst.instructionIndex == 0 ? "[" : ",[");
 
-      fputs("<div class=\"stats\">\n", pOutFile);
+        for (size_t i = 0; i < _inst.usage.size(); i++)
+          writer.write(i == 0 ? "" : ",", _inst.usage[i].resourceIndex);
 
-      size_t allEarliestDispatch = (size_t)-1;
-      size_t allLastRetire = 0;
-      size_t allEarliestIssued = (size_t)-1;
-      size_t allLastExecuted = 0;
-      size_t allTotalDispatched = 0;
-      size_t allTotalPending = 0;
-      size_t allTotalReady = 0;
-      size_t allTotalExecuting = 0;
-      size_t allTotalRetiring = 0;
+        writer.write("]");
+      }
 
-      enum ExecutionState
-      {
-        ES_Dispatched,
-        ES_Pending,
-        ES_Ready,
-        ES_Executing,
-        ES_Retiring,
+      writer.write("];\nvar flowRecords = new Uint32Array([");
 
-        _ES_Count
-      };
+      bool firstRecord = true;
 
-      for (size_t i = 0; i < loopIterations; i++)
+      for (size_t iterationIndex = 0; iterationIndex < iterationCount; iterationIndex++)
       {
-        fprintf(pOutFile, "<div class=\"stats_it\"><h2>Iteration %" PRIu64 "</h2>", i + 1);
-
-        size_t earliestDispatch = (size_t)-1;
-        size_t lastRetire = 0;
-        size_t earliestIssued = (size_t)-1;
-        size_t lastExecuted = 0;
-        size_t totalDispatched = 0;
-        size_t totalPending = 0;
-        size_t totalReady = 0;
-        size_t totalExecuting = 0;
-        size_t totalRetiring = 0;
-
-        // Calculate Averages & Bounds.
-        for (const auto &_instruction : flow.instructionExecutionInfo)
+        for (const auto &_inst : flow.instructionExecutionInfo)
         {
-          if (_instruction.perIteration.size() <= i)
+          if (iterationIndex >= _inst.perIteration.size())
             continue;
 
-          const auto &it = _instruction.perIteration[i];
-
-          earliestDispatch = std::min(earliestDispatch, it.clockDispatched);
-          lastRetire = std::max(lastRetire, it.clockRetired);
+          const LoopInstructionInfo &_iter = _inst.perIteration[iterationIndex];
 
-          earliestIssued = std::min(earliestIssued, it.clockIssued);
-          lastExecuted = std::max(lastExecuted, it.clockExecuted);
-
-          totalDispatched += it.clockPending - it.clockDispatched;
-          totalPending += it.clockReady - it.clockPending;
-          totalReady += it.clockIssued - it.clockReady;
-          totalExecuting += it.clockExecuted - it.clockIssued;
-          totalRetiring += it.clockRetired - it.clockExecuted;
+          writer.write(firstRecord ? "" : ",\n", _inst.instructionIndex, ",", iterationIndex, ",", _iter.clockDispatched - firstClock, ",", _iter.clockPending - _iter.clockDispatched, ",", _iter.clockReady - _iter.clockPending, ",", _iter.clockIssued - _iter.clockReady, ",", _iter.clockExecuted - _iter.clockIssued, ",", _iter.clockRetired - _iter.clockExecuted);
+          firstRecord = false;
         }
+      }
+
+      writer.write("]);\n</script>\n</div>");
+    }
+    else
+    {
+      writer.write("<div class=\"flowgraph\"><table class=\"flow\"><tr>\n");
 
-        allEarliestDispatch = std::min(allEarliestDispatch, earliestDispatch);
-        allLastRetire = std::max(allLastRetire, lastRetire);
+      for (const auto &_port : flow.ports)
+        writer.write("<th>", _port.name, "<div class=\"th_float\">", _port.name, "</div></th>\n");
 
-        allEarliestIssued = std::min(allEarliestIssued, earliestIssued);
-        allLastExecuted = std::max(allLastExecuted, lastExecuted);
+      writer.write("</tr>\n<tr>");
 
-        allTotalDispatched += totalDispatched;
-        allTotalPending += totalPending;
-        allTotalReady += totalReady;
-        allTotalExecuting += totalExecuting;
-        allTotalRetiring += totalRetiring;
+      // The `laneinst` & `instex` elements are emitted in pairs, `laneElements[iteration * instructionCount + instruction]` holds their indices.
+      laneElements.resize(iterationCount * flow.instructionExecutionInfo.size());
+      size_t laneElementIndex = 0;
 
-        std::vector<size_t> perPortUsage(flow.ports.size(), 0);
-        std::vector<bool> portUsed(flow.ports.size(), false);
+      for (size_t i = 0; i < flow.ports.size(); i++)
+      {
+        writer.write("<td>\n");
 
-        // Check Utilization in Bounds.
-        for (size_t cycle = earliestIssued; cycle < lastExecuted; cycle++)
+        for (const auto &_inst : flow.instructionExecutionInfo)
         {
-          for (size_t port = 0; port < portUsed.size(); port++)
-            portUsed[port] = false;
+          size_t iterationIndex = (size_t)-1;
 
-          for (const auto &_instruction : flow.instructionExecutionInfo)
+          for (const auto &_iter : _inst.perIteration)
           {
-            if (_instruction.perIteration.size() <= i)
-              continue;
+            ++iterationIndex;
+
+            for (const auto &_port : _inst.usage)
+            {
+              if (_port.resourceIndex != i)
+                continue;
 
-            const auto &it = _instruction.perIteration[i];
+              writer.write("<div class=\"laneinst\" title=\"", _inst.disassembly, " (Iteration ", flow.firstRetainedIteration + iterationIndex + 1, ")\" idx=\"", _inst.instructionIndex, "\" iter=\"", iterationIndex, "\" lane=\"", i, "\" style=\"--iter: ", iterationIndex, "; --off: ", _iter.clockIssued - firstClock, "; --len: ", _iter.clockExecuted - _iter.clockIssued, "; --idx: ", _inst.instructionIndex, "; --lane: ", i, ";\"></div><div class=\"instex\" idx=\"", _inst.instructionIndex, "\">\n");
+              writer.write("\t<div class=\"inst dispatched\" style=\"--s: ", _iter.clockDispatched - firstClock, "; --l: ", _iter.clockPending - _iter.clockDispatched, ";\"></div>\n");
+              writer.write("\t<div class=\"inst pending\" style=\"--s: ", _iter.clockPending - firstClock, "; --l: ", _iter.clockReady - _iter.clockPending, ";\"></div>\n");
+              writer.write("\t<div class=\"inst ready\" style=\"--s: ", _iter.clockReady - firstClock, "; --l: ", _iter.clockIssued - _iter.clockReady, ";\"></div>\n");
+              writer.write("\t<div class=\"inst executing\" style=\"--s: ", _iter.clockIssued - firstClock, "; --l: ", _iter.clockExecuted - _iter.clockIssued, ";\"></div>\n");
+              writer.write("\t<div class=\"inst retiring\" style=\"--s: ", _iter.clockExecuted - firstClock, "; --l: ", _iter.clockRetired - _iter.clockExecuted, ";\"></div>\n");
+              writer.write("</div>\n");
 
-            // If active: Mark port as used.
-            if (it.clockIssued <= cycle && it.clockExecuted > cycle)
-              for (const auto &_port : _instruction.usage)
-                portUsed[_port.resourceIndex] = true;
+              laneElements[iterationIndex * flow.instructionExecutionInfo.size() + _inst.instructionIndex].push_back(laneElementIndex);
+              laneElementIndex++;
+            }
           }
-
-          for (size_t port = 0; port < portUsed.size(); port++)
-            if (portUsed[port])
-              perPortUsage[port]++;
         }
 
-        bool stateInUse[_ES_Count];
-        size_t stateCyclesInUse[_ES_Count] = {};
+        writer.write("</td>");
+      }
 
-        // Check States in Bounds.
-        for (size_t cycle = earliestDispatch; cycle < lastRetire; cycle++)
-        {
-          for (size_t s = 0; s < _ES_Count; s++)
-            stateInUse[s] = false;
+      writer.write("</tr>\n</table>\n</div>");
+    }
 
-          for (const auto &_instruction : flow.instructionExecutionInfo)
-          {
-            if (_instruction.perIteration.size() <= i)
-              continue;
+    // Hover index: the lane elements of every record (if there are any) & the dependencies of every instruction as `[iteration, index, type, cycles]`.
+    writer.write("<script>\nvar laneRecordInstructions = ", flow.instructionExecutionInfo.size(), ";\nvar laneRecordElements = [");
 
-            const auto &it = _instruction.perIteration[i];
+    for (size_t r = 0; r < laneElements.size(); r++)
+    {
+      writer.write(r == 0 ? "[" : ",[");
 
-            // If active: Mark state as used.
-            {
-              if (it.clockDispatched <= cycle && it.clockPending > cycle)
-                stateInUse[ES_Dispatched] = true;
+      for (size_t i = 0; i < laneElements[r].size(); i++)
+        writer.write(i == 0 ? "" : ",", laneElements[r][i]);
 
-              if (it.clockPending <= cycle && it.clockReady > cycle)
-                stateInUse[ES_Pending] = true;
+      writer.write("]");
+    }
 
-              if (it.clockReady <= cycle && it.clockIssued > cycle)
-                stateInUse[ES_Ready] = true;
+    writer.write("];\nvar instructionDependencies = [");
 
-              if (it.clockIssued <= cycle && it.clockExecuted > cycle)
-                stateInUse[ES_Executing] = true;
+    for (size_t i = 0; i < dependencies.size(); i++)
+    {
+      writer.write(i == 0 ? "\n[" : ",\n[");
 
-              if (it.clockExecuted <= cycle && it.clockRetired > cycle)
-                stateInUse[ES_Retiring] = true;
-            }
-          }
+      for (size_t j = 0; j < dependencies[i].size(); j++)
+        writer.write(j == 0 ? "[" : ",[", dependencies[i][j].iteration, ",", dependencies[i][j].instructionIndex, ",\"", dependencies[i][j].type, "\",", dependencies[i][j].cycles, "]");
 
-          for (size_t s = 0; s < _ES_Count; s++)
-            if (stateInUse[s])
-              stateCyclesInUse[s]++;
-        }
+      writer.write("]");
+    }
 
-        fprintf(pOutFile, "<b>%" PRIu64 " Cycles (first dispatch -> last retire)</b><b>%" PRIu64 " Cycles (first issued -> last executed)</b>", lastRetire - earliestDispatch, lastExecuted - earliestIssued);
-        fprintf(pOutFile, "<i>Dispatched: %" PRIu64 " distinct Cycles <i>(%" PRIu64 " total)</i></i>", stateCyclesInUse[ES_Dispatched], totalDispatched);
-        fprintf(pOutFile, "<i>Pending: %" PRIu64 " distinct Cycles <i>(%" PRIu64 " total)</i></i>", stateCyclesInUse[ES_Pending], totalPending);
-        fprintf(pOutFile, "<i>Ready: %" PRIu64 " distinct Cycles <i>(%" PRIu64 " total)</i></i>", stateCyclesInUse[ES_Ready], totalReady);
-        fprintf(pOutFile, "<i>Executing: %" PRIu64 " distinct Cycles <i>(%" PRIu64 " total)</i></i>", stateCyclesInUse[ES_Executing], totalExecuting);
-        fprintf(pOutFile, "<i>Retiring: %" PRIu64 " distinct Cycles <i>(%" PRIu64 " total)</i></i>", stateCyclesInUse[ES_Retiring], totalRetiring);
+    writer.write("];\n</script>\n");
+  }
 
-        for (size_t i = 0; i < perPortUsage.size(); i++)
-          fprintf(pOutFile, "<i class=\"s\" style=\"--h:%1.4f;\">%s: %4.2f%%</i>", (double)perPortUsage[i] / (lastExecuted - earliestIssued), flow.ports[i].name.c_str(), (100.0 * perPortUsage[i]) / (lastExecuted - earliestIssued));
+  writer.write(_HtmlAfterDocScript);
 
-        fputs("</div>\n", pOutFile);
-      }
+  if (canvas)
+    writer.write(_HtmlCanvasScript);
 
-      fputs("</div>\n", pOutFile);
+  writer.write("</body>\n</html>");
+  FATAL_IF(!writer.close(), "Failed to write output file. Aborting.");
+}
 
-      // Total
-      {
-        std::vector<size_t> perPortUsage(flow.ports.size(), 0);
-        std::vector<bool> portUsed(flow.ports.size(), false);
+static int write_all_targets(const char *outFilename, const uint8_t *pData, const size_t fileSize, const size_t loopIterations, const uint64_t codeAddress, const bool canvas)
+{
+  std::vector<CoreArchitecture> targets;
 
-        // Check Utilization in Bounds.
-        for (size_t cycle = allEarliestIssued; cycle < allLastExecuted; cycle++)
-        {
-          for (size_t port = 0; port < portUsed.size(); port++)
-            portUsed[port] = false;
+  for (size_t i = 1; i < (size_t)CoreArchitecture::_Count; i++)
+    targets.push_back((CoreArchitecture)i);
 
-          for (const auto &_instruction : flow.instructionExecutionInfo)
-          {
-            for (const auto &it : _instruction.perIteration)
-            {
-              // If active: Mark port as used.
-              if (it.clockIssued <= cycle && it.clockExecuted > cycle)
-                for (const auto &_port : _instruction.usage)
-                  portUsed[_port.resourceIndex] = true;
-            }
-          }
+  std::vector<PortUsageFlow> flows(targets.size());
+  std::vector<ArchitectureThroughput> throughput(targets.size());
 
-          for (size_t port = 0; port < portUsed.size(); port++)
-            if (portUsed[port])
-              perPortUsage[port]++;
-        }
+  // Decode once & simulate all architectures concurrently.
+  const bool result = execution_flow_create_for_architectures(pData, fileSize, targets.data(), targets.size(), flows.data(), throughput.data(), loopIterations, 0);
 
-        bool stateInUse[_ES_Count];
-        size_t stateCyclesInUse[_ES_Count] = {};
+  if (!result)
+    puts("Failed to create port usage flow correctly for all architectures. This could mean that the provided file wasn't valid.");
 
-        // Check States in Bounds.
-        for (size_t cycle = allEarliestDispatch; cycle < allLastRetire; cycle++)
-        {
-          for (size_t s = 0; s < _ES_Count; s++)
-            stateInUse[s] = false;
+  if (flows[0].instructionExecutionInfo.size() == 0)
+  {
+    puts("Aborting.");
+    return 1;
+  }
 
-          for (const auto &_instruction : flow.instructionExecutionInfo)
-          {
-            // If active: Mark state as used.
-            for (const auto &it : _instruction.perIteration)
-            {
-              if (it.clockDispatched <= cycle && it.clockPending > cycle)
-                stateInUse[ES_Dispatched] = true;
+  printf("%" PRIu64 " Instructions decoded.\n\n", flows[0].instructionExecutionInfo.size());
+  printf("%-16s %12s %12s %10s %10s\n", "Architecture", "Cycles/Iter", "Total Cycles", "IPC", "uOps/Cycle");
 
-              if (it.clockPending <= cycle && it.clockReady > cycle)
-                stateInUse[ES_Pending] = true;
+  for (const auto &_row : throughput)
+  {
+    if (!_row.succeeded)
+      printf("%-16s %12s\n", TargetLookup[(size_t)_row.arch], "failed");
+    else
+      printf("%-16s %12.2f %12" PRIu64 " %10.2f %10.2f\n", TargetLookup[(size_t)_row.arch], _row.cyclesPerIteration, _row.totalCycles, _row.instructionsPerCycle, _row.uOpsPerCycle);
+  }
 
-              if (it.clockReady <= cycle && it.clockIssued > cycle)
-                stateInUse[ES_Ready] = true;
+  // Write one report per architecture: `file.html` becomes `file.<Architecture>.html`.
+  const char *lastSeparator = std::max(strrchr(outFilename, '/'), strrchr(outFilename, '\\'));
+  const char *extension = strrchr(outFilename, '.');
 
-              if (it.clockIssued <= cycle && it.clockExecuted > cycle)
-                stateInUse[ES_Executing] = true;
+  if (extension == nullptr || extension < lastSeparator)
+    extension = outFilename + strlen(outFilename);
 
-              if (it.clockExecuted <= cycle && it.clockRetired > cycle)
-                stateInUse[ES_Retiring] = true;
-            }
-          }
+  for (size_t i = 0; i < targets.size(); i++)
+  {
+    if (flows[i].instructionExecutionInfo.size() == 0)
+      continue;
 
-          for (size_t s = 0; s < _ES_Count; s++)
-            if (stateInUse[s])
-              stateCyclesInUse[s]++;
-        }
+    const std::string targetFilename = std::string(outFilename, extension) + "." + TargetLookup[(size_t)targets[i]] + extension;
+    write_html(targetFilename.c_str(), flows[i], loopIterations, codeAddress, canvas);
+  }
+
+  return 0;
+}
+
+static std::string get_sweep_parameter_label(const SweepParameter &parameter)
+{
+  if (parameter.type == SPT_ResourceUnits)
+    return std::string(SweepParameterNames[parameter.type]) + ":" + parameter.resourceName;
 
-        const double invLoopItsF = 1.0 / (double)loopIterations;
+  return SweepParameterNames[parameter.type];
+}
 
-        fputs("<div class=\"stats total\">\n", pOutFile);
+// Parses `<name>=<value>,<value>,...` (or `units:<resource>=<value>,...`).
+static bool parse_sweep_parameter(const char *argument, SweepParameter *pParameter)
+{
+  const char *separator = strchr(argument, '=');
 
-        fputs("<div class=\"stats_it\"><h2>Across all Iterations</h2>", pOutFile);
-        fprintf(pOutFile, "<b>%3.1f Cycles (%" PRIu64 " total) (first dispatch -> last retire)</b><b>%3.1f Cycles (%" PRIu64 " total) (first issued -> last executed)</b>", (allLastRetire - allEarliestDispatch) * invLoopItsF, allLastRetire - allEarliestDispatch, (allLastExecuted - allEarliestIssued) * invLoopItsF, allLastExecuted - allEarliestIssued);
-        fprintf(pOutFile, "<i>Dispatched: %3.1f avg distinct Cycles <i>(%" PRIu64 " total)</i></i>", stateCyclesInUse[ES_Dispatched] * invLoopItsF, allTotalDispatched);
-        fprintf(pOutFile, "<i>Pending: %3.1f avg distinct Cycles <i>(%" PRIu64 " total)</i></i>", stateCyclesInUse[ES_Pending] * invLoopItsF, allTotalPending);
-        fprintf(pOutFile, "<i>Ready: %3.1f avg distinct Cycles <i>(%" PRIu64 " total)</i></i>", stateCyclesInUse[ES_Ready] * invLoopItsF, allTotalReady);
-        fprintf(pOutFile, "<i>Executing: %3.1f avg distinct Cycles <i>(%" PRIu64 " total)</i></i>", stateCyclesInUse[ES_Executing] * invLoopItsF, allTotalExecuting);
-        fprintf(pOutFile, "<i>Retiring: %3.1f avg distinct Cycles <i>(%" PRIu64 " total)</i></i>", stateCyclesInUse[ES_Retiring] * invLoopItsF, allTotalRetiring);
+  if (separator == nullptr)
+    return false;
 
-        for (size_t i = 0; i < perPortUsage.size(); i++)
-          fprintf(pOutFile, "<i class=\"s\" style=\"--h:%1.4f;\">%s: %4.2f%%</i>", (double)perPortUsage[i] / (allLastExecuted - allEarliestIssued), flow.ports[i].name.c_str(), (100.0 * perPortUsage[i]) / (allLastExecuted - allEarliestIssued));
+  std::string name(argument, separator);
+  const size_t colon = name.find(':');
 
-        fputs("</div></div>\n", pOutFile);
-      }
+  if (colon != std::string::npos)
+  {
+    pParameter->resourceName = name.substr(colon + 1);
+    name.resize(colon);
+  }
 
-      fputs("<div class=\"spacer\"></div></div>\n</div>\n", pOutFile);
-    }
+  bool found = false;
 
-    // Add flow graph.
+  for (size_t i = 0; i < std::size(SweepParameterNames); i++)
+  {
+    if (name == SweepParameterNames[i])
     {
-      fputs("<div class=\"flowgraph\"><table class=\"flow\"><tr>\n", pOutFile);
+      pParameter->type = (SweepParameterType)i;
+      found = true;
+      break;
+    }
+  }
 
-      for (const auto &_port : flow.ports)
-        fprintf(pOutFile, "<th>%s<div class=\"th_float\">%s</div></th>\n", _port.name.c_str(), _port.name.c_str());
+  if (!found || (pParameter->type == SPT_ResourceUnits) == pParameter->resourceName.empty())
+    return false;
 
-      fputs("</tr>\n<tr>", pOutFile);
+  for (const char *value = separator + 1; ; value++)
+  {
+    char *end = nullptr;
+    const uint64_t number = strtoull(value, &end, 10);
 
-      for (size_t i = 0; i < flow.ports.size(); i++)
-      {
-        fputs("<td>\n", pOutFile);
+    if (end == value || number > UINT32_MAX || (*end != ',' && *end != '\0'))
+      return false;
 
-        for (const auto &_inst : flow.instructionExecutionInfo)
-        {
-          size_t iterationIndex = (size_t)-1;
+    pParameter->values.push_back((uint32_t)number);
 
-          for (const auto &_iter : _inst.perIteration)
-          {
-            ++iterationIndex;
+    if (*end == '\0')
+      return true;
 
-            for (const auto &_port : _inst.usage)
-            {
-              if (_port.resourceIndex != i)
-                continue;
+    value = end;
+  }
+}
 
-              fprintf(pOutFile, "<div class=\"laneinst\" title=\"%s (Iteration %" PRIu64 ")\" idx=\"%" PRIu64 "\" iter=\"%" PRIu64 "\" lane=\"%" PRIu64 "\" style=\"--iter: %" PRIu64 "; --off: %" PRIu64 "; --len: %" PRIu64 "; --idx: %" PRIu64 "; --lane: %" PRIu64 ";\"></div><div class=\"instex\" idx=\"%" PRIu64 "\">\n", disassemblyLines[_inst.instructionIndex].c_str(), iterationIndex + 1, _inst.instructionIndex, iterationIndex, i, iterationIndex, _iter.clockIssued, _iter.clockExecuted - _iter.clockIssued, _inst.instructionIndex, i, _inst.instructionIndex);
-              fprintf(pOutFile, "\t<div class=\"inst dispatched\" style=\"--s: %" PRIu64 "; --l: %" PRIu64 ";\"></div>\n", _iter.clockDispatched, _iter.clockPending - _iter.clockDispatched);
-              fprintf(pOutFile, "\t<div class=\"inst pending\" style=\"--s: %" PRIu64 "; --l: %" PRIu64 ";\"></div>\n", _iter.clockPending, _iter.clockReady - _iter.clockPending);
-              fprintf(pOutFile, "\t<div class=\"inst ready\" style=\"--s: %" PRIu64 "; --l: %" PRIu64 ";\"></div>\n", _iter.clockReady, _iter.clockIssued - _iter.clockReady);
-              fprintf(pOutFile, "\t<div class=\"inst executing\" style=\"--s: %" PRIu64 "; --l: %" PRIu64 ";\"></div>\n", _iter.clockIssued, _iter.clockExecuted - _iter.clockIssued);
-              fprintf(pOutFile, "\t<div class=\"inst retiring\" style=\"--s: %" PRIu64 "; --l: %" PRIu64 ";\"></div>\n", _iter.clockExecuted, _iter.clockRetired - _iter.clockExecuted);
-              fputs("</div>\n", pOutFile);
-            }
-          }
-        }
+static void print_sensitivity(const SensitivityResult &sensitivity, const PortUsageFlow &flow, const uint64_t codeAddress)
+{
+  constexpr size_t MaxListedInstructions = 10;
 
-        fputs("</td>", pOutFile);
-      }
+  if (!sensitivity.baseline.succeeded)
+    return;
 
-      fputs("</tr>\n</table>\n</div>", pOutFile);
-    }
+  printf("\nInstructions that would speed up the loop the most if they were cheaper (baseline: %.2f cycles per iteration):\n", sensitivity.baseline.cyclesPerIteration);
+  printf("%-18s %-40s %14s %14s\n", "Address", "Instruction", "Half Latency", "Half Resource");
 
-    fputs(_HtmlAfterDocScript, pOutFile);
+  for (size_t i = 0; i < sensitivity.instructions.size() && i < MaxListedInstructions; i++)
+  {
+    const InstructionSensitivity &instruction = sensitivity.instructions[i];
 
-    fputs("</body>\n</html>", pOutFile);
-    fclose(pOutFile);
+    if (!instruction.succeeded || instruction.instructionIndex >= flow.instructionExecutionInfo.size())
+      break;
+
+    const InstructionInfo &info = flow.instructionExecutionInfo[instruction.instructionIndex];
+    printf("0x%016" PRIX64 " %-40.40s %14.2f %14.2f\n", codeAddress + info.instructionByteOffset, info.disassembly.c_str(), instruction.halvedLatencyDelta, instruction.halvedResourceCyclesDelta);
+  }
+
+  puts("");
+}
+
+static void print_port_sensitivity(const PortSensitivityResult &sensitivity)
+{
+  if (!sensitivity.baseline.succeeded)
+    return;
+
+  printf("Resources that would speed up the loop the most if they were less contended (baseline: %.2f cycles per iteration):\n", sensitivity.baseline.cyclesPerIteration);
+  printf("%-40s %6s %14s %14s\n", "Resource", "Units", "One More Unit", "Unoccupied");
+
+  for (const auto &_resource : sensitivity.resources)
+  {
+    // Resources that don't affect the throughput aren't worth listing.
+    if (!_resource.succeeded || _resource.bestDelta() >= 0)
+      break;
+
+    printf("%-40.40s %6" PRIu32 " %14.2f %14.2f\n", _resource.resourceName.c_str(), _resource.units, _resource.extraUnitDelta, _resource.zeroOccupancyDelta);
+  }
+
+  puts("");
+}
+
+static int write_sweep(const char *outFilename, const std::vector<SweepParameter> &parameters, const SweepResult &sweep)
+{
+  FILE *pFile = fopen(outFilename, "w");
+  FATAL_IF(pFile == nullptr, "Failed to open output file. Aborting.");
+
+  for (const auto &_parameter : parameters)
+  {
+    const std::string label = get_sweep_parameter_label(_parameter);
+    printf("%16s ", label.c_str());
+    fprintf(pFile, "%s,", label.c_str());
+  }
+
+  printf("%12s %10s\n", "Cycles/Iter", "Speed-up");
+  fputs("cycles_per_iteration,speed_up\n", pFile);
+
+  auto printRow = [&](const std::vector<uint32_t> &values, const ArchitectureThroughput &throughput)
+  {
+    for (const uint32_t _value : values)
+    {
+      printf("%16" PRIu32 " ", _value);
+      fprintf(pFile, "%" PRIu32 ",", _value);
+    }
+
+    if (!throughput.succeeded || throughput.cyclesPerIteration <= 0)
+    {
+      printf("%12s\n", "failed");
+      fputs(",\n", pFile);
+      return;
+    }
+
+    const double speedUp = sweep.baseline.cyclesPerIteration / throughput.cyclesPerIteration;
+    printf("%12.2f %9.3fx\n", throughput.cyclesPerIteration, speedUp);
+    fprintf(pFile, "%f,%f\n", throughput.cyclesPerIteration, speedUp);
+  };
+
+  printRow(sweep.baselineValues, sweep.baseline);
+  puts("");
+
+  // Find the fastest configuration that only changes a single parameter of the baseline (or any, if the grid doesn't contain the baseline values).
+  const SweepConfiguration *pBest = nullptr;
+  const SweepConfiguration *pBestSingle = nullptr;
+  size_t bestSingleParameter = 0;
+
+  for (const auto &_configuration : sweep.configurations)
+  {
+    printRow(_configuration.values, _configuration.throughput);
+
+    if (!_configuration.throughput.succeeded || _configuration.throughput.cyclesPerIteration <= 0)
+      continue;
+
+    if (pBest == nullptr || _configuration.throughput.cyclesPerIteration < pBest->throughput.cyclesPerIteration)
+      pBest = &_configuration;
+
+    size_t changedCount = 0;
+    size_t changedParameter = 0;
+
+    for (size_t i = 0; i < parameters.size(); i++)
+    {
+      if (_configuration.values[i] != sweep.baselineValues[i])
+      {
+        changedCount++;
+        changedParameter = i;
+      }
+    }
+
+    if (changedCount == 1 && (pBestSingle == nullptr || _configuration.throughput.cyclesPerIteration < pBestSingle->throughput.cyclesPerIteration))
+    {
+      pBestSingle = &_configuration;
+      bestSingleParameter = changedParameter;
+    }
+  }
+
+  fclose(pFile);
+
+  if (!sweep.baseline.succeeded || sweep.baseline.cyclesPerIteration <= 0 || pBest == nullptr)
+    return 0;
+
+  puts("");
+
+  if (pBestSingle != nullptr)
+    printf("Largest speed-up from a single parameter: %s %" PRIu32 " -> %" PRIu32 " (%.2f -> %.2f cycles per iteration, %.3fx).\n", get_sweep_parameter_label(parameters[bestSingleParameter]).c_str(), sweep.baselineValues[bestSingleParameter], pBestSingle->values[bestSingleParameter], sweep.baseline.cyclesPerIteration, pBestSingle->throughput.cyclesPerIteration, sweep.baseline.cyclesPerIteration / pBestSingle->throughput.cyclesPerIteration);
+
+  if (pBest != pBestSingle)
+    printf("Largest speed-up of any configuration: %.2f -> %.2f cycles per iteration (%.3fx).\n", sweep.baseline.cyclesPerIteration, pBest->throughput.cyclesPerIteration, sweep.baseline.cyclesPerIteration / pBest->throughput.cyclesPerIteration);
+
+  return 0;
+}
+
+int main(int argc, char **pArgv)
+{
+  if (argc < 3)
+  {
+    puts("Usage: execution-flow-html <RawAssembledBinaryFile> <AnalysisFile.html>");
+    puts("       execution-flow-html <ObjectFileOrExecutable> <AnalysisFile.html> <-symbol | -section | -address ...>");
+    puts("       execution-flow-html <AssemblyFile> <AnalysisFile.html> -asm <att | intel>");
+    printf("       execution-flow-html <ObjectFileOrExecutable | RawAssembledBinaryFile> <CorpusFile> %s [-section ... | -address ...]\n", _ArgumentCorpus);
+    printf("       execution-flow-html <ObjectFileOrExecutable | RawAssembledBinaryFile> <Table.csv> %s <name>=<values> [%s ...] [-symbol ... | -section ... | -address ...]\n", _ArgumentSweep, _ArgumentSweep);
+    puts("       execution-flow-html <SavedFlowFile> <AnalysisFile.html> (renders a flow written with '-save' without simulating it again)");
+    puts("\n\t Code Selection (reads an ELF, COFF or Mach-O file instead of raw bytes):\n");
+    printf("\t\t%s <symbol name>\n", _ArgumentSymbol);
+    printf("\t\t%s <section name> <offset> <length> (a length of 0 selects the rest of the section)\n", _ArgumentSection);
+    printf("\t\t%s <first address> <end address> (virtual addresses, the end is exclusive)\n", _ArgumentAddress);
+
+    puts("\n\t Assembly Input (assembles the text in-process instead of reading raw bytes):\n");
+    printf("\t\t%s %s | %s (not available with '%s %s' or '%s %s')\n", _ArgumentAssembly, _ArgumentAssemblyATT, _ArgumentAssemblyIntel, _ArgumentTargetCpu, _ArgumentTargetCpuAll, _ArgumentIterations, _ArgumentIterationsConverge);
+
+    puts("\n\t Corpus Mode (splits the code into basic blocks and writes one row per block to a columnar file instead of a report):\n");
+    printf("\t\t%s (simulates %" PRIu64 " iterations per block, unless '%s' is specified)\n", _ArgumentCorpus, CorpusOptions().iterations, _ArgumentIterations);
+    printf("\t\t%s (writes analytical lower bounds of the cycles per iteration instead of simulating the blocks)\n", _ArgumentBounds);
+
+    puts("\n\t Sweep Mode (simulates every combination of the given values and writes a table of cycles per iteration as CSV instead of a report):\n");
+    printf("\t\t%s <name>=<value>,<value>,... (can be repeated, simulates %" PRIu64 " iterations per configuration, unless '%s' is specified)\n", _ArgumentSweep, DefaultWhatIfIterations, _ArgumentIterations);
+    printf("\t\t\tnames: ");
+
+    for (size_t i = 0; i < std::size(SweepParameterNames); i++)
+      printf("%s%s", SweepParameterNames[i], i == SPT_ResourceUnits ? ":<resource name, e.g. SKLPort0>\n" : ", ");
+
+    puts("\n\t Optional Parameters:\n");
+    
+    printf("\t\t%s <target cpu core architecture> (defaults to current cpu if not specified)\n", _ArgumentTargetCpu);
+    
+    for (size_t i = 1; i < (size_t)CoreArchitecture::_Count; i++)
+      printf("\t\t\t%s\n", TargetLookup[i]);
+
+    printf("\t\t\t%s (simulates all of the above and writes one report per architecture)\n", _ArgumentTargetCpuAll);
+
+    puts("");
+    printf("\t\t%s <number of iterations to simulate>\n", _ArgumentIterations);
+    printf("\t\t\t%s (simulates until the throughput is stable & displays the last %" PRIu64 " iterations)\n", _ArgumentIterationsConverge, ConvergedDisplayedIterations);
+
+    puts("");
+    printf("\t\t%s (draws the flow graph on a canvas instead of creating elements for every instruction, iteration & port)\n", _ArgumentCanvas);
+
+    puts("");
+    printf("\t\t%s <flow file> (writes the simulated flow to a file, that can be rendered later on)\n", _ArgumentSave);
+    printf("\t\t%s <directory> (reuses the results of previous runs with identical code, architecture & iterations)\n", _ArgumentCache);
+
+    puts("");
+    printf("\t\t%s (prints analytical lower bounds of the cycles per iteration before simulating the code)\n", _ArgumentBounds);
+    printf("\t\t%s (re-simulates the code with every instruction at half the latency / resource cycles, ranks the instructions & adds a heat column to the disassembly,\n\t\t\tas well as with one more unit / no occupancy for every resource)\n", _ArgumentSensitivity);
+
+    puts("");
+    puts("\t\tPipeline limits (default to the scheduling model of the target cpu core architecture):");
+
+    for (const auto &_arg : PipelineArguments)
+      printf("\t\t%s <count> (%s)\n", _arg.name, _arg.description);
+
+    printf("\t\t%s (loads can't pass older stores)\n", _ArgumentAssumeAlias);
+
+    puts("");
+    printf("\t\t'%s', '%s' and the pipeline limits are not available with '%s %s'.\n", _ArgumentSave, _ArgumentCache, _ArgumentTargetCpu, _ArgumentTargetCpuAll);
+
+    return 0;
+  }
+
+  const char *inFilename = pArgv[1];
+  const char *outFilename = pArgv[2];
+  CoreArchitecture targetCpu = CoreArchitecture::_CurrentCPU;
+  bool allTargetCpus = false;
+  bool untilConverged = false;
+  bool canvas = false;
+  const char *cacheDirectory = nullptr;
+  const char *saveFilename = nullptr;
+  const char *symbolName = nullptr;
+  const char *sectionName = nullptr;
+  uint64_t sectionOffset = 0, sectionLength = 0;
+  bool addressRange = false;
+  uint64_t beginAddress = 0, endAddress = 0;
+  bool assemblyInput = false;
+  AssemblySyntax assemblySyntax = AssemblySyntax::ATT;
+  bool corpus = false;
+  size_t loopIterations = 8;
+  bool loopIterationsSpecified = false;
+  uint64_t pipelineValues[std::size(PipelineArguments)];
+  bool assumeAlias = false;
+  std::vector<SweepParameter> sweepParameters;
+  bool analyzeSensitivity = false;
+  bool analyticalBounds = false;
+
+  for (auto &_value : pipelineValues)
+    _value = UINT64_MAX; // not specified.
+
+  for (size_t argIdx = 3; argIdx < (size_t)argc; /* Iterated manually, as arg sizes are context dependent. */)
+  {
+    const size_t argsRemaining = (size_t)argc - argIdx;
+
+    if (argsRemaining >= 2 && strncmp(_ArgumentIterations, pArgv[argIdx], sizeof(_ArgumentIterations)) == 0 && strcmp(_ArgumentIterationsConverge, pArgv[argIdx + 1]) == 0)
+    {
+      untilConverged = true;
+      argIdx += 2;
+    }
+    else if (argsRemaining >= 2 && strncmp(_ArgumentIterations, pArgv[argIdx], sizeof(_ArgumentIterations)) == 0)
+    {
+      loopIterations = strtoull(pArgv[argIdx + 1], nullptr, 10);
+
+      if (loopIterations == 0)
+      {
+        printf("Invalid iteration count '%s'. Aborting.\n", pArgv[argIdx + 1]);
+        return EXIT_FAILURE;
+      }
+
+      loopIterationsSpecified = true;
+      argIdx += 2;
+    }
+    else if (argsRemaining >= 2 && strncmp(_ArgumentTargetCpu, pArgv[argIdx], sizeof(_ArgumentTargetCpu)) == 0 && strcmp(_ArgumentTargetCpuAll, pArgv[argIdx + 1]) == 0)
+    {
+      allTargetCpus = true;
+      argIdx += 2;
+    }
+    else if (argsRemaining >= 2 && strncmp(_ArgumentTargetCpu, pArgv[argIdx], sizeof(_ArgumentTargetCpu)) == 0)
+    {
+      for (size_t i = 1; i < (size_t)CoreArchitecture::_Count; i++)
+      {
+        if (strcmp(TargetLookup[i], pArgv[argIdx + 1]) == 0)
+        {
+          targetCpu = (CoreArchitecture)i;
+          break;
+        }
+      }
+
+      if (targetCpu == CoreArchitecture::_CurrentCPU)
+      {
+        printf("Invalid target cpu core architecture '%s'. Aborting.\n", pArgv[argIdx + 1]);
+        return EXIT_FAILURE;
+      }
+
+      argIdx += 2;
+    }
+    else if (strcmp(_ArgumentCanvas, pArgv[argIdx]) == 0)
+    {
+      canvas = true;
+      argIdx++;
+    }
+    else if (strcmp(_ArgumentCorpus, pArgv[argIdx]) == 0)
+    {
+      corpus = true;
+      argIdx++;
+    }
+    else if (argsRemaining >= 2 && strcmp(_ArgumentSweep, pArgv[argIdx]) == 0)
+    {
+      SweepParameter parameter;
+
+      if (!parse_sweep_parameter(pArgv[argIdx + 1], &parameter))
+      {
+        printf("Invalid sweep parameter '%s'. Aborting.\n", pArgv[argIdx + 1]);
+        return EXIT_FAILURE;
+      }
+
+      sweepParameters.push_back(parameter);
+      argIdx += 2;
+    }
+    else if (strcmp(_ArgumentSensitivity, pArgv[argIdx]) == 0)
+    {
+      analyzeSensitivity = true;
+      argIdx++;
+    }
+    else if (strcmp(_ArgumentBounds, pArgv[argIdx]) == 0)
+    {
+      analyticalBounds = true;
+      argIdx++;
+    }
+    else if (strcmp(_ArgumentAssumeAlias, pArgv[argIdx]) == 0)
+    {
+      assumeAlias = true;
+      argIdx++;
+    }
+    else if (argsRemaining >= 2 && strcmp(_ArgumentCache, pArgv[argIdx]) == 0)
+    {
+      cacheDirectory = pArgv[argIdx + 1];
+      argIdx += 2;
+    }
+    else if (argsRemaining >= 2 && strcmp(_ArgumentSave, pArgv[argIdx]) == 0)
+    {
+      saveFilename = pArgv[argIdx + 1];
+      argIdx += 2;
+    }
+    else if (argsRemaining >= 2 && strcmp(_ArgumentSymbol, pArgv[argIdx]) == 0)
+    {
+      symbolName = pArgv[argIdx + 1];
+      argIdx += 2;
+    }
+    else if (argsRemaining >= 4 && strcmp(_ArgumentSection, pArgv[argIdx]) == 0)
+    {
+      sectionName = pArgv[argIdx + 1];
+      sectionOffset = strtoull(pArgv[argIdx + 2], nullptr, 0);
+      sectionLength = strtoull(pArgv[argIdx + 3], nullptr, 0);
+      argIdx += 4;
+    }
+    else if (argsRemaining >= 2 && strcmp(_ArgumentAssembly, pArgv[argIdx]) == 0)
+    {
+      assemblyInput = true;
+
+      if (strcmp(_ArgumentAssemblyATT, pArgv[argIdx + 1]) == 0)
+      {
+        assemblySyntax = AssemblySyntax::ATT;
+      }
+      else if (strcmp(_ArgumentAssemblyIntel, pArgv[argIdx + 1]) == 0)
+      {
+        assemblySyntax = AssemblySyntax::Intel;
+      }
+      else
+      {
+        printf("Invalid assembly syntax '%s'. Aborting.\n", pArgv[argIdx + 1]);
+        return EXIT_FAILURE;
+      }
+
+      argIdx += 2;
+    }
+    else if (argsRemaining >= 3 && strcmp(_ArgumentAddress, pArgv[argIdx]) == 0)
+    {
+      addressRange = true;
+      beginAddress = strtoull(pArgv[argIdx + 1], nullptr, 0);
+      endAddress = strtoull(pArgv[argIdx + 2], nullptr, 0);
+      argIdx += 3;
+    }
+    else
+    {
+      bool found = false;
+
+      for (size_t i = 0; i < std::size(PipelineArguments); i++)
+      {
+        if (argsRemaining >= 2 && strcmp(PipelineArguments[i].name, pArgv[argIdx]) == 0)
+        {
+          char *end = nullptr;
+          pipelineValues[i] = strtoull(pArgv[argIdx + 1], &end, 10);
+
+          if (end == pArgv[argIdx + 1] || *end != '\0' || pipelineValues[i] > UINT32_MAX || (PipelineArguments[i].pValue == &PipelineOptions::dispatchWidth && pipelineValues[i] == 0))
+          {
+            printf("Invalid value '%s' for '%s'. Aborting.\n", pArgv[argIdx + 1], PipelineArguments[i].name);
+            return EXIT_FAILURE;
+          }
+
+          found = true;
+          argIdx += 2;
+          break;
+        }
+      }
+
+      if (!found)
+      {
+        printf("Unexpected parameter '%s'. Aborting.\n", pArgv[argIdx]);
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  bool pipelineOverridden = assumeAlias;
+
+  for (const uint64_t _value : pipelineValues)
+    pipelineOverridden |= (_value != UINT64_MAX);
+
+  // Applies the specified pipeline limits on top of the defaults of the scheduling model.
+  auto getPipelineOptions = [&](ExecutionFlowContext *pContext, PipelineOptions *pOptions)
+  {
+    FATAL_IF(!execution_flow_context_get_default_pipeline_options(pContext, pOptions), "Failed to retrieve the pipeline options. Aborting.");
+
+    for (size_t i = 0; i < std::size(PipelineArguments); i++)
+      if (pipelineValues[i] != UINT64_MAX)
+        pOptions->*PipelineArguments[i].pValue = (uint32_t)pipelineValues[i];
+
+    if (assumeAlias)
+      pOptions->assumeNoAlias = false;
+
+    printf("Pipeline: dispatch width %" PRIu32 ", micro-op queue %" PRIu32 ", decoders %" PRIu32 ", register file %" PRIu32 ", load queue %" PRIu32 ", store queue %" PRIu32 "%s (0 is unlimited).\n", pOptions->dispatchWidth, pOptions->microOpQueueSize, pOptions->decodersThroughput, pOptions->registerFileSize, pOptions->loadQueueSize, pOptions->storeQueueSize, pOptions->assumeNoAlias ? "" : ", loads don't pass stores");
+  };
+
+  // Flows that have been saved before are rendered as they are.
+  {
+    FlowFileView *pView = nullptr;
+
+    if (execution_flow_load(inFilename, &pView))
+    {
+      PortUsageFlow flow;
+      const bool result = execution_flow_view_get_flow(pView, &flow);
+      execution_flow_view_destroy(&pView);
+
+      FATAL_IF(!result || flow.instructionExecutionInfo.size() == 0, "Failed to read flow file. Aborting.");
+
+      printf("%" PRIu64 " Instructions loaded.\n", flow.instructionExecutionInfo.size());
+
+      write_html(outFilename, flow, flow.instructionExecutionInfo[0].perIteration.size(), flow.codeAddress.value_or(RawCodeDisplayAddress), canvas);
+
+      return 0;
+    }
+  }
+
+  const uint8_t *pData = nullptr;
+  size_t fileSize = 0;
+  uint64_t codeAddress = RawCodeDisplayAddress;
+  bool codeAddressKnown = false;
+
+  if ((symbolName != nullptr) + (sectionName != nullptr) + addressRange + assemblyInput > 1)
+  {
+    printf("Only one of '%s', '%s', '%s' and '%s' can be specified. Aborting.\n", _ArgumentSymbol, _ArgumentSection, _ArgumentAddress, _ArgumentAssembly);
+    return EXIT_FAILURE;
   }
 
+  if (assemblyInput && (allTargetCpus || untilConverged))
+  {
+    printf("'%s' can't be combined with '%s %s' or '%s %s'. Aborting.\n", _ArgumentAssembly, _ArgumentTargetCpu, _ArgumentTargetCpuAll, _ArgumentIterations, _ArgumentIterationsConverge);
+    return EXIT_FAILURE;
+  }
+
+  if (symbolName != nullptr || sectionName != nullptr || addressRange)
+  {
+    // The object stays mapped until the process exits, as `pData` points into it.
+    ExecutionFlowObject *pObject = nullptr;
+    FATAL_IF(!execution_flow_object_create(&pObject, inFilename), "Failed to open '%s' as an x86-64 object file or executable. Aborting.", inFilename);
+
+    ObjectCodeRange range;
+
+    if (symbolName != nullptr)
+      FATAL_IF(!execution_flow_object_get_symbol(pObject, symbolName, &range), "Failed to find symbol '%s'. Aborting.", symbolName);
+    else if (sectionName != nullptr)
+      FATAL_IF(!execution_flow_object_get_section(pObject, sectionName, sectionOffset, sectionLength, &range), "Failed to select offset %" PRIu64 " (length %" PRIu64 ") of section '%s'. Aborting.", sectionOffset, sectionLength, sectionName);
+    else
+      FATAL_IF(!execution_flow_object_get_address_range(pObject, beginAddress, endAddress, &range), "Failed to find the address range 0x%" PRIX64 " - 0x%" PRIX64 " in a single section. Aborting.", beginAddress, endAddress);
+
+    pData = reinterpret_cast<const uint8_t *>(range.pAssembledBytes);
+    fileSize = range.assembledBytesLength;
+    codeAddress = range.address;
+    codeAddressKnown = true;
+
+    printf("Selected %" PRIu64 " bytes at 0x%" PRIX64 ".\n", fileSize, codeAddress);
+  }
+  else // Read the raw input file (or the assembly text).
+  {
+    FILE *pInFile = fopen(inFilename, "rb");
+    FATAL_IF(pInFile == nullptr, "Failed to open file. Aborting.");
+
+    fseek(pInFile, 0, SEEK_END);
+    fileSize = _ftelli64(pInFile);
+    FATAL_IF(fileSize == 0, "The specified file is empty. Aborting.");
+
+    fseek(pInFile, 0, SEEK_SET);
+
+    uint8_t *pFileData = reinterpret_cast<uint8_t *>(malloc(fileSize));
+    FATAL_IF(pFileData == nullptr, "Memory allocation failure. Aborting.");
+    FATAL_IF(fileSize != fread(pFileData, 1, fileSize, pInFile), "Failed to read file contents. Aborting.");
+
+    pData = pFileData;
+
+    fclose(pInFile);
+  }
+
+  if (sweepParameters.size() > 0 && (corpus || allTargetCpus || untilConverged || assemblyInput || cacheDirectory != nullptr || saveFilename != nullptr || canvas))
+  {
+    printf("'%s' can't be combined with '%s', '%s %s', '%s %s', '%s', '%s', '%s' or '%s'. Aborting.\n", _ArgumentSweep, _ArgumentCorpus, _ArgumentTargetCpu, _ArgumentTargetCpuAll, _ArgumentIterations, _ArgumentIterationsConverge, _ArgumentAssembly, _ArgumentCache, _ArgumentSave, _ArgumentCanvas);
+    return EXIT_FAILURE;
+  }
+
+  if (analyzeSensitivity && (corpus || sweepParameters.size() > 0 || allTargetCpus || assemblyInput))
+  {
+    printf("'%s' can't be combined with '%s', '%s', '%s %s' or '%s'. Aborting.\n", _ArgumentSensitivity, _ArgumentCorpus, _ArgumentSweep, _ArgumentTargetCpu, _ArgumentTargetCpuAll, _ArgumentAssembly);
+    return EXIT_FAILURE;
+  }
+
+  if (analyticalBounds && (sweepParameters.size() > 0 || allTargetCpus || assemblyInput))
+  {
+    printf("'%s' can't be combined with '%s', '%s %s' or '%s'. Aborting.\n", _ArgumentBounds, _ArgumentSweep, _ArgumentTargetCpu, _ArgumentTargetCpuAll, _ArgumentAssembly);
+    return EXIT_FAILURE;
+  }
+
+  if (corpus && (allTargetCpus || untilConverged || assemblyInput || symbolName != nullptr || cacheDirectory != nullptr || saveFilename != nullptr || canvas))
+  {
+    printf("'%s' can only be combined with '%s', '%s', '%s', '%s' and '%s <number>'. Aborting.\n", _ArgumentCorpus, _ArgumentSection, _ArgumentAddress, _ArgumentTargetCpu, _ArgumentBounds, _ArgumentIterations);
+    return EXIT_FAILURE;
+  }
+
+  if (corpus)
+  {
+    CorpusOptions options;
+    PipelineOptions pipelineOptions;
+
+    if (pipelineOverridden)
+    {
+      ExecutionFlowContext *pContext = nullptr;
+      FATAL_IF(!execution_flow_context_create(&pContext, targetCpu), "Failed to create execution flow context. Aborting.");
+      getPipelineOptions(pContext, &pipelineOptions);
+      execution_flow_context_destroy(&pContext);
+
+      options.pPipelineOptions = &pipelineOptions;
+    }
+
+    if (loopIterationsSpecified)
+      options.iterations = loopIterations;
+
+    options.analytical = analyticalBounds;
+
+    CorpusSummary summary;
+    const bool result = execution_flow_analyze_corpus(pData, fileSize, codeAddress, targetCpu, outFilename, options, &summary);
+
+    printf("%" PRIu64 " Blocks analyzed (%" PRIu64 " distinct, %" PRIu64 " failed).\n", summary.blockCount, summary.distinctBlockCount, summary.failedBlockCount);
+
+    if (!result)
+    {
+      printf("Failed to write corpus to '%s'. Aborting.\n", outFilename);
+      return EXIT_FAILURE;
+    }
+
+    return 0;
+  }
+
+  if (allTargetCpus && untilConverged)
+  {
+    printf("'%s %s' can't be combined with '%s %s'. Aborting.\n", _ArgumentTargetCpu, _ArgumentTargetCpuAll, _ArgumentIterations, _ArgumentIterationsConverge);
+    return EXIT_FAILURE;
+  }
+
+  if (allTargetCpus && (cacheDirectory != nullptr || saveFilename != nullptr || pipelineOverridden))
+  {
+    printf("'%s %s' can't be combined with '%s', '%s' or pipeline limits. Aborting.\n", _ArgumentTargetCpu, _ArgumentTargetCpuAll, _ArgumentCache, _ArgumentSave);
+    return EXIT_FAILURE;
+  }
+
+  if (allTargetCpus)
+    return write_all_targets(outFilename, pData, fileSize, loopIterations, codeAddress, canvas);
+
+  // Create flow.
+  PortUsageFlow flow;
+  bool result = false;
+
+  ExecutionFlowContext *pContext = nullptr;
+  FATAL_IF(!execution_flow_context_create(&pContext, targetCpu), "Failed to create execution flow context. Aborting.");
+
+  if (pipelineOverridden)
+  {
+    PipelineOptions pipelineOptions;
+    getPipelineOptions(pContext, &pipelineOptions);
+    FATAL_IF(!execution_flow_context_set_pipeline_options(pContext, pipelineOptions), "Invalid pipeline options. Aborting.");
+  }
+
+  if (sweepParameters.size() > 0)
+  {
+    SweepResult sweep;
+    const bool result = execution_flow_sweep(pContext, pData, fileSize, sweepParameters.data(), sweepParameters.size(), loopIterationsSpecified ? loopIterations : DefaultWhatIfIterations, &sweep);
+    execution_flow_context_destroy(&pContext);
+
+    FATAL_IF(sweep.configurations.size() == 0, "Failed to run the sweep. This could mean that the provided file wasn't valid, that a resource isn't named like in the scheduling model or that a dispatch width, reorder buffer size or unit count was 0. Aborting.");
+
+    if (!result)
+      puts("Failed to simulate all configurations correctly.");
+
+    return write_sweep(outFilename, sweepParameters, sweep);
+  }
+
+  if (analyticalBounds)
+  {
+    ThroughputBounds bounds;
+
+    if (!execution_flow_get_throughput_bounds(pContext, pData, fileSize, &bounds))
+    {
+      puts("Failed to compute the analytical bounds.");
+    }
+    else
+    {
+      printf("Analytical bounds: at least %3.2f cycles per iteration, bound by %s.\n", bounds.cyclesPerIteration, ThroughputBoundNames[bounds.binding]);
+
+      for (size_t i = 0; i < _TBT_Count; i++)
+      {
+        printf("\t%-26s %8.2f", ThroughputBoundNames[i], bounds.bounds[i]);
+
+        if (i == TBT_PortPressure && !bounds.bottleneckPortName.empty())
+          printf(" (%s)", bounds.bottleneckPortName.c_str());
+
+        puts("");
+      }
+    }
+  }
+
+  if (cacheDirectory != nullptr && !execution_flow_context_set_cache_directory(pContext, cacheDirectory))
+    printf("Failed to use cache directory '%s'. Continuing without cache.\n", cacheDirectory);
+
+  if (assemblyInput)
+  {
+    result = execution_flow_create_from_assembly(pContext, reinterpret_cast<const char *>(pData), fileSize, assemblySyntax, &flow, loopIterations, 0);
+  }
+  else if (!untilConverged)
+  {
+    result = execution_flow_create(pContext, pData, fileSize, &flow, loopIterations, 0);
+  }
+  else
+  {
+    result = execution_flow_create_until_converged(pContext, pData, fileSize, &flow, ConvergenceOptions(), ConvergedDisplayedIterations);
+
+    if (flow.steadyState.converged)
+      printf("Converged after %" PRIu64 " iterations (%" PRIu64 " warm-up): %3.2f cycles per iteration, %3.1f cycles latency.\n", flow.steadyState.simulatedIterations, flow.steadyState.warmUpIterations, flow.steadyState.cyclesPerIteration, flow.steadyState.iterationLatency);
+    else
+      printf("Didn't converge after %" PRIu64 " iterations: %3.2f cycles per iteration.\n", flow.steadyState.simulatedIterations, flow.steadyState.cyclesPerIteration);
+
+    if (flow.instructionExecutionInfo.size() > 0)
+      loopIterations = flow.instructionExecutionInfo[0].perIteration.size();
+  }
+
+  // Rank the instructions & resources by how much cheaper versions of them would speed up the loop.
+  std::vector<InstructionSensitivity> sensitivityPerInstruction;
+
+  if (analyzeSensitivity && flow.instructionExecutionInfo.size() > 0)
+  {
+    SensitivityResult sensitivity;
+
+    if (!execution_flow_get_sensitivity(pContext, pData, fileSize, loopIterationsSpecified ? loopIterations : DefaultWhatIfIterations, &sensitivity))
+      puts("Failed to analyze the sensitivity of all instructions.");
+
+    print_sensitivity(sensitivity, flow, codeAddress);
+
+    PortSensitivityResult portSensitivity;
+
+    if (!execution_flow_get_port_sensitivity(pContext, pData, fileSize, loopIterationsSpecified ? loopIterations : DefaultWhatIfIterations, &portSensitivity))
+      puts("Failed to analyze the sensitivity of all resources.");
+
+    print_port_sensitivity(portSensitivity);
+
+    sensitivityPerInstruction.resize(flow.instructionExecutionInfo.size());
+
+    for (const auto &_instruction : sensitivity.instructions)
+      if (_instruction.instructionIndex < sensitivityPerInstruction.size())
+        sensitivityPerInstruction[_instruction.instructionIndex] = _instruction;
+  }
+
+  execution_flow_context_destroy(&pContext);
+
+  if (!result)
+    puts("Failed to create port usage flow correctly. This could mean that the provided file wasn't valid.");
+
+  printf("%" PRIu64 " Instructions decoded.\n", flow.instructionExecutionInfo.size());
+
+  if (flow.instructionExecutionInfo.size() == 0)
+  {
+    puts("Aborting.");
+    return 1;
+  }
+
+  if (codeAddressKnown)
+    flow.codeAddress = codeAddress;
+
+  if (saveFilename != nullptr && !execution_flow_save(flow, saveFilename))
+    printf("Failed to save flow to '%s'.\n", saveFilename);
+
+  // Write HTML Flow.
+  write_html(outFilename, flow, loopIterations, codeAddress, canvas, sensitivityPerInstruction.empty() ? nullptr : &sensitivityPerInstruction);
+
   return 0;
 }
@@ -198,6 +198,15 @@ const char *_HtmlDocumentSetup = R"TEXT(<!DOCTYPE html>
             .flowgraph {
               margin-left: 480pt;
             }
+
+            .flowcanvas {
+              position: fixed;
+              left: 480pt;
+              top: 0;
+              width: calc(100% - 480pt);
+              height: 100%;
+              pointer-events: none;
+            }
             
             .disasm {
               width: 480pt;
@@ -212,6 +221,15 @@ const char *_HtmlDocumentSetup = R"TEXT(<!DOCTYPE html>
             span.linenum {
               color: #444;
             }
+
+            span.speedup {
+              display: inline-block;
+              width: 32pt;
+              margin-right: 4pt;
+              text-align: right;
+              color: #bbb;
+              background: hsla(0deg, 75%, 45%, var(--heat));
+            }
             
             span.asm {
               --exclim: calc(min(var(--exec), 20) / 20);
@@ -457,8 +475,41 @@ const char *_HtmlAfterDocScript = R"SCRIPT(
 </div>
 <script>
 var lines = document.getElementsByClassName("disasmline");
-var inst0 = document.getElementsByClassName("laneinst");
-var inst1 = document.getElementsByClassName("instex");
+var inst0 = Array.from(document.getElementsByClassName("laneinst"));
+var inst1 = Array.from(document.getElementsByClassName("instex"));
+
+// `laneRecordElements` (indices into `inst0` & `inst1` per record) & `instructionDependencies` are emitted by `write_html`.
+var instructionElements = [];
+
+for (var i = 0; i < laneRecordInstructions; i++)
+  instructionElements.push([]);
+
+for (var r = 0; r < laneRecordElements.length; r++)
+  for (var j = 0; j < laneRecordElements[r].length; j++)
+    instructionElements[r % laneRecordInstructions].push(laneRecordElements[r][j]);
+
+function forEachDependentLane(idx, callback) {
+  var deps = instructionDependencies[idx];
+
+  for (var i = 0; i < deps.length; i++) {
+    var elements = laneRecordElements[deps[i][0] * laneRecordInstructions + deps[i][1]];
+
+    if (elements === undefined)
+      continue;
+
+    for (var j = 0; j < elements.length; j++)
+      callback(inst0[elements[j]], deps[i]);
+  }
+}
+
+function getLine(e) {
+  var line = e.target;
+
+  if (line.parentElement.className.startsWith('disasmline'))
+    line = line.parentElement;
+
+  return line;
+}
 
 var clicked = null;
 
@@ -467,68 +518,27 @@ for (var i = 0; i < lines.length; i++) {
     if (clicked != null)
       return;
     
-    var line = e.target;
-
-    if (line.parentElement.className.startsWith('disasmline'))
-      line = line.parentElement;
+    var line = getLine(e);
+    var idx = +line.attributes['idx'].value;
 
-    var chld = line.children;
-    var selc = null;
-    
-    for (var i = 0; i < chld.length; i++)
-      if (chld[i].className == 'dependency_data')
-        selc = chld[i];
-    
-    if (selc != null) {
-      chld = selc.children;
-      
-      for (var i = 0; i < chld.length; i++) {
-        var x = chld[i];
-        
-        for (var j = 0; j < inst0.length; j++) { 
-          var n = inst0[j];
-
-          if (x.attributes['iteration'].value == n.attributes['iter'].value && x.attributes['index'].value == n.attributes['idx'].value) {
-            n.className = "laneinst dependent";
-            n.style.setProperty('--cycles', x.attributes['cycles'].value);
-            
-            if (x.className == '__reg')
-              n.style.setProperty('--type', "'reg'");
-            else if (x.className == '__mem')
-              n.style.setProperty('--type', "'mem'");
-            else if (x.className == '__rsc')
-              n.style.setProperty('--type', "'rsc'");
-            else
-              n.style.setProperty('--type', "'??'");
-          }
-        }
-      }
-    }
+    forEachDependentLane(idx, (n, dep) => {
+      n.className = "laneinst dependent";
+      n.style.setProperty('--cycles', dep[3]);
+      n.style.setProperty('--type', "'" + dep[2] + "'");
+    });
 
     line.className = "disasmline selected";
 
-    var idx = line.attributes['idx'].value;
-    
-    for (var j = 0; j < inst0.length; j++) {
-      if (inst0[j].attributes['idx'].value != idx)
-        continue;
-      
-      inst0[j].className += " selected";
-    }
-    
-    for (var j = 0; j < inst1.length; j++) {
-      if (inst1[j].attributes['idx'].value != idx)
-        continue;
-      
-      inst1[j].className = "instex selected";
+    var elements = instructionElements[idx];
+
+    for (var j = 0; j < elements.length; j++) {
+      inst0[elements[j]].className += " selected";
+      inst1[elements[j]].className = "instex selected";
     }
   };
 
     lines[i].onclick = (e) => {
-      var line = e.target;
-
-      if (line.parentElement.className.startsWith('disasmline'))
-        line = line.parentElement;
+      var line = getLine(e);
       
       if (clicked != line) {
         if (clicked != null) {
@@ -550,52 +560,232 @@ for (var i = 0; i < lines.length; i++) {
     if (clicked != null)
       return;
     
-    var line = e.target;
+    var line = getLine(e);
+    var idx = +line.attributes['idx'].value;
 
-    if (line.parentElement.className.startsWith('disasmline'))
-      line = line.parentElement;
-    
-    var chld = line.children;
-    var selc = null;
-    
-    for (var i = 0; i < chld.length; i++)
-      if (chld[i].className == 'dependency_data')
-        selc = chld[i];
-    
-    if (selc != null) {
-      chld = selc.children;
-      
-      for (var i = 0; i < chld.length; i++) {
-        var x = chld[i];
-        
-        for (var j = 0; j < inst0.length; j++) { 
-          var n = inst0[j];
-
-          if (x.attributes['iteration'].value == n.attributes['iter'].value && x.attributes['index'].value == n.attributes['idx'].value)
-            n.className = "laneinst";
-        }
-      }
-    }
+    forEachDependentLane(idx, (n, dep) => { n.className = "laneinst"; });
 
     line.className = "disasmline";
 
-    var idx = line.attributes['idx'].value;
-    
-    for (var j = 0; j < inst0.length; j++) {
-      if (inst0[j].attributes['idx'].value != idx)
-        continue;
-      
-      inst0[j].className = "laneinst";
+    var elements = instructionElements[idx];
+
+    for (var j = 0; j < elements.length; j++) {
+      inst0[elements[j]].className = "laneinst";
+      inst1[elements[j]].className = "instex";
     }
-    
-    for (var j = 0; j < inst1.length; j++) {
-      if (inst1[j].attributes['idx'].value != idx)
+  };
+}
+</script>
+)SCRIPT";
+
+const char *_HtmlCanvasScript = R"SCRIPT(
+<script>
+// Draws the lanes from `flowRecords` (see `write_html`) instead of one element per lane instance. Only the visible cycles are drawn.
+var flowCanvas = document.getElementById("flowcanvas");
+var flowGraph = document.getElementById("flowgraph");
+var flowHeaders = flowGraph.getElementsByTagName("th");
+var flowContext = flowCanvas.getContext("2d");
+var flowRecordCount = flowRecords.length / flowRecordStride;
+var flowSelected = -1;
+var flowDependents = new Map();
+var flowDrawRequested = false;
+
+const flowPt = 4 / 3;
+const flowStageColors = ["#ffffff2e", "#3c8adbad", "#66ffaaa3", "#fff", "#ffffff26"];
+const flowStageNames = ["dispatched", "pending", "ready", "issued", "executed", "retired"];
+
+// Dispatch & retirement happen in order, but let's not rely on it for the binary searches.
+var flowRecordFirstClock = new Float64Array(flowRecordCount);
+var flowRecordLastClock = new Float64Array(flowRecordCount);
+
+{
+  var lastClock = 0;
+
+  for (var r = 0; r < flowRecordCount; r++) {
+    var clock = flowRecords[r * flowRecordStride + 2];
+
+    for (var s = 0; s < 5; s++)
+      clock += flowRecords[r * flowRecordStride + 3 + s];
+
+    lastClock = Math.max(lastClock, clock);
+    flowRecordLastClock[r] = lastClock;
+  }
+
+  var firstClock = Infinity;
+
+  for (var r = flowRecordCount - 1; r >= 0; r--) {
+    firstClock = Math.min(firstClock, flowRecords[r * flowRecordStride + 2]);
+    flowRecordFirstClock[r] = firstClock;
+  }
+}
+
+function flowLowerBound(values, value) {
+  var lo = 0, hi = values.length;
+
+  while (lo < hi) {
+    var mid = (lo + hi) >> 1;
+
+    if (values[mid] < value)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+function flowDraw() {
+  flowDrawRequested = false;
+
+  var ratio = window.devicePixelRatio || 1;
+  var rect = flowCanvas.getBoundingClientRect();
+
+  if (flowCanvas.width != Math.round(rect.width * ratio) || flowCanvas.height != Math.round(rect.height * ratio)) {
+    flowCanvas.width = Math.round(rect.width * ratio);
+    flowCanvas.height = Math.round(rect.height * ratio);
+  }
+
+  var ctx = flowContext;
+  ctx.setTransform(ratio, 0, 0, ratio, 0, 0);
+  ctx.clearRect(0, 0, rect.width, rect.height);
+
+  var unit = 20 * flowPt;
+  var top = flowGraph.getBoundingClientRect().top - rect.top + 50 * flowPt;
+  var firstCycle = Math.floor(-top / unit);
+  var lastCycle = Math.ceil((rect.height - top) / unit);
+
+  var laneX = [];
+
+  for (var l = 0; l < flowHeaders.length; l++)
+    laneX.push(flowHeaders[l].getBoundingClientRect().left - rect.left);
+
+  var begin = flowLowerBound(flowRecordLastClock, firstCycle);
+  var end = flowLowerBound(flowRecordFirstClock, lastCycle + 1);
+
+  ctx.font = (9 * flowPt) + "px Consolas, monospace";
+  ctx.textBaseline = "middle";
+
+  for (var r = begin; r < end; r++) {
+    var o = r * flowRecordStride;
+    var idx = flowRecords[o];
+    var iter = flowRecords[o + 1];
+    var clocks = [flowRecords[o + 2]];
+
+    for (var s = 0; s < 5; s++)
+      clocks.push(clocks[s] + flowRecords[o + 3 + s]);
+
+    var selected = (idx == flowSelected);
+    var dependent = flowDependents.get(iter + ":" + idx);
+    var lanes = flowInstructionLanes[idx];
+
+    for (var l = 0; l < lanes.length; l++) {
+      var lane = lanes[l];
+      var x = laneX[lane];
+      var y = top + clocks[3] * unit;
+      var h = (clocks[4] - clocks[3]) * unit;
+      var hue = lane * 0.41 * 360 - iter * 0.2 * 360;
+
+      var gradient = ctx.createLinearGradient(0, y, 0, y + h);
+
+      if (dependent !== undefined) {
+        gradient.addColorStop(0, "hsl(" + hue + " 70% 60% / 0.3)");
+        gradient.addColorStop(1, "hsl(" + (hue + 50) + " 40% 50% / 0.1)");
+      } else {
+        gradient.addColorStop(0, "hsl(" + hue + " 50% 50%)");
+        gradient.addColorStop(1, "hsl(" + (hue + 50) + " 30% 40%)");
+      }
+
+      ctx.globalCompositeOperation = "screen";
+      ctx.globalAlpha = (selected || dependent !== undefined) ? 1 : 0.3;
+      ctx.fillStyle = gradient;
+      ctx.beginPath();
+      ctx.roundRect(x, y, 20 * flowPt, h, 10 * flowPt);
+      ctx.fill();
+
+      ctx.globalCompositeOperation = "source-over";
+
+      if (dependent !== undefined) {
+        ctx.setLineDash([2 * flowPt, 2 * flowPt]);
+        ctx.lineWidth = 2 * flowPt;
+        ctx.strokeStyle = "hsl(" + hue + " 70% 50%)";
+        ctx.stroke();
+        ctx.setLineDash([]);
+
+        ctx.fillStyle = "#fff7";
+        ctx.fillText(dependent.toUpperCase(), x + 2 * flowPt, y + 6 * flowPt);
+      } else if (selected) {
+        ctx.lineWidth = flowPt;
+        ctx.strokeStyle = "hsl(" + hue + " 50% 50%)";
+        ctx.stroke();
+      }
+
+      if (!selected)
         continue;
-      
-      inst1[j].className = "instex";
+
+      // The stages of the selected instruction.
+      for (var s = 0; s < 5; s++) {
+        var length = clocks[s + 1] - clocks[s];
+
+        ctx.globalAlpha = 1;
+        ctx.fillStyle = flowStageColors[s];
+        ctx.beginPath();
+        ctx.roundRect(x + 8 * flowPt, top + clocks[s] * unit, 4 * flowPt, length * unit, 5 * flowPt);
+        ctx.fill();
+
+        ctx.globalAlpha = Math.min(1, length);
+        ctx.fillStyle = "#fff";
+        ctx.fillText("◀ " + flowStageNames[s], x + 18 * flowPt, top + clocks[s] * unit);
+
+        if (s == 4)
+          ctx.fillText("◀ " + flowStageNames[5], x + 18 * flowPt, top + clocks[5] * unit);
+      }
     }
-  };
+  }
+
+  ctx.globalAlpha = 1;
+}
+
+function flowRequestDraw() {
+  if (flowDrawRequested)
+    return;
+
+  flowDrawRequested = true;
+  window.requestAnimationFrame(flowDraw);
 }
+
+// Mirrors the selection state of the disassembly lines (including the dependencies) into the canvas.
+function flowUpdateSelection() {
+  flowSelected = -1;
+  flowDependents.clear();
+
+  for (var i = 0; i < lines.length; i++) {
+    if (!lines[i].className.startsWith("disasmline selected"))
+      continue;
+
+    flowSelected = +lines[i].attributes['idx'].value;
+
+    var deps = instructionDependencies[flowSelected];
+
+    for (var j = 0; j < deps.length; j++)
+      flowDependents.set(deps[j][0] + ":" + deps[j][1], deps[j][2]);
+  }
+
+  flowRequestDraw();
+}
+
+for (var i = 0; i < lines.length; i++) {
+  const enter = lines[i].onmouseenter;
+  const leave = lines[i].onmouseleave;
+  const click = lines[i].onclick;
+
+  lines[i].onmouseenter = (e) => { enter(e); flowUpdateSelection(); };
+  lines[i].onmouseleave = (e) => { leave(e); flowUpdateSelection(); };
+  lines[i].onclick = (e) => { click(e); flowUpdateSelection(); };
+}
+
+window.addEventListener("scroll", flowRequestDraw);
+window.addEventListener("resize", flowRequestDraw);
+flowRequestDraw();
 </script>
 )SCRIPT";
 
@@ -0,0 +1,256 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2023, Christoph Stiller. All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation 
+//    and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef html_writer_h__
+#define html_writer_h__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// `printf("%.*f", decimals, value)` without the locale & format string parsing.
+struct FixedPoint
+{
+  double value;
+  uint32_t decimals;
+
+  inline FixedPoint(const double value, const uint32_t decimals) :
+    value(value),
+    decimals(decimals)
+  { }
+};
+
+// `printf("%0*" PRIX64, digits, value)`.
+struct HexValue
+{
+  uint64_t value;
+  uint32_t digits;
+
+  inline HexValue(const uint64_t value, const uint32_t digits) :
+    value(value),
+    digits(digits)
+  { }
+};
+
+// Collects the report in a large buffer and only hands full chunks to `fwrite`, so the `FILE` lock is taken once per chunk instead of once per element.
+// Values are formatted by hand, see `HtmlWriter::write`.
+struct HtmlWriter
+{
+  static constexpr size_t BufferSize = 1024 * 256;
+
+  FILE *pFile = nullptr;
+  std::unique_ptr<char[]> buffer;
+  size_t bufferUsed = 0;
+  bool failed = false;
+
+  inline ~HtmlWriter()
+  {
+    close();
+  }
+
+  inline bool open(const char *filename)
+  {
+    close();
+
+    pFile = fopen(filename, "wb");
+
+    if (pFile == nullptr)
+      return false;
+
+    if (buffer == nullptr)
+      buffer.reset(new char[BufferSize]);
+
+    bufferUsed = 0;
+    failed = false;
+
+    return true;
+  }
+
+  // Returns `false` if anything couldn't be written.
+  inline bool close()
+  {
+    if (pFile == nullptr)
+      return false;
+
+    flush();
+
+    if (fclose(pFile) != 0)
+      failed = true;
+
+    pFile = nullptr;
+
+    return !failed;
+  }
+
+  inline void flush()
+  {
+    if (bufferUsed > 0 && fwrite(buffer.get(), 1, bufferUsed, pFile) != bufferUsed)
+      failed = true;
+
+    bufferUsed = 0;
+  }
+
+  // Appends all arguments. Accepts strings, integers, `FixedPoint` & `HexValue`.
+  template <typename ...TArgs>
+  inline void write(const TArgs &...args)
+  {
+    (append(args), ...);
+  }
+
+private:
+  inline void append(const char *text, const size_t length)
+  {
+    if (bufferUsed + length > BufferSize)
+    {
+      flush();
+
+      // Don't bother copying huge blobs (like the static parts of the document).
+      if (length > BufferSize)
+      {
+        if (fwrite(text, 1, length, pFile) != length)
+          failed = true;
+
+        return;
+      }
+    }
+
+    memcpy(buffer.get() + bufferUsed, text, length);
+    bufferUsed += length;
+  }
+
+  inline void append(const char *text)
+  {
+    append(text, strlen(text));
+  }
+
+  inline void append(const std::string &text)
+  {
+    append(text.c_str(), text.size());
+  }
+
+  template <typename T, typename std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>, int> = 0>
+  inline void append(const T value)
+  {
+    char digits[24];
+    char *pEnd = digits + sizeof(digits);
+    char *pStart = pEnd;
+
+    uint64_t absolute = (uint64_t)value;
+
+    if constexpr (std::is_signed_v<T>)
+      if (value < 0)
+        absolute = 0 - absolute;
+
+    do
+    {
+      *--pStart = (char)('0' + absolute % 10);
+      absolute /= 10;
+    } while (absolute != 0);
+
+    if constexpr (std::is_signed_v<T>)
+      if (value < 0)
+        *--pStart = '-';
+
+    append(pStart, (size_t)(pEnd - pStart));
+  }
+
+  inline void append(const HexValue &hex)
+  {
+    static const char HexDigits[] = "0123456789ABCDEF";
+
+    char digits[16];
+    char *pEnd = digits + sizeof(digits);
+    char *pStart = pEnd;
+    uint64_t value = hex.value;
+
+    do
+    {
+      *--pStart = HexDigits[value & 0xF];
+      value >>= 4;
+    } while (value != 0);
+
+    while (pStart > digits && (size_t)(pEnd - pStart) < hex.digits)
+      *--pStart = '0';
+
+    append(pStart, (size_t)(pEnd - pStart));
+  }
+
+  inline void append(const FixedPoint &fixed)
+  {
+    static const uint64_t PowersOfTen[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+    const uint32_t decimals = fixed.decimals < std::size(PowersOfTen) ? fixed.decimals : (uint32_t)std::size(PowersOfTen) - 1;
+    const double scaled = fabs(fixed.value) * (double)PowersOfTen[decimals] + 0.5;
+
+    // Leave NaN, infinity & values that don't fit into the integer formatting to `snprintf`.
+    if (!(scaled < 1e18))
+    {
+      char text[64];
+      const int length = snprintf(text, sizeof(text), "%.*f", (int)decimals, fixed.value);
+
+      if (length > 0)
+        append(text, (size_t)length < sizeof(text) ? (size_t)length : sizeof(text) - 1);
+
+      return;
+    }
+
+    const uint64_t value = (uint64_t)scaled;
+    const uint64_t integer = value / PowersOfTen[decimals];
+
+    if (fixed.value < 0)
+      append("-", 1);
+
+    append(integer);
+
+    if (decimals == 0)
+      return;
+
+    char fraction[16];
+    fraction[0] = '.';
+
+    uint64_t remainder = value % PowersOfTen[decimals];
+
+    for (uint32_t i = decimals; i > 0; i--)
+    {
+      fraction[i] = (char)('0' + remainder % 10);
+      remainder /= 10;
+    }
+
+    append(fraction, decimals + 1);
+  }
+};
+
+#endif // html_writer_h__
@@ -32,8 +32,11 @@
 #include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <optional>
+#include <initializer_list>
+#include <algorithm>
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -195,30 +198,818 @@ struct LoopInstructionInfo : BasicInstructionInfo
   { }
 };
 
+// Accumulated over all retired iterations, even the ones that are no longer retained in `InstructionInfo::perIteration`.
+struct InstructionStatistics
+{
+  size_t iterations;
+  size_t totalDispatched, totalPending, totalReady, totalExecuting, totalRetiring; // cycles spent in the respective state.
+  size_t minLatency, maxLatency; // dispatched -> retired.
+  size_t stallCount;
+
+  inline InstructionStatistics() :
+    iterations(0),
+    totalDispatched(0),
+    totalPending(0),
+    totalReady(0),
+    totalExecuting(0),
+    totalRetiring(0),
+    minLatency(0),
+    maxLatency(0),
+    stallCount(0)
+  { }
+};
+
 struct InstructionInfo : BasicInstructionInfo
 {
   size_t instructionIndex, instructionByteOffset, uOpCount;
+  size_t instructionLength; // in bytes, as decoded by the LLVM disassembler.
+  uint32_t opcode; // LLVM opcode of the target.
+  std::string disassembly; // intel syntax, printed by the LLVM instruction printer (not filled for `CollectionLevel::Summary`).
   std::vector<std::string> stallInfo;
   std::vector<size_t> physicalRegistersObstructedPerRegisterType;
-  std::vector<LoopInstructionInfo> perIteration;
+  std::vector<LoopInstructionInfo> perIteration; // `perIteration[i]` belongs to iteration `PortUsageFlow::firstRetainedIteration + i`.
+  InstructionStatistics statistics;
 
-  inline InstructionInfo(const size_t instructionIndex, const size_t instructionByteOffset) :
+  inline InstructionInfo(const size_t instructionIndex, const size_t instructionByteOffset, const size_t instructionLength = 0, const uint32_t opcode = 0) :
     BasicInstructionInfo(),
     instructionIndex(instructionIndex),
     instructionByteOffset(instructionByteOffset),
-    uOpCount(0)
+    uOpCount(0),
+    instructionLength(instructionLength),
+    opcode(opcode)
+  { }
+};
+
+// Reasons for dispatch stalls, as reported by the simulated dispatch stage.
+enum StallType
+{
+  ST_RegisterUnavailable, // out of physical registers.
+  ST_RetireTokensUnavailable, // the reorder buffer is full.
+  ST_DispatchGroup, // static restrictions on the dispatch group.
+  ST_SchedulerQueueFull,
+  ST_LoadQueueFull,
+  ST_StoreQueueFull,
+  ST_StructuralHazard,
+
+  _ST_Count
+};
+
+// Accumulated over all retired iterations, even the ones that are no longer retained in `InstructionInfo::perIteration`.
+struct FlowStatistics
+{
+  size_t retiredIterations;
+  size_t firstDispatch, lastRetire, firstIssued, lastExecuted; // absolute clocks, like the ones in `LoopInstructionInfo`.
+  size_t totalUOps;
+  std::vector<double> portPressureCycles; // resource cycles consumed per port (same indices as `PortUsageFlow::ports`).
+  std::vector<size_t> portBusyCycles; // cycles in which at least one issued instruction using the port hasn't been executed yet.
+  size_t stallCounts[_ST_Count]; // dispatch stalls per `StallType`.
+
+  // In-flight occupancy (dispatched, but not retired yet), sampled at the end of every simulated cycle.
+  size_t simulatedCycles;
+  size_t reorderBufferSize; // in uOps, from the scheduling model (0 if the model doesn't specify one).
+  size_t maxInFlightInstructions, maxInFlightUOps;
+  size_t totalInFlightInstructionCycles, totalInFlightUOpCycles; // divide by `simulatedCycles` to get the average occupancy.
+  std::vector<size_t> inFlightUOpHistogram; // `inFlightUOpHistogram[n]` is the number of cycles with `n` uOps in flight.
+
+  inline FlowStatistics() :
+    retiredIterations(0),
+    firstDispatch((size_t)-1),
+    lastRetire(0),
+    firstIssued((size_t)-1),
+    lastExecuted(0),
+    totalUOps(0),
+    stallCounts(),
+    simulatedCycles(0),
+    reorderBufferSize(0),
+    maxInFlightInstructions(0),
+    maxInFlightUOps(0),
+    totalInFlightInstructionCycles(0),
+    totalInFlightUOpCycles(0)
+  { }
+};
+
+struct SteadyStateInfo
+{
+  bool converged;
+  size_t warmUpIterations; // iterations retired before the throughput settled.
+  size_t simulatedIterations;
+  double cyclesPerIteration; // retire -> retire of consecutive iterations.
+  double iterationLatency; // first dispatch -> last retire of a single iteration.
+
+  inline SteadyStateInfo() :
+    converged(false),
+    warmUpIterations(0),
+    simulatedIterations(0),
+    cyclesPerIteration(0),
+    iterationLatency(0)
   { }
 };
 
+struct ConvergenceOptions
+{
+  size_t stableIterations; // the averages over this many iterations have to stay within `tolerance` for another `stableIterations` iterations.
+  double tolerance; // relative to the averages at the beginning of the stable range.
+  size_t maxIterations;
+
+  inline ConvergenceOptions(const size_t stableIterations = 16, const double tolerance = 0.01, const size_t maxIterations = 1024 * 16) :
+    stableIterations(stableIterations),
+    tolerance(tolerance),
+    maxIterations(maxIterations)
+  { }
+};
+
+// Frontend & queue limits of the simulated pipeline. Members that are 0 aren't limited (or, for the micro-op queue, not modelled at all).
+// The register files, the reorder buffer (`MCSchedModel::MicroOpBufferSize`) & the scheduler buffers described by the scheduling model always apply.
+struct PipelineOptions
+{
+  uint32_t dispatchWidth; // instructions dispatched per cycle. Must not be 0.
+  uint32_t microOpQueueSize; // micro-ops buffered between the decoders & dispatch.
+  uint32_t decodersThroughput; // instructions decoded per cycle, only applies if the micro-op queue is modelled.
+  uint32_t registerFileSize; // physical registers of the default register file, in addition to the ones described by the scheduling model.
+  uint32_t loadQueueSize; // 0 falls back to the load queue of the scheduling model (if it describes one).
+  uint32_t storeQueueSize; // 0 falls back to the store queue of the scheduling model (if it describes one).
+  bool assumeNoAlias; // if false, loads can't pass older stores.
+
+  inline PipelineOptions(const uint32_t dispatchWidth = 1, const uint32_t microOpQueueSize = 0, const uint32_t decodersThroughput = 0, const uint32_t registerFileSize = 0, const uint32_t loadQueueSize = 0, const uint32_t storeQueueSize = 0, const bool assumeNoAlias = true) :
+    dispatchWidth(dispatchWidth),
+    microOpQueueSize(microOpQueueSize),
+    decodersThroughput(decodersThroughput),
+    registerFileSize(registerFileSize),
+    loadQueueSize(loadQueueSize),
+    storeQueueSize(storeQueueSize),
+    assumeNoAlias(assumeNoAlias)
+  { }
+};
+
+struct FlowColumnUsage
+{
+  uint32_t portIndex;
+  float pressure;
+
+  inline FlowColumnUsage(const uint32_t portIndex, const float pressure) :
+    portIndex(portIndex),
+    pressure(pressure)
+  { }
+};
+
+struct FlowColumnResourceDependency
+{
+  uint32_t next; // the next dependency of the same record (or `FlowColumns::None`).
+  uint32_t resourceTypeIndex; // `FlowColumns::None` if we don't have the resource / resource type in ports.
+  uint32_t firstMatchingPortIndex;
+  uint32_t nameId; // index into `FlowColumns::names`.
+  uint32_t pressureCycles;
+  uint32_t origin; // record index (or `FlowColumns::None`).
+
+  inline FlowColumnResourceDependency(const uint32_t resourceType, const uint32_t matchingPort, const uint32_t nameId) :
+    next(UINT32_MAX),
+    resourceTypeIndex(resourceType),
+    firstMatchingPortIndex(matchingPort),
+    nameId(nameId),
+    pressureCycles(0),
+    origin(UINT32_MAX)
+  { }
+};
+
+struct CycleInterval
+{
+  uint32_t firstCycle;
+  uint32_t cycleCount;
+
+  inline CycleInterval(const uint32_t firstCycle, const uint32_t cycleCount) :
+    firstCycle(firstCycle),
+    cycleCount(cycleCount)
+  { }
+};
+
+// Run-length encoded cycles in which a port was busy (issued -> executed of any instruction using it), recorded at the end of every simulated cycle.
+struct PortCycleTimeline
+{
+  std::vector<std::vector<CycleInterval>> portBusyIntervals; // per port (same indices as `PortUsageFlow::ports`): sorted, non-overlapping, absolute clocks.
+
+  // Number of cycles in `[firstCycle, endCycle)` in which the port was busy.
+  inline size_t busyCycles(const size_t portIndex, const size_t firstCycle, const size_t endCycle) const
+  {
+    if (portIndex >= portBusyIntervals.size() || endCycle <= firstCycle)
+      return 0;
+
+    const std::vector<CycleInterval> &intervals = portBusyIntervals[portIndex];
+
+    // Skip all intervals that end before `firstCycle`.
+    auto it = std::lower_bound(intervals.begin(), intervals.end(), firstCycle, [](const CycleInterval &interval, const size_t cycle) { return (size_t)interval.firstCycle + interval.cycleCount <= cycle; });
+
+    size_t cycles = 0;
+
+    for (; it != intervals.end() && it->firstCycle < endCycle; ++it)
+      cycles += std::min((size_t)it->firstCycle + it->cycleCount, endCycle) - std::max((size_t)it->firstCycle, firstCycle);
+
+    return cycles;
+  }
+};
+
+// Columnar alternative to `InstructionInfo::perIteration` (see `execution_flow_create_columnar`).
+// Every per-record column is indexed by `iteration * instructionCount + instruction`, clocks are absolute like the ones in `LoopInstructionInfo`.
+struct FlowColumns
+{
+  static constexpr uint32_t None = UINT32_MAX;
+
+  size_t instructionCount, iterationCount;
+
+  std::vector<uint32_t> clockDispatched, clockPending, clockReady, clockIssued, clockExecuted, clockRetired, uOps;
+
+  // `usage[usageBegin[record] .. usageBegin[record] + usageCount[record]]`.
+  std::vector<uint32_t> usageBegin, usageCount;
+  std::vector<FlowColumnUsage> usage;
+
+  std::vector<uint32_t> registerTotalPressureCycles, registerPressureCycles, registerOrigin, registerNameId;
+  std::vector<uint32_t> memoryTotalPressureCycles, memoryPressureCycles, memoryOrigin;
+
+  // Linked through `FlowColumnResourceDependency::next`, as pressure events may add dependencies to records long after they've been issued.
+  std::vector<uint32_t> resourceTotalPressureCycles, resourceDependencyHead;
+  std::vector<FlowColumnResourceDependency> resourceDependencies;
+
+  std::vector<std::string> names; // interned register & resource names.
+
+  inline FlowColumns() :
+    instructionCount(0),
+    iterationCount(0)
+  { }
+
+  inline size_t recordIndex(const size_t iteration, const size_t instruction) const { return iteration * instructionCount + instruction; }
+
+  inline void reset(const size_t instructions, const size_t iterations)
+  {
+    instructionCount = instructions;
+    iterationCount = iterations;
+
+    const size_t recordCount = instructions * iterations;
+
+    for (std::vector<uint32_t> *pColumn : { &clockDispatched, &clockPending, &clockReady, &clockIssued, &clockExecuted, &clockRetired, &uOps, &usageBegin, &usageCount, &registerTotalPressureCycles, &registerPressureCycles, &memoryTotalPressureCycles, &memoryPressureCycles, &resourceTotalPressureCycles })
+      pColumn->assign(recordCount, 0);
+
+    for (std::vector<uint32_t> *pColumn : { &registerOrigin, &registerNameId, &memoryOrigin, &resourceDependencyHead })
+      pColumn->assign(recordCount, None);
+
+    usage.clear();
+    resourceDependencies.clear();
+    names.clear();
+  }
+};
+
+enum ExecutionState
+{
+  ES_Dispatched, // dispatched -> pending
+  ES_Pending, // pending -> ready
+  ES_Ready, // ready -> issued
+  ES_Executing, // issued -> executed
+  ES_Retiring, // executed -> retired
+
+  _ES_Count
+};
+
+struct ExecutionStateStatistics
+{
+  size_t earliestDispatch, lastRetire, earliestIssued, lastExecuted;
+  size_t totalStateCycles[_ES_Count]; // summed over all records, so overlapping cycles are counted more than once.
+  size_t distinctStateCycles[_ES_Count]; // cycles in which at least one record was in the state.
+  std::vector<size_t> distinctPortCycles; // per port: cycles in which at least one issued record using the port hadn't been executed yet.
+
+  inline ExecutionStateStatistics() :
+    earliestDispatch((size_t)-1),
+    lastRetire(0),
+    earliestIssued((size_t)-1),
+    lastExecuted(0),
+    totalStateCycles(),
+    distinctStateCycles()
+  { }
+};
+
+struct FlowStateStatistics
+{
+  std::vector<ExecutionStateStatistics> perIteration; // same indices as the iterations in `FlowColumns`.
+  ExecutionStateStatistics total; // across all of the iterations in `perIteration`.
+};
+
+enum class CollectionLevel
+{
+  Full, // records every iteration of every instruction in `InstructionInfo::perIteration`, including stalls & dependencies.
+  Summary, // only fills `PortUsageFlow::statistics`, `InstructionInfo::statistics` and the fields of the relevant iteration in `InstructionInfo`.
+};
+
 struct PortUsageFlow
 {
   std::vector<ResourceInfo> ports;
   std::vector<HardwareRegisterCount> hardwareRegisters;
   std::vector<InstructionInfo> instructionExecutionInfo;
+  size_t firstRetainedIteration = 0; // only ever non-zero for streamed flows.
+  std::optional<uint64_t> codeAddress; // virtual address of the first instruction, if the code has been selected from an object file. Set by the caller, only stored with the flow.
+  FlowStatistics statistics;
+  SteadyStateInfo steadyState; // only filled by `execution_flow_create_until_converged`.
+  FlowColumns columns; // only filled by `execution_flow_create_columnar`.
+  PortCycleTimeline cycleTimeline; // not filled for `CollectionLevel::Summary`, only covers the retained iterations for streamed flows.
+};
+
+struct ArchitectureThroughput
+{
+  CoreArchitecture arch;
+  bool succeeded;
+  size_t totalCycles; // first dispatch -> last retire across all iterations.
+  size_t uOpsPerIteration;
+  double cyclesPerIteration, instructionsPerCycle, uOpsPerCycle;
+
+  inline ArchitectureThroughput(const CoreArchitecture arch = CoreArchitecture::_CurrentCPU) :
+    arch(arch),
+    succeeded(false),
+    totalCycles(0),
+    uOpsPerIteration(0),
+    cyclesPerIteration(0),
+    instructionsPerCycle(0),
+    uOpsPerCycle(0)
+  { }
+};
+
+enum SweepParameterType
+{
+  SPT_DispatchWidth,
+  SPT_MicroOpQueueSize,
+  SPT_DecodersThroughput,
+  SPT_RegisterFileSize,
+  SPT_LoadQueueSize,
+  SPT_StoreQueueSize,
+  SPT_ReorderBufferSize,
+  SPT_ResourceUnits, // units of the resource named `SweepParameter::resourceName`.
+
+  _SPT_Count,
+};
+
+struct SweepParameter
+{
+  SweepParameterType type;
+  std::string resourceName; // only used by `SPT_ResourceUnits`. The name of a resource of the scheduling model that isn't a group, e.g. "SKLPort0".
+  std::vector<uint32_t> values;
+
+  inline SweepParameter(const SweepParameterType type = SPT_DispatchWidth, const std::vector<uint32_t> &values = {}, const std::string &resourceName = std::string()) :
+    type(type),
+    resourceName(resourceName),
+    values(values)
+  { }
+};
+
+struct SweepConfiguration
+{
+  std::vector<uint32_t> values; // one per `SweepParameter`.
+  ArchitectureThroughput throughput;
+};
+
+struct InstructionSensitivity
+{
+  size_t instructionIndex;
+  bool succeeded;
+  double halvedLatencyDelta; // change of the cycles per iteration if the latency of the instruction was halved (rounded up, like the resource cycles). Negative values are speed-ups.
+  double halvedResourceCyclesDelta; // change of the cycles per iteration if the instruction occupied its resources for half as many cycles (rounded up).
+
+  inline InstructionSensitivity(const size_t instructionIndex = 0) :
+    instructionIndex(instructionIndex),
+    succeeded(false),
+    halvedLatencyDelta(0),
+    halvedResourceCyclesDelta(0)
+  { }
+
+  inline double bestDelta() const { return halvedLatencyDelta < halvedResourceCyclesDelta ? halvedLatencyDelta : halvedResourceCyclesDelta; }
+};
+
+struct SensitivityResult
+{
+  ArchitectureThroughput baseline;
+  std::vector<InstructionSensitivity> instructions; // ranked by `bestDelta`: the largest speed-up first, instructions that couldn't be analyzed last.
+};
+
+struct PortSensitivity
+{
+  size_t resourceTypeIndex; // the `ResourceInfo::resourceTypeIndex` of the ports of this resource.
+  std::string resourceName; // as named by the scheduling model, e.g. "SKLPort5" (can be used with `SPT_ResourceUnits`).
+  uint32_t units;
+  bool succeeded;
+  double extraUnitDelta; // change of the cycles per iteration if the resource had one more unit. Negative values are speed-ups.
+  double zeroOccupancyDelta; // change of the cycles per iteration if no instruction occupied the resource directly (uops that can use any unit of a group containing it still may).
+
+  inline PortSensitivity(const size_t resourceTypeIndex = 0, const std::string &resourceName = std::string(), const uint32_t units = 0) :
+    resourceTypeIndex(resourceTypeIndex),
+    resourceName(resourceName),
+    units(units),
+    succeeded(false),
+    extraUnitDelta(0),
+    zeroOccupancyDelta(0)
+  { }
+
+  inline double bestDelta() const { return extraUnitDelta < zeroOccupancyDelta ? extraUnitDelta : zeroOccupancyDelta; }
+};
+
+struct PortSensitivityResult
+{
+  ArchitectureThroughput baseline;
+  std::vector<PortSensitivity> resources; // ranked by `bestDelta`: the largest speed-up first, resources that couldn't be analyzed last.
+};
+
+enum ThroughputBoundType
+{
+  TBT_PortPressure, // resource cycles of the busiest port if the uops are assigned to the ports optimally.
+  TBT_LoopCarriedDependency, // latency of the register dependency chains carried from one iteration to the next.
+  TBT_DispatchWidth, // uops per iteration divided by the dispatch width.
+
+  _TBT_Count,
+};
+
+// Lower bounds of the cycles per iteration, derived from the scheduling model without simulating the code.
+struct ThroughputBounds
+{
+  bool succeeded;
+  double bounds[_TBT_Count];
+  double cyclesPerIteration; // the largest of the bounds.
+  ThroughputBoundType binding; // the bound that `cyclesPerIteration` is taken from.
+  size_t instructionCount, uOpsPerIteration;
+  std::vector<double> portPressureCycles; // resource cycles per iteration of the optimal assignment (same indices as `PortUsageFlow::ports`).
+  size_t bottleneckPort; // the port with the most resource cycles or `(size_t)-1`.
+  std::string bottleneckPortName; // `ResourceInfo::name` of `bottleneckPort`.
+
+  inline ThroughputBounds() :
+    succeeded(false),
+    bounds(),
+    cyclesPerIteration(0),
+    binding(TBT_PortPressure),
+    instructionCount(0),
+    uOpsPerIteration(0),
+    bottleneckPort((size_t)-1)
+  { }
+};
+
+struct SweepResult
+{
+  std::vector<uint32_t> baselineValues; // the values of the context (see `execution_flow_context_get_pipeline_options`) & its scheduling model, one per `SweepParameter`.
+  ArchitectureThroughput baseline;
+  std::vector<SweepConfiguration> configurations; // every combination of the parameter values, the last parameter changes the fastest.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Flat, versioned, little-endian file format for `PortUsageFlow` (see `execution_flow_save`). Every section is an 8 byte aligned array of one of the structs below, located through `FlowFileHeader::sections`.
+// Ranges & strings reference other sections by element index, so the file can be used straight from a memory map (see `FlowFileView`).
+
+constexpr char FlowFileMagic[8] = { 'E', 'X', 'F', 'L', 'O', 'W', '\r', '\n' };
+constexpr uint32_t FlowFileVersion = 3;
+constexpr uint64_t FlowFileNone = UINT64_MAX;
+
+enum FlowFileSectionType
+{
+  FFS_Strings, // `char`, not zero terminated.
+  FFS_Ports, // `FlowFilePort`
+  FFS_Registers, // `FlowFileRegister`
+  FFS_Instructions, // `FlowFileInstruction`
+  FFS_Records, // `FlowFileRecord`, `FlowFileInstruction::records` of every instruction.
+  FFS_Usage, // `FlowFileUsage`
+  FFS_ResourceDependencies, // `FlowFileResourceDependency`
+  FFS_StallInfo, // `FlowFileString`
+  FFS_ObstructedRegisters, // `uint64_t`
+  FFS_PortPressureCycles, // `double` per port.
+  FFS_PortBusyCycles, // `uint64_t` per port.
+  FFS_InFlightUOpHistogram, // `uint64_t`
+  FFS_TimelineOffsets, // `uint64_t` per port + 1, the busy intervals of port `i` are `[offsets[i], offsets[i + 1])`.
+  FFS_TimelineIntervals, // `FlowFileInterval`
+
+  _FFS_Count
+};
+
+struct FlowFileSection
+{
+  uint64_t offset; // in bytes, from the beginning of the file.
+  uint64_t count; // in elements.
+};
+
+struct FlowFileString
+{
+  uint32_t offset, length; // into `FFS_Strings`.
+};
+
+struct FlowFileRange
+{
+  uint64_t begin, count; // elements of the referenced section.
+};
+
+struct FlowFileOrigin
+{
+  uint64_t iterationIndex, instructionIndex; // `instructionIndex` is `FlowFileNone` if there's no origin.
+};
+
+struct FlowFileClocks
+{
+  uint64_t dispatched, pending, ready, issued, executed, retired, uOps;
+};
+
+struct FlowFilePort
+{
+  uint64_t resourceTypeIndex, resourceTypeSubIndex;
+  FlowFileString name;
+};
+
+struct FlowFileRegister
+{
+  FlowFileString name;
+  uint64_t count;
+};
+
+struct FlowFileUsage
+{
+  uint64_t portIndex;
+  double pressure;
+};
+
+struct FlowFileResourceDependency
+{
+  uint64_t resourceTypeIndex, firstMatchingPortIndex;
+  FlowFileString name;
+  uint64_t pressureCycles;
+  FlowFileOrigin origin;
+};
+
+struct FlowFileInterval
+{
+  uint32_t firstCycle, cycleCount;
+};
+
+struct FlowFileInstruction
+{
+  uint64_t instructionIndex, byteOffset, length, uOpCount;
+  uint32_t opcode, _reserved;
+  FlowFileString disassembly;
+  FlowFileClocks clocks; // of the relevant iteration.
+  FlowFileRange usage; // `FFS_Usage` of the relevant iteration.
+  FlowFileRange stallInfo; // `FFS_StallInfo`
+  FlowFileRange obstructedRegisters; // `FFS_ObstructedRegisters`
+  FlowFileRange records; // `FFS_Records`, one per retained iteration.
+
+  // `InstructionStatistics`
+  uint64_t iterations, totalDispatched, totalPending, totalReady, totalExecuting, totalRetiring, minLatency, maxLatency, stallCount;
+};
+
+struct FlowFileRecord
+{
+  FlowFileClocks clocks;
+  FlowFileRange usage; // `FFS_Usage`
+  uint64_t totalPressureCycles;
+
+  uint64_t registerTotalPressureCycles, registerSelfPressureCycles;
+  FlowFileOrigin registerOrigin;
+  FlowFileString registerName;
+
+  uint64_t memoryTotalPressureCycles, memorySelfPressureCycles;
+  FlowFileOrigin memoryOrigin;
+
+  uint64_t resourceTotalPressureCycles;
+  FlowFileRange resourceDependencies; // `FFS_ResourceDependencies`
+};
+
+struct FlowFileHeader
+{
+  char magic[sizeof(FlowFileMagic)];
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t fileSize;
+  uint64_t key; // identifies the inputs the flow was created from (used by the result cache), 0 if unknown.
+  uint64_t firstRetainedIteration;
+  uint64_t codeAddress; // `FlowFileNone` if unknown.
+
+  // `FlowStatistics`
+  uint64_t retiredIterations, firstDispatch, lastRetire, firstIssued, lastExecuted, totalUOps;
+  uint64_t simulatedCycles, reorderBufferSize, maxInFlightInstructions, maxInFlightUOps, totalInFlightInstructionCycles, totalInFlightUOpCycles;
+  uint64_t stallCounts[_ST_Count];
+
+  // `SteadyStateInfo`
+  uint64_t converged, warmUpIterations, simulatedIterations;
+  double cyclesPerIteration, iterationLatency;
+
+  FlowFileSection sections[_FFS_Count];
+};
+
+// Read-only view into a flow file. All ranges, strings & timeline offsets have been validated when the view was created, so they can be accessed without any further checks.
+// Records are stored per instruction: `pRecords[pInstructions[i].records.begin + n]` is iteration `pHeader->firstRetainedIteration + n` of instruction `i`.
+struct FlowFileView
+{
+  const FlowFileHeader *pHeader = nullptr;
+  const char *pStrings = nullptr;
+  const FlowFilePort *pPorts = nullptr;
+  const FlowFileRegister *pRegisters = nullptr;
+  const FlowFileInstruction *pInstructions = nullptr;
+  const FlowFileRecord *pRecords = nullptr;
+  const FlowFileUsage *pUsage = nullptr;
+  const FlowFileResourceDependency *pResourceDependencies = nullptr;
+  const FlowFileString *pStallInfo = nullptr;
+  const uint64_t *pObstructedRegisters = nullptr;
+  const double *pPortPressureCycles = nullptr;
+  const uint64_t *pPortBusyCycles = nullptr;
+  const uint64_t *pInFlightUOpHistogram = nullptr;
+  const uint64_t *pTimelineOffsets = nullptr;
+  const FlowFileInterval *pTimelineIntervals = nullptr;
+
+  inline size_t count(const FlowFileSectionType type) const { return (size_t)pHeader->sections[type].count; }
+  inline std::string_view string(const FlowFileString &string) const { return std::string_view(pStrings + string.offset, string.length); }
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool execution_flow_create(const void *pAssembledBytes, const size_t assembledBytesLength, PortUsageFlow *pFlow, const CoreArchitecture arch, const size_t iterations, const size_t relevantIteration);
+// Holds the LLVM target, subtarget, disassembler, instruction builder & printer for a single `CoreArchitecture`.
+// Creating one is considerably more expensive than analyzing a small block of code, so reuse it across calls where possible.
+// A context must not be used by multiple threads at the same time.
+struct ExecutionFlowContext;
+
+bool execution_flow_context_create(ExecutionFlowContext **ppContext, const CoreArchitecture arch);
+void execution_flow_context_destroy(ExecutionFlowContext **ppContext);
+
+// Stores the results of `execution_flow_create`, `execution_flow_create_from_assembly`, `execution_flow_create_streaming` and `execution_flow_create_until_converged` in `directory` (which is created if it doesn't exist yet).
+// Identical inputs on the same architecture are then loaded from a memory mapped file instead of being disassembled & simulated again. Pass `nullptr` to disable the cache.
+bool execution_flow_context_set_cache_directory(ExecutionFlowContext *pContext, const char *directory);
+
+// Contexts start out with the defaults of their scheduling model: the dispatch width is `MCSchedModel::IssueWidth` and the load & store queue sizes are the buffer sizes of the model's load & store queues (if it describes them).
+// The scheduling models don't describe the frontend, so the micro-op queue isn't modelled by default.
+bool execution_flow_context_get_default_pipeline_options(const ExecutionFlowContext *pContext, PipelineOptions *pOptions);
+bool execution_flow_context_get_pipeline_options(const ExecutionFlowContext *pContext, PipelineOptions *pOptions);
+
+// Applies to all subsequent simulations with `pContext`. The overloads that don't take a context always use the defaults.
+bool execution_flow_context_set_pipeline_options(ExecutionFlowContext *pContext, const PipelineOptions &options);
+
+// `CollectionLevel::Summary` keeps the memory footprint independent of the number of iterations, see `CollectionLevel`.
+bool execution_flow_create(const void *pAssembledBytes, const size_t assembledBytesLength, PortUsageFlow *pFlow, const CoreArchitecture arch, const size_t iterations, const size_t relevantIteration, const CollectionLevel collectionLevel = CollectionLevel::Full);
+bool execution_flow_create(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, PortUsageFlow *pFlow, const size_t iterations, const size_t relevantIteration, const CollectionLevel collectionLevel = CollectionLevel::Full);
+
+enum class AssemblySyntax
+{
+  ATT, // the default of `llvm-mca` & the GNU assembler.
+  Intel, // without register prefixes, like `.intel_syntax noprefix`.
+};
+
+// Assembles `assemblyText` in-process (like `llvm-mca`) and simulates the resulting instructions, without a round trip through an external assembler & the disassembler.
+// Labels & directives are accepted, but only instructions are simulated. `InstructionInfo::instructionByteOffset` & `instructionLength` refer to the encoded instructions.
+bool execution_flow_create_from_assembly(ExecutionFlowContext *pContext, const char *assemblyText, const size_t assemblyTextLength, const AssemblySyntax syntax, PortUsageFlow *pFlow, const size_t iterations, const size_t relevantIteration, const CollectionLevel collectionLevel = CollectionLevel::Full);
+
+// Feeds the iterations incrementally into the simulation & recycles the simulated instructions, so memory doesn't grow with the number of iterations.
+// Only the last `retainedIterations` iterations are kept in `InstructionInfo::perIteration` (& `stallInfo`); `PortUsageFlow::statistics` and `InstructionInfo::statistics` still cover all iterations.
+// `iterations * instructionCount` must not exceed `UINT32_MAX`.
+bool execution_flow_create_streaming(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, PortUsageFlow *pFlow, const size_t iterations, const size_t relevantIteration, const size_t retainedIterations);
+
+// Streams iterations until the cycles per iteration & the iteration latency have settled (see `ConvergenceOptions`) and stops the simulation early.
+// The detected steady state & the number of warm-up iterations are reported in `PortUsageFlow::steadyState`. If `ConvergenceOptions::maxIterations` is reached first, `SteadyStateInfo::converged` is false.
+bool execution_flow_create_until_converged(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, PortUsageFlow *pFlow, const ConvergenceOptions &options, const size_t retainedIterations);
+
+// Stores the per-iteration records in `PortUsageFlow::columns` instead of `InstructionInfo::perIteration`, which only takes a few bytes per record and no allocations.
+// `iterations * instructionCount` and the total number of simulated cycles must not exceed `UINT32_MAX`.
+bool execution_flow_create_columnar(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, PortUsageFlow *pFlow, const size_t iterations, const size_t relevantIteration);
+
+// Converts the retained `InstructionInfo::perIteration` records of `flow` to columns, so they can be scanned linearly. Dependencies on iterations that are no longer retained are dropped.
+bool execution_flow_get_columns(const PortUsageFlow &flow, FlowColumns *pColumns);
+
+// Counts the distinct cycles spent in every `ExecutionState` & the distinct busy cycles of every port, per iteration and across the first `maxIterations` iterations of `columns`.
+// Sorts & merges the intervals of every record instead of scanning all records for every cycle.
+bool execution_flow_get_state_statistics(const FlowColumns &columns, const size_t portCount, FlowStateStatistics *pStatistics, const size_t maxIterations = (size_t)-1);
+
+struct AssembledCodeRange
+{
+  const void *pAssembledBytes;
+  size_t assembledBytesLength;
+
+  inline AssembledCodeRange(const void *pAssembledBytes, const size_t assembledBytesLength) :
+    pAssembledBytes(pAssembledBytes),
+    assembledBytesLength(assembledBytesLength)
+  { }
+};
+
+// An x86-64 object file or executable (ELF, COFF, Mach-O, ...), memory mapped by `execution_flow_object_create`.
+struct ExecutionFlowObject;
+
+struct ObjectCodeRange
+{
+  const void *pAssembledBytes; // points into the mapped file, valid until the object is destroyed.
+  size_t assembledBytesLength;
+  uint64_t address; // virtual address of the first byte (relative to the section for relocatable objects).
+
+  inline ObjectCodeRange() :
+    pAssembledBytes(nullptr),
+    assembledBytesLength(0),
+    address(0)
+  { }
+};
+
+bool execution_flow_object_create(ExecutionFlowObject **ppObject, const char *filename);
+void execution_flow_object_destroy(ExecutionFlowObject **ppObject);
+
+// Selects the bytes of the symbol `symbolName`. Symbols without a size (as in COFF & Mach-O) extend to the next symbol in the same section.
+bool execution_flow_object_get_symbol(const ExecutionFlowObject *pObject, const char *symbolName, ObjectCodeRange *pRange);
+
+// Selects `length` bytes at `offset` into the section `sectionName`. If `length` is 0 the range extends to the end of the section.
+bool execution_flow_object_get_section(const ExecutionFlowObject *pObject, const char *sectionName, const uint64_t offset, const uint64_t length, ObjectCodeRange *pRange);
+
+// Selects the virtual addresses `[beginAddress, endAddress)`, which have to be inside of a single section.
+bool execution_flow_object_get_address_range(const ExecutionFlowObject *pObject, const uint64_t beginAddress, const uint64_t endAddress, ObjectCodeRange *pRange);
+
+struct CorpusOptions
+{
+  size_t iterations; // simulated per block.
+  size_t blocksPerBatch; // blocks that are split off, analyzed & written at once. Bounds the memory usage.
+  size_t threadCount; // if this is 0, all hardware threads will be used.
+  const PipelineOptions *pPipelineOptions; // if this is `nullptr`, the defaults of the scheduling model will be used.
+  bool analytical; // only compute the bounds of `execution_flow_get_throughput_bounds` instead of simulating the blocks.
+
+  inline CorpusOptions(const size_t iterations = 100, const size_t blocksPerBatch = 1024 * 16, const size_t threadCount = 0, const PipelineOptions *pPipelineOptions = nullptr, const bool analytical = false) :
+    iterations(iterations),
+    blocksPerBatch(blocksPerBatch),
+    threadCount(threadCount),
+    pPipelineOptions(pPipelineOptions),
+    analytical(analytical)
+  { }
+};
+
+struct CorpusSummary
+{
+  size_t blockCount, distinctBlockCount, failedBlockCount;
+
+  inline CorpusSummary() :
+    blockCount(0),
+    distinctBlockCount(0),
+    failedBlockCount(0)
+  { }
+};
+
+constexpr char CorpusFileMagic[8] = { 'E', 'X', 'C', 'O', 'R', 'P', 'U', 'S' };
+constexpr uint32_t CorpusFileVersion = 1;
+constexpr uint16_t CorpusFileNoPort = UINT16_MAX;
+constexpr uint8_t CorpusFileNoStall = UINT8_MAX;
+
+// Little-endian. Followed by `portNamesSize` bytes of zero terminated port names (padded to 8 bytes) and any number of row groups until the end of the file.
+struct CorpusFileHeader
+{
+  char magic[sizeof(CorpusFileMagic)];
+  uint32_t version;
+  uint32_t architecture; // `CoreArchitecture`
+  uint64_t iterations; // 0 if the rows hold analytical bounds (see `CorpusOptions::analytical`).
+  uint64_t portCount;
+  uint64_t portNamesSize;
+};
+
+// Followed by one array per column, each padded to 8 bytes:
+// `uint64_t address[rowCount]`, `uint32_t length[rowCount]`, `uint32_t instructionCount[rowCount]`, `float cyclesPerIteration[rowCount]` (NaN if the block couldn't be analyzed),
+// `uint16_t bottleneckPort[rowCount]` (the port with the most consumed resource cycles or `CorpusFileNoPort`), `uint8_t dominantStall[rowCount]` (`StallType` or `CorpusFileNoStall`).
+struct CorpusRowGroupHeader
+{
+  uint64_t rowCount;
+};
+
+// Splits the code in `[pAssembledBytes, pAssembledBytes + assembledBytesLength)`, located at `address`, into basic blocks: at branch targets and after branches, calls & returns.
+// Every distinct block is analyzed once on a work-stealing thread pool (with one context per worker), and one row per block is streamed to `outFilename` (see `CorpusFileHeader`).
+// Blocks are split off, analyzed & written in batches. Besides one bit per byte of code for the branch targets, memory only grows with the number of distinct blocks:
+// 24 bytes for the result of each distinct block & a 24 byte bucket in the deduplication hash map (at most ~112 bytes per distinct block, right after both containers have grown).
+bool execution_flow_analyze_corpus(const void *pAssembledBytes, const size_t assembledBytesLength, const uint64_t address, const CoreArchitecture arch, const char *outFilename, const CorpusOptions &options = CorpusOptions(), CorpusSummary *pSummary = nullptr);
+
+// Analyzes `count` independent code ranges on a work-stealing thread pool (with one context per worker) and fills `pFlows[0 .. count - 1]`.
+// If `threadCount` is 0, all hardware threads will be used. If `pSucceeded` isn't `nullptr` it receives the per-range results.
+// Returns `false` if any of the ranges failed.
+bool execution_flow_create_batch(const AssembledCodeRange *pCodeRanges, const size_t count, PortUsageFlow *pFlows, const CoreArchitecture arch, const size_t iterations, const size_t relevantIteration, bool *pSucceeded = nullptr, const size_t threadCount = 0, const CollectionLevel collectionLevel = CollectionLevel::Full);
+
+// Decodes the bytes once and simulates them on all `archCount` architectures in `pArchs` concurrently, filling `pFlows[0 .. archCount - 1]`.
+// If `pThroughput` isn't `nullptr`, it receives one row of throughput figures per architecture.
+// If `threadCount` is 0, all hardware threads will be used. Returns `false` if any of the architectures failed.
+bool execution_flow_create_for_architectures(const void *pAssembledBytes, const size_t assembledBytesLength, const CoreArchitecture *pArchs, const size_t archCount, PortUsageFlow *pFlows, ArchitectureThroughput *pThroughput, const size_t iterations, const size_t relevantIteration, const size_t threadCount = 0);
+
+// Decodes the bytes once and simulates every combination of the values of the `parameterCount` parameters in `pParameters` (and the unchanged baseline) concurrently.
+// Parameters that aren't part of the grid keep the values of `pContext`. Only out-of-order scheduling models are supported.
+// If `threadCount` is 0, all hardware threads will be used. Returns `false` if a parameter is invalid or any of the configurations failed.
+bool execution_flow_sweep(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, const SweepParameter *pParameters, const size_t parameterCount, const size_t iterations, SweepResult *pResult, const size_t threadCount = 0);
+
+// Answers "which instruction would speed up the loop the most if it were cheaper?": re-simulates the code concurrently, once per instruction with its latency halved and once with its resource cycles halved.
+// Uses the pipeline options of `pContext`. Only out-of-order scheduling models are supported.
+// If `threadCount` is 0, all hardware threads will be used. Returns `false` if the baseline or any of the variants failed.
+bool execution_flow_get_sensitivity(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, const size_t iterations, SensitivityResult *pResult, const size_t threadCount = 0);
+
+// Answers "which port is the loop bound on?": re-simulates the code concurrently, once per resource of `PortUsageFlow::ports` with one more unit and once without any instruction occupying it.
+// Uses the pipeline options of `pContext`. Only out-of-order scheduling models are supported.
+// If `threadCount` is 0, all hardware threads will be used. Returns `false` if the baseline or any of the variants failed.
+bool execution_flow_get_port_sensitivity(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, const size_t iterations, PortSensitivityResult *pResult, const size_t threadCount = 0);
+
+// Computes analytical lower bounds of the cycles per iteration without running the pipeline, e.g. to triage code before simulating it.
+// Memory dependencies & read-advance cycles are ignored. Uses the dispatch width of `pContext`.
+bool execution_flow_get_throughput_bounds(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, ThroughputBounds *pBounds);
+
+ArchitectureThroughput execution_flow_get_throughput(const PortUsageFlow &flow, const CoreArchitecture arch, const bool succeeded);
+
+// Writes `flow` (including columnar flows) to `filename` in the format described by `FlowFileHeader`. The file is written to a temporary file first & then renamed, so readers never see partial files.
+bool execution_flow_save(const PortUsageFlow &flow, const char *filename);
+
+// Memory maps `filename` and validates it, without copying or deserializing anything. The view has to be destroyed with `execution_flow_view_destroy`.
+bool execution_flow_load(const char *filename, FlowFileView **ppView);
+
+// Creates a view into a flow file that's already in memory. `pData` has to be 8 byte aligned & outlive the view.
+bool execution_flow_load(const void *pData, const size_t size, FlowFileView **ppView);
+
+void execution_flow_view_destroy(FlowFileView **ppView);
+
+// Deserializes the entire view. Columnar flows are restored into `InstructionInfo::perIteration`.
+bool execution_flow_view_get_flow(const FlowFileView *pView, PortUsageFlow *pFlow);
 
 #endif // execution_flow_h__
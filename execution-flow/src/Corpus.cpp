@@ -0,0 +1,420 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2023, Christoph Stiller. All rights reserved.
+// 
+// Redistribution and use in next and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of next code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation 
+//    and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "execution-flow.h"
+#include "ExecutionFlowContext.h"
+#include "ThreadPool.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#pragma warning (push, 0)
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wall"
+#pragma GCC diagnostic ignored "-Wextra"
+#endif
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/MC/MCDisassembler/MCDisassembler.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstrAnalysis.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+#ifdef _MSC_VER
+#pragma warning (pop)
+#else
+#pragma GCC diagnostic pop
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct CorpusBlock
+{
+  size_t offset;
+  uint32_t length;
+  uint32_t resultIndex; // into `CorpusState::results`.
+};
+
+struct CorpusResult
+{
+  size_t offset = 0; // of the first block with these bytes, compared against on hash hits (the length is part of the key).
+  uint32_t nextWithSameKey = UINT32_MAX; // index into `CorpusState::results` of the next distinct block whose hash & length collide with this one.
+  uint32_t instructionCount = 0;
+  float cyclesPerIteration = NAN;
+  uint16_t bottleneckPort = CorpusFileNoPort;
+  uint8_t dominantStall = CorpusFileNoStall;
+};
+
+struct CorpusState
+{
+  llvm::ArrayRef<uint8_t> bytes;
+  uint64_t address;
+  CoreArchitecture arch;
+  CorpusOptions options;
+  FILE *pFile = nullptr;
+
+  std::vector<ExecutionFlowContext *> contexts; // one per worker, reused across batches.
+  llvm::DenseMap<std::pair<uint64_t, uint32_t>, uint32_t> resultLookup; // (hash of the block bytes, length) => index into `results` of the first block with this key.
+  std::vector<CorpusResult> results; // one per distinct block.
+
+  std::vector<CorpusBlock> batch; // every block of the current batch, in order.
+  std::vector<CorpusBlock> pendingBlocks; // the distinct blocks of the current batch that haven't been analyzed yet.
+
+  CorpusSummary summary;
+};
+
+static bool execution_flow_corpus_create_context(CorpusState &state, ExecutionFlowContext **ppContext);
+static bool execution_flow_corpus_ends_block(ExecutionFlowContext *pContext, const llvm::MCInst &instruction);
+static void execution_flow_corpus_find_leaders(ExecutionFlowContext *pContext, const llvm::ArrayRef<uint8_t> bytes, const uint64_t address, std::vector<bool> &leaders);
+static bool execution_flow_corpus_add_block(CorpusState &state, const size_t offset, const size_t length);
+static bool execution_flow_corpus_flush(CorpusState &state);
+static bool execution_flow_corpus_write(FILE *pFile, const void *pData, const size_t size);
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool execution_flow_analyze_corpus(const void *pAssembledBytes, const size_t assembledBytesLength, const uint64_t address, const CoreArchitecture arch, const char *outFilename, const CorpusOptions &options /* = CorpusOptions() */, CorpusSummary *pSummary /* = nullptr */)
+{
+  if (pAssembledBytes == nullptr || outFilename == nullptr || (uint64_t)arch >= (uint64_t)CoreArchitecture::_Count || options.iterations == 0 || options.iterations > UINT32_MAX || options.blocksPerBatch == 0)
+    return false;
+
+  CorpusState state;
+  state.bytes = llvm::ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(pAssembledBytes), assembledBytesLength);
+  state.address = address;
+  state.arch = arch;
+  state.options = options;
+  state.contexts.resize(thread_pool_worker_count((size_t)-1, options.threadCount), nullptr);
+
+  // The calling thread is worker 0, so its context also splits the blocks in between the batches.
+  if (!execution_flow_corpus_create_context(state, &state.contexts[0]))
+    return false;
+
+  bool result = true;
+
+  state.pFile = fopen(outFilename, "wb");
+
+  if (state.pFile == nullptr)
+    result = false;
+
+  // Write the header & the port names.
+  if (result)
+  {
+    std::string portNames;
+
+    for (const auto &_port : state.contexts[0]->ports)
+      portNames.append(_port.name.c_str(), _port.name.size() + 1);
+
+    portNames.resize((portNames.size() + 7) & ~(size_t)7, '\0');
+
+    CorpusFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CorpusFileMagic, sizeof(CorpusFileMagic));
+    header.version = CorpusFileVersion;
+    header.architecture = (uint32_t)arch;
+    header.iterations = options.analytical ? 0 : options.iterations;
+    header.portCount = state.contexts[0]->ports.size();
+    header.portNamesSize = portNames.size();
+
+    result = execution_flow_corpus_write(state.pFile, &header, sizeof(header)) && execution_flow_corpus_write(state.pFile, portNames.data(), portNames.size());
+  }
+
+  if (result)
+  {
+    ExecutionFlowContext *pContext = state.contexts[0];
+
+    // Branch targets can only be found by looking at all of the code first, which takes one bit per byte of code. Besides `results` & `resultLookup` (one entry per distinct block), this is the only state that grows with the size of the code.
+    std::vector<bool> leaders;
+    execution_flow_corpus_find_leaders(pContext, state.bytes, address, leaders);
+
+    // Split the blocks with a second linear pass. Bytes that can't be decoded end the current block and aren't part of any block.
+    size_t blockBegin = 0;
+
+    for (size_t i = 0; i < state.bytes.size() && result;)
+    {
+      if (leaders[i] && blockBegin < i)
+      {
+        result = execution_flow_corpus_add_block(state, blockBegin, i - blockBegin);
+        blockBegin = i;
+      }
+
+      size_t instructionSize = 1;
+      llvm::MCInst instruction;
+
+      if (pContext->disassembler->getInstruction(instruction, instructionSize, state.bytes.slice(i), address + i, llvm::nulls()) == llvm::MCDisassembler::Fail)
+      {
+        if (blockBegin < i)
+          result = execution_flow_corpus_add_block(state, blockBegin, i - blockBegin);
+
+        i += std::max(instructionSize, (size_t)1);
+        blockBegin = i;
+
+        continue;
+      }
+
+      i += instructionSize;
+
+      if (execution_flow_corpus_ends_block(pContext, instruction))
+      {
+        result = execution_flow_corpus_add_block(state, blockBegin, i - blockBegin);
+        blockBegin = i;
+      }
+    }
+
+    if (result && blockBegin < state.bytes.size())
+      result = execution_flow_corpus_add_block(state, blockBegin, state.bytes.size() - blockBegin);
+
+    if (result)
+      result = execution_flow_corpus_flush(state);
+  }
+
+  if (state.pFile != nullptr && fclose(state.pFile) != 0)
+    result = false;
+
+  for (auto &_context : state.contexts)
+    execution_flow_context_destroy(&_context);
+
+  if (pSummary != nullptr)
+    *pSummary = state.summary;
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool execution_flow_corpus_create_context(CorpusState &state, ExecutionFlowContext **ppContext)
+{
+  if (!execution_flow_context_create(ppContext, state.arch))
+    return false;
+
+  if (state.options.pPipelineOptions != nullptr && !execution_flow_context_set_pipeline_options(*ppContext, *state.options.pPipelineOptions))
+  {
+    execution_flow_context_destroy(ppContext);
+    return false;
+  }
+
+  return true;
+}
+
+static bool execution_flow_corpus_ends_block(ExecutionFlowContext *pContext, const llvm::MCInst &instruction)
+{
+  const llvm::MCInstrAnalysis *pAnalysis = pContext->instructionAnalysis.get();
+
+  if (pAnalysis != nullptr)
+    return pAnalysis->isBranch(instruction) || pAnalysis->isCall(instruction) || pAnalysis->isReturn(instruction) || pAnalysis->isTerminator(instruction);
+
+  const llvm::MCInstrDesc &description = pContext->instructionInfo->get(instruction.getOpcode());
+
+  return description.isBranch() || description.isCall() || description.isReturn() || description.isTerminator();
+}
+
+// Marks the start of the code, branch targets & the instructions following branches, calls & returns. Targets that aren't on the boundary of a linearly decoded instruction are ignored.
+static void execution_flow_corpus_find_leaders(ExecutionFlowContext *pContext, const llvm::ArrayRef<uint8_t> bytes, const uint64_t address, std::vector<bool> &leaders)
+{
+  leaders.assign(bytes.size(), false);
+
+  if (bytes.size() > 0)
+    leaders[0] = true;
+
+  for (size_t i = 0; i < bytes.size();)
+  {
+    size_t instructionSize = 1;
+    llvm::MCInst instruction;
+
+    if (pContext->disassembler->getInstruction(instruction, instructionSize, bytes.slice(i), address + i, llvm::nulls()) == llvm::MCDisassembler::Fail)
+    {
+      i += std::max(instructionSize, (size_t)1);
+      continue;
+    }
+
+    if (execution_flow_corpus_ends_block(pContext, instruction))
+    {
+      uint64_t target = 0;
+
+      if (pContext->instructionAnalysis != nullptr && pContext->instructionAnalysis->evaluateBranch(instruction, address + i, instructionSize, target) && target >= address && target - address < bytes.size())
+        leaders[target - address] = true;
+    }
+
+    i += instructionSize;
+  }
+}
+
+static bool execution_flow_corpus_add_block(CorpusState &state, const size_t offset, const size_t length)
+{
+  // Blocks are analyzed as a whole, anything longer than this isn't a basic block anyways.
+  const uint32_t blockLength = (uint32_t)std::min(length, (size_t)UINT32_MAX);
+  const uint64_t hash = llvm::xxh3_64bits(state.bytes.slice(offset, blockLength));
+
+  const auto &entry = state.resultLookup.try_emplace(std::make_pair(hash, blockLength), (uint32_t)state.results.size());
+  uint32_t resultIndex = entry.first->second;
+
+  if (!entry.second)
+  {
+    // Hash collisions are rare, but must not hand one block the results of another, so the bytes are compared with the first block of every distinct block with the same key.
+    while (memcmp(state.bytes.data() + state.results[resultIndex].offset, state.bytes.data() + offset, blockLength) != 0)
+    {
+      if (state.results[resultIndex].nextWithSameKey == UINT32_MAX)
+      {
+        state.results[resultIndex].nextWithSameKey = (uint32_t)state.results.size();
+        resultIndex = (uint32_t)state.results.size();
+        break;
+      }
+
+      resultIndex = state.results[resultIndex].nextWithSameKey;
+    }
+  }
+
+  if (resultIndex == state.results.size())
+  {
+    CorpusResult &result = state.results.emplace_back();
+    result.offset = offset;
+
+    state.pendingBlocks.push_back({ offset, blockLength, resultIndex });
+  }
+
+  state.batch.push_back({ offset, blockLength, resultIndex });
+
+  if (state.batch.size() >= state.options.blocksPerBatch)
+    return execution_flow_corpus_flush(state);
+
+  return true;
+}
+
+static bool execution_flow_corpus_flush(CorpusState &state)
+{
+  if (state.batch.empty())
+    return true;
+
+  // Analyze the distinct blocks that haven't been seen before. `results` doesn't grow while the workers are running.
+  thread_pool_run(state.pendingBlocks.size(), state.options.threadCount, [&](const size_t workerIndex, const size_t taskIndex)
+    {
+      const CorpusBlock &block = state.pendingBlocks[taskIndex];
+      CorpusResult &result = state.results[block.resultIndex];
+
+      if (state.contexts[workerIndex] == nullptr && !execution_flow_corpus_create_context(state, &state.contexts[workerIndex]))
+        return;
+
+      if (state.options.analytical)
+      {
+        ThroughputBounds bounds;
+        const bool succeeded = execution_flow_get_throughput_bounds(state.contexts[workerIndex], state.bytes.data() + block.offset, block.length, &bounds);
+
+        result.instructionCount = (uint32_t)bounds.instructionCount;
+
+        if (!succeeded)
+          return;
+
+        result.cyclesPerIteration = (float)bounds.cyclesPerIteration;
+
+        if (bounds.bottleneckPort < CorpusFileNoPort)
+          result.bottleneckPort = (uint16_t)bounds.bottleneckPort;
+
+        return;
+      }
+
+      PortUsageFlow flow;
+      const bool succeeded = execution_flow_create(state.contexts[workerIndex], state.bytes.data() + block.offset, block.length, &flow, state.options.iterations, 0, CollectionLevel::Summary);
+
+      result.instructionCount = (uint32_t)flow.instructionExecutionInfo.size();
+
+      if (!succeeded)
+        return;
+
+      result.cyclesPerIteration = (float)execution_flow_get_throughput(flow, state.arch, succeeded).cyclesPerIteration;
+
+      double maxPressure = 0;
+
+      for (size_t i = 0; i < flow.statistics.portPressureCycles.size() && i < CorpusFileNoPort; i++)
+      {
+        if (flow.statistics.portPressureCycles[i] > maxPressure)
+        {
+          maxPressure = flow.statistics.portPressureCycles[i];
+          result.bottleneckPort = (uint16_t)i;
+        }
+      }
+
+      size_t maxStalls = 0;
+
+      for (size_t i = 0; i < _ST_Count; i++)
+      {
+        if (flow.statistics.stallCounts[i] > maxStalls)
+        {
+          maxStalls = flow.statistics.stallCounts[i];
+          result.dominantStall = (uint8_t)i;
+        }
+      }
+    });
+
+  state.summary.distinctBlockCount += state.pendingBlocks.size();
+  state.pendingBlocks.clear();
+
+  // Write the batch as one row group.
+  const size_t rowCount = state.batch.size();
+  std::vector<uint8_t> column;
+
+  auto writeColumn = [&](auto getValue) -> bool
+  {
+    using T = decltype(getValue(state.batch[0]));
+
+    column.resize((rowCount * sizeof(T) + 7) & ~(size_t)7);
+    memset(column.data(), 0, column.size());
+
+    for (size_t i = 0; i < rowCount; i++)
+    {
+      const T value = getValue(state.batch[i]);
+      memcpy(column.data() + i * sizeof(T), &value, sizeof(T));
+    }
+
+    return execution_flow_corpus_write(state.pFile, column.data(), column.size());
+  };
+
+  const CorpusRowGroupHeader header = { rowCount };
+
+  const bool result = execution_flow_corpus_write(state.pFile, &header, sizeof(header))
+    && writeColumn([&](const CorpusBlock &block) { return (uint64_t)(state.address + block.offset); })
+    && writeColumn([&](const CorpusBlock &block) { return (uint32_t)block.length; })
+    && writeColumn([&](const CorpusBlock &block) { return state.results[block.resultIndex].instructionCount; })
+    && writeColumn([&](const CorpusBlock &block) { return state.results[block.resultIndex].cyclesPerIteration; })
+    && writeColumn([&](const CorpusBlock &block) { return state.results[block.resultIndex].bottleneckPort; })
+    && writeColumn([&](const CorpusBlock &block) { return state.results[block.resultIndex].dominantStall; });
+
+  for (const auto &_block : state.batch)
+    if (isnan(state.results[_block.resultIndex].cyclesPerIteration))
+      state.summary.failedBlockCount++;
+
+  state.summary.blockCount += rowCount;
+  state.batch.clear();
+
+  return result;
+}
+
+static bool execution_flow_corpus_write(FILE *pFile, const void *pData, const size_t size)
+{
+  return size == 0 || fwrite(pData, 1, size, pFile) == size;
+}
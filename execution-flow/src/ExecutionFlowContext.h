@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2023, Christoph Stiller. All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation 
+//    and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ExecutionFlowContext_h__
+#define ExecutionFlowContext_h__
+
+#include "execution-flow.h"
+
+#include <deque>
+#include <memory>
+
+#ifdef _MSC_VER
+#pragma warning (push, 0)
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wall"
+#pragma GCC diagnostic ignored "-Wextra"
+#endif
+#include "llvm/MC/MCAsmInfo.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstPrinter.h"
+#include "llvm/MC/MCInstrAnalysis.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/MCTargetOptions.h"
+#include "llvm/MC/MCDisassembler/MCDisassembler.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/MCA/CustomBehaviour.h"
+#include "llvm/MCA/InstrBuilder.h"
+#include "llvm/TargetParser/Triple.h"
+#ifdef _MSC_VER
+#pragma warning (pop)
+#else
+#pragma GCC diagnostic pop
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct ExecutionFlowContext
+{
+  CoreArchitecture arch;
+  llvm::Triple targetTriple;
+  const llvm::Target *pTarget = nullptr;
+  llvm::MCTargetOptions targetOptions;
+
+  std::unique_ptr<llvm::MCRegisterInfo> registerInfo;
+  std::unique_ptr<llvm::MCAsmInfo> asmInfo;
+  std::unique_ptr<llvm::MCSubtargetInfo> subtargetInfo;
+  std::unique_ptr<llvm::MCContext> context;
+  std::unique_ptr<llvm::MCDisassembler> disassembler;
+  std::unique_ptr<llvm::MCInstrInfo> instructionInfo;
+  std::unique_ptr<llvm::MCInstrAnalysis> instructionAnalysis;
+  std::unique_ptr<llvm::mca::InstrumentManager> instrumentManager;
+  std::unique_ptr<llvm::mca::InstrBuilder> instructionBuilder; // keeps the `InstrDesc` cache alive between calls.
+  std::unique_ptr<llvm::MCInstPrinter> instructionPrinter;
+
+  // These only depend on the scheduler model, so they're enumerated once.
+  std::vector<ResourceInfo> ports;
+  std::vector<uint32_t> resourceUnitToPortIndex; // `[llvmResourceIndex * resourceUnitStride + unitBit]` => port index (or `UINT32_MAX`).
+  size_t resourceUnitStride = 0;
+  std::vector<HardwareRegisterCount> hardwareRegisters;
+  std::vector<bool> registerFileRelevancy;
+
+  // `InstrBuilder` caches variant descriptors by `MCInst` address, so decoded instructions have to stay alive for as long as the builder has them cached.
+  std::deque<llvm::MCInst> retainedInstructions;
+
+  PipelineOptions defaultPipelineOptions; // derived from the scheduling model.
+  PipelineOptions pipelineOptions; // see `execution_flow_context_set_pipeline_options`.
+
+  std::string cacheDirectory; // empty if results aren't cached (see `execution_flow_context_set_cache_directory`).
+
+  inline ExecutionFlowContext(const CoreArchitecture arch) :
+    arch(arch)
+  { }
+};
+
+#endif // ExecutionFlowContext_h__
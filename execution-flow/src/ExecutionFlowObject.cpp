@@ -0,0 +1,212 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2023, Christoph Stiller. All rights reserved.
+// 
+// Redistribution and use in next and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of next code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation 
+//    and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "execution-flow.h"
+
+#ifdef _MSC_VER
+#pragma warning (push, 0)
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wall"
+#pragma GCC diagnostic ignored "-Wextra"
+#endif
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Object/SymbolSize.h"
+#include "llvm/Support/Error.h"
+#include "llvm/TargetParser/Triple.h"
+#ifdef _MSC_VER
+#pragma warning (pop)
+#else
+#pragma GCC diagnostic pop
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct ExecutionFlowObject
+{
+  llvm::object::OwningBinary<llvm::object::ObjectFile> binary; // the underlying `MemoryBuffer` maps the file.
+};
+
+static bool execution_flow_object_get_section_range(const llvm::object::SectionRef &section, const uint64_t offset, const uint64_t length, ObjectCodeRange *pRange);
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool execution_flow_object_create(ExecutionFlowObject **ppObject, const char *filename)
+{
+  if (ppObject == nullptr || filename == nullptr)
+    return false;
+
+  llvm::Expected<llvm::object::OwningBinary<llvm::object::ObjectFile>> binary = llvm::object::ObjectFile::createObjectFile(filename);
+
+  if (!binary)
+  {
+    llvm::consumeError(binary.takeError());
+    return false;
+  }
+
+  // The disassembler & scheduling models are x86-64 only.
+  if (binary->getBinary()->getArch() != llvm::Triple::x86_64)
+    return false;
+
+  ExecutionFlowObject *pObject = new ExecutionFlowObject();
+  pObject->binary = std::move(binary.get());
+
+  *ppObject = pObject;
+
+  return true;
+}
+
+void execution_flow_object_destroy(ExecutionFlowObject **ppObject)
+{
+  if (ppObject == nullptr || *ppObject == nullptr)
+    return;
+
+  delete *ppObject;
+  *ppObject = nullptr;
+}
+
+bool execution_flow_object_get_symbol(const ExecutionFlowObject *pObject, const char *symbolName, ObjectCodeRange *pRange)
+{
+  if (pObject == nullptr || symbolName == nullptr || pRange == nullptr)
+    return false;
+
+  const llvm::object::ObjectFile &object = *pObject->binary.getBinary();
+
+  // Uses the symbol size if there is one, otherwise the distance to the next symbol in the section.
+  for (const auto &_entry : llvm::object::computeSymbolSizes(object))
+  {
+    const llvm::object::SymbolRef &symbol = _entry.first;
+    llvm::Expected<llvm::StringRef> name = symbol.getName();
+
+    if (!name)
+    {
+      llvm::consumeError(name.takeError());
+      continue;
+    }
+
+    if (name.get() != symbolName)
+      continue;
+
+    llvm::Expected<uint64_t> address = symbol.getAddress();
+    llvm::Expected<llvm::object::section_iterator> section = symbol.getSection();
+
+    if (!address || !section || section.get() == object.section_end())
+    {
+      if (!address)
+        llvm::consumeError(address.takeError());
+
+      if (!section)
+        llvm::consumeError(section.takeError());
+
+      continue;
+    }
+
+    const llvm::object::SectionRef &sectionRef = *section.get();
+
+    if (address.get() < sectionRef.getAddress() || _entry.second == 0)
+      continue;
+
+    return execution_flow_object_get_section_range(sectionRef, address.get() - sectionRef.getAddress(), _entry.second, pRange);
+  }
+
+  return false;
+}
+
+bool execution_flow_object_get_section(const ExecutionFlowObject *pObject, const char *sectionName, const uint64_t offset, const uint64_t length, ObjectCodeRange *pRange)
+{
+  if (pObject == nullptr || sectionName == nullptr || pRange == nullptr)
+    return false;
+
+  for (const auto &_section : pObject->binary.getBinary()->sections())
+  {
+    llvm::Expected<llvm::StringRef> name = _section.getName();
+
+    if (!name)
+    {
+      llvm::consumeError(name.takeError());
+      continue;
+    }
+
+    if (name.get() == sectionName)
+      return execution_flow_object_get_section_range(_section, offset, length, pRange);
+  }
+
+  return false;
+}
+
+bool execution_flow_object_get_address_range(const ExecutionFlowObject *pObject, const uint64_t beginAddress, const uint64_t endAddress, ObjectCodeRange *pRange)
+{
+  if (pObject == nullptr || pRange == nullptr || endAddress <= beginAddress)
+    return false;
+
+  for (const auto &_section : pObject->binary.getBinary()->sections())
+  {
+    if (_section.isVirtual() || _section.getSize() == 0)
+      continue;
+
+    const uint64_t sectionAddress = _section.getAddress();
+
+    if (beginAddress >= sectionAddress && endAddress - sectionAddress <= _section.getSize())
+      return execution_flow_object_get_section_range(_section, beginAddress - sectionAddress, endAddress - beginAddress, pRange);
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool execution_flow_object_get_section_range(const llvm::object::SectionRef &section, const uint64_t offset, const uint64_t length, ObjectCodeRange *pRange)
+{
+  // Uninitialized sections don't have any bytes in the file.
+  if (section.isVirtual())
+    return false;
+
+  llvm::Expected<llvm::StringRef> contents = section.getContents();
+
+  if (!contents)
+  {
+    llvm::consumeError(contents.takeError());
+    return false;
+  }
+
+  const uint64_t size = contents.get().size();
+
+  if (offset >= size)
+    return false;
+
+  const uint64_t rangeLength = length == 0 ? size - offset : length;
+
+  if (rangeLength > size - offset)
+    return false;
+
+  pRange->pAssembledBytes = contents.get().data() + offset;
+  pRange->assembledBytesLength = (size_t)rangeLength;
+  pRange->address = section.getAddress() + offset;
+
+  return true;
+}
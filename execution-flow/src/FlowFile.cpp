@@ -0,0 +1,782 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2023, Christoph Stiller. All rights reserved.
+// 
+// Redistribution and use in next and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of next code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation 
+//    and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "FlowFile.h"
+
+#include <memory>
+
+#include <string.h>
+
+#ifdef _MSC_VER
+#pragma warning (push, 0)
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wall"
+#pragma GCC diagnostic ignored "-Wextra"
+#endif
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/SwapByteOrder.h"
+#include "llvm/Support/raw_ostream.h"
+#ifdef _MSC_VER
+#pragma warning (pop)
+#else
+#pragma GCC diagnostic pop
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Every view is allocated as one of these, so `execution_flow_view_destroy` can unmap the file.
+struct FlowFileMappedView : FlowFileView
+{
+  llvm::sys::fs::mapped_file_region region; // empty for views into memory owned by the caller.
+};
+
+struct FlowFileBuilder
+{
+  std::string strings;
+  llvm::StringMap<FlowFileString> internedStrings; // register & resource names repeat for almost every record.
+  bool overflow = false;
+
+  std::vector<FlowFilePort> ports;
+  std::vector<FlowFileRegister> registers;
+  std::vector<FlowFileInstruction> instructions;
+  std::vector<FlowFileRecord> records;
+  std::vector<FlowFileUsage> usage;
+  std::vector<FlowFileResourceDependency> resourceDependencies;
+  std::vector<FlowFileString> stallInfo;
+  std::vector<uint64_t> obstructedRegisters;
+  std::vector<double> portPressureCycles;
+  std::vector<uint64_t> portBusyCycles, inFlightUOpHistogram, timelineOffsets;
+  std::vector<FlowFileInterval> timelineIntervals;
+};
+
+static FlowFileString flow_file_add_string(FlowFileBuilder &builder, const std::string &string);
+static FlowFileOrigin flow_file_to_origin(const std::optional<DependencyOrigin> &origin);
+static FlowFileClocks flow_file_to_clocks(const BasicInstructionInfo &info);
+static FlowFileRange flow_file_add_usage(FlowFileBuilder &builder, const std::vector<ResourcePressureInfo> &usage);
+static void flow_file_add_record(FlowFileBuilder &builder, const LoopInstructionInfo &info);
+static void flow_file_get_column_record(const PortUsageFlow &flow, const size_t record, LoopInstructionInfo &info);
+
+template <typename T>
+static void flow_file_append_section(std::vector<uint8_t> &bytes, FlowFileHeader &header, const FlowFileSectionType type, const T *pData, const size_t count);
+
+template <typename T>
+static bool flow_file_get_section(const uint8_t *pData, const FlowFileHeader &header, const FlowFileSectionType type, const T **ppSection);
+
+static bool flow_file_init_view(const void *pData, const size_t size, FlowFileView &view);
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool flow_file_write(const PortUsageFlow &flow, const uint64_t key, std::vector<uint8_t> &bytes)
+{
+  if constexpr (llvm::sys::IsBigEndianHost)
+    return false;
+
+  FlowFileBuilder builder;
+
+  for (const auto &_port : flow.ports)
+    builder.ports.push_back({ _port.resourceTypeIndex, _port.resourceTypeSubIndex, flow_file_add_string(builder, _port.name) });
+
+  for (const auto &_register : flow.hardwareRegisters)
+    builder.registers.push_back({ flow_file_add_string(builder, _register.registerTypeName), _register.count });
+
+  const FlowColumns &columns = flow.columns;
+  const bool fromColumns = columns.iterationCount != 0 && columns.instructionCount == flow.instructionExecutionInfo.size();
+
+  for (const auto &_instruction : flow.instructionExecutionInfo)
+  {
+    FlowFileInstruction instruction;
+    memset(&instruction, 0, sizeof(instruction));
+
+    instruction.instructionIndex = _instruction.instructionIndex;
+    instruction.byteOffset = _instruction.instructionByteOffset;
+    instruction.length = _instruction.instructionLength;
+    instruction.uOpCount = _instruction.uOpCount;
+    instruction.opcode = _instruction.opcode;
+    instruction.disassembly = flow_file_add_string(builder, _instruction.disassembly);
+    instruction.clocks = flow_file_to_clocks(_instruction);
+    instruction.usage = flow_file_add_usage(builder, _instruction.usage);
+
+    instruction.stallInfo.begin = builder.stallInfo.size();
+
+    for (const auto &_stall : _instruction.stallInfo)
+      builder.stallInfo.push_back(flow_file_add_string(builder, _stall));
+
+    instruction.stallInfo.count = builder.stallInfo.size() - instruction.stallInfo.begin;
+
+    instruction.obstructedRegisters.begin = builder.obstructedRegisters.size();
+    builder.obstructedRegisters.insert(builder.obstructedRegisters.end(), _instruction.physicalRegistersObstructedPerRegisterType.begin(), _instruction.physicalRegistersObstructedPerRegisterType.end());
+    instruction.obstructedRegisters.count = _instruction.physicalRegistersObstructedPerRegisterType.size();
+
+    instruction.records.begin = builder.records.size();
+
+    if (fromColumns)
+    {
+      LoopInstructionInfo info;
+
+      for (size_t iteration = 0; iteration < columns.iterationCount; iteration++)
+      {
+        flow_file_get_column_record(flow, columns.recordIndex(iteration, builder.instructions.size()), info);
+        flow_file_add_record(builder, info);
+      }
+    }
+    else
+    {
+      for (const auto &_record : _instruction.perIteration)
+        flow_file_add_record(builder, _record);
+    }
+
+    instruction.records.count = builder.records.size() - instruction.records.begin;
+
+    const InstructionStatistics &statistics = _instruction.statistics;
+    instruction.iterations = statistics.iterations;
+    instruction.totalDispatched = statistics.totalDispatched;
+    instruction.totalPending = statistics.totalPending;
+    instruction.totalReady = statistics.totalReady;
+    instruction.totalExecuting = statistics.totalExecuting;
+    instruction.totalRetiring = statistics.totalRetiring;
+    instruction.minLatency = statistics.minLatency;
+    instruction.maxLatency = statistics.maxLatency;
+    instruction.stallCount = statistics.stallCount;
+
+    builder.instructions.push_back(instruction);
+  }
+
+  builder.portPressureCycles = flow.statistics.portPressureCycles;
+  builder.portBusyCycles.assign(flow.statistics.portBusyCycles.begin(), flow.statistics.portBusyCycles.end());
+  builder.inFlightUOpHistogram.assign(flow.statistics.inFlightUOpHistogram.begin(), flow.statistics.inFlightUOpHistogram.end());
+
+  builder.timelineOffsets.push_back(0);
+
+  for (const auto &_intervals : flow.cycleTimeline.portBusyIntervals)
+  {
+    for (const auto &_interval : _intervals)
+      builder.timelineIntervals.push_back({ _interval.firstCycle, _interval.cycleCount });
+
+    builder.timelineOffsets.push_back(builder.timelineIntervals.size());
+  }
+
+  if (builder.overflow)
+    return false;
+
+  FlowFileHeader header;
+  memset(&header, 0, sizeof(header));
+
+  memcpy(header.magic, FlowFileMagic, sizeof(FlowFileMagic));
+  header.version = FlowFileVersion;
+  header.headerSize = sizeof(FlowFileHeader);
+  header.key = key;
+  header.firstRetainedIteration = flow.firstRetainedIteration;
+  header.codeAddress = flow.codeAddress.value_or(FlowFileNone);
+
+  const FlowStatistics &statistics = flow.statistics;
+  header.retiredIterations = statistics.retiredIterations;
+  header.firstDispatch = statistics.firstDispatch;
+  header.lastRetire = statistics.lastRetire;
+  header.firstIssued = statistics.firstIssued;
+  header.lastExecuted = statistics.lastExecuted;
+  header.totalUOps = statistics.totalUOps;
+  header.simulatedCycles = statistics.simulatedCycles;
+  header.reorderBufferSize = statistics.reorderBufferSize;
+  header.maxInFlightInstructions = statistics.maxInFlightInstructions;
+  header.maxInFlightUOps = statistics.maxInFlightUOps;
+  header.totalInFlightInstructionCycles = statistics.totalInFlightInstructionCycles;
+  header.totalInFlightUOpCycles = statistics.totalInFlightUOpCycles;
+
+  for (size_t i = 0; i < _ST_Count; i++)
+    header.stallCounts[i] = statistics.stallCounts[i];
+
+  header.converged = flow.steadyState.converged ? 1 : 0;
+  header.warmUpIterations = flow.steadyState.warmUpIterations;
+  header.simulatedIterations = flow.steadyState.simulatedIterations;
+  header.cyclesPerIteration = flow.steadyState.cyclesPerIteration;
+  header.iterationLatency = flow.steadyState.iterationLatency;
+
+  bytes.clear();
+  bytes.resize(sizeof(FlowFileHeader));
+
+  flow_file_append_section(bytes, header, FFS_Strings, builder.strings.data(), builder.strings.size());
+  flow_file_append_section(bytes, header, FFS_Ports, builder.ports.data(), builder.ports.size());
+  flow_file_append_section(bytes, header, FFS_Registers, builder.registers.data(), builder.registers.size());
+  flow_file_append_section(bytes, header, FFS_Instructions, builder.instructions.data(), builder.instructions.size());
+  flow_file_append_section(bytes, header, FFS_Records, builder.records.data(), builder.records.size());
+  flow_file_append_section(bytes, header, FFS_Usage, builder.usage.data(), builder.usage.size());
+  flow_file_append_section(bytes, header, FFS_ResourceDependencies, builder.resourceDependencies.data(), builder.resourceDependencies.size());
+  flow_file_append_section(bytes, header, FFS_StallInfo, builder.stallInfo.data(), builder.stallInfo.size());
+  flow_file_append_section(bytes, header, FFS_ObstructedRegisters, builder.obstructedRegisters.data(), builder.obstructedRegisters.size());
+  flow_file_append_section(bytes, header, FFS_PortPressureCycles, builder.portPressureCycles.data(), builder.portPressureCycles.size());
+  flow_file_append_section(bytes, header, FFS_PortBusyCycles, builder.portBusyCycles.data(), builder.portBusyCycles.size());
+  flow_file_append_section(bytes, header, FFS_InFlightUOpHistogram, builder.inFlightUOpHistogram.data(), builder.inFlightUOpHistogram.size());
+  flow_file_append_section(bytes, header, FFS_TimelineOffsets, builder.timelineOffsets.data(), builder.timelineOffsets.size());
+  flow_file_append_section(bytes, header, FFS_TimelineIntervals, builder.timelineIntervals.data(), builder.timelineIntervals.size());
+
+  header.fileSize = bytes.size();
+  memcpy(bytes.data(), &header, sizeof(header));
+
+  return true;
+}
+
+bool execution_flow_view_get_flow(const FlowFileView *pView, PortUsageFlow *pFlow)
+{
+  if (pView == nullptr || pView->pHeader == nullptr || pFlow == nullptr)
+    return false;
+
+  const FlowFileView &view = *pView;
+  const FlowFileHeader &header = *view.pHeader;
+
+  auto getString = [&](const FlowFileString &string)
+  {
+    return std::string(view.string(string));
+  };
+
+  auto getOrigin = [](const FlowFileOrigin &origin) -> std::optional<DependencyOrigin>
+  {
+    if (origin.instructionIndex == FlowFileNone)
+      return std::nullopt;
+
+    return DependencyOrigin((size_t)origin.iterationIndex, (size_t)origin.instructionIndex);
+  };
+
+  auto getUsage = [&](const FlowFileRange &range, std::vector<ResourcePressureInfo> &usage)
+  {
+    usage.reserve(range.count);
+
+    for (size_t i = range.begin; i < range.begin + range.count; i++)
+      usage.emplace_back((size_t)view.pUsage[i].portIndex, view.pUsage[i].pressure);
+  };
+
+  auto getClocks = [](const FlowFileClocks &clocks, BasicInstructionInfo &info)
+  {
+    info.clockDispatched = clocks.dispatched;
+    info.clockPending = clocks.pending;
+    info.clockReady = clocks.ready;
+    info.clockIssued = clocks.issued;
+    info.clockExecuted = clocks.executed;
+    info.clockRetired = clocks.retired;
+    info.uOps = clocks.uOps;
+  };
+
+  PortUsageFlow flow;
+
+  const size_t portCount = view.count(FFS_Ports);
+  flow.ports.reserve(portCount);
+
+  for (size_t i = 0; i < portCount; i++)
+    flow.ports.emplace_back((size_t)view.pPorts[i].resourceTypeIndex, (size_t)view.pPorts[i].resourceTypeSubIndex, getString(view.pPorts[i].name));
+
+  const size_t registerCount = view.count(FFS_Registers);
+  flow.hardwareRegisters.reserve(registerCount);
+
+  for (size_t i = 0; i < registerCount; i++)
+    flow.hardwareRegisters.emplace_back(getString(view.pRegisters[i].name), (size_t)view.pRegisters[i].count);
+
+  const size_t instructionCount = view.count(FFS_Instructions);
+  flow.instructionExecutionInfo.reserve(instructionCount);
+
+  for (size_t i = 0; i < instructionCount; i++)
+  {
+    const FlowFileInstruction &_instruction = view.pInstructions[i];
+
+    InstructionInfo &instruction = flow.instructionExecutionInfo.emplace_back((size_t)_instruction.instructionIndex, (size_t)_instruction.byteOffset, (size_t)_instruction.length, _instruction.opcode);
+    instruction.uOpCount = _instruction.uOpCount;
+    instruction.disassembly = getString(_instruction.disassembly);
+    getClocks(_instruction.clocks, instruction);
+    getUsage(_instruction.usage, instruction.usage);
+
+    for (size_t j = _instruction.stallInfo.begin; j < _instruction.stallInfo.begin + _instruction.stallInfo.count; j++)
+      instruction.stallInfo.push_back(getString(view.pStallInfo[j]));
+
+    instruction.physicalRegistersObstructedPerRegisterType.assign(view.pObstructedRegisters + _instruction.obstructedRegisters.begin, view.pObstructedRegisters + _instruction.obstructedRegisters.begin + _instruction.obstructedRegisters.count);
+
+    instruction.perIteration.resize(_instruction.records.count);
+
+    for (size_t j = 0; j < _instruction.records.count; j++)
+    {
+      const FlowFileRecord &_record = view.pRecords[_instruction.records.begin + j];
+      LoopInstructionInfo &record = instruction.perIteration[j];
+
+      getClocks(_record.clocks, record);
+      getUsage(_record.usage, record.usage);
+      record.totalPressureCycles = _record.totalPressureCycles;
+
+      record.registerPressure.totalPressureCycles = _record.registerTotalPressureCycles;
+      record.registerPressure.selfPressureCycles = _record.registerSelfPressureCycles;
+      record.registerPressure.origin = getOrigin(_record.registerOrigin);
+      record.registerPressure.registerName = getString(_record.registerName);
+
+      record.memoryPressure.totalPressureCycles = _record.memoryTotalPressureCycles;
+      record.memoryPressure.selfPressureCycles = _record.memorySelfPressureCycles;
+      record.memoryPressure.origin = getOrigin(_record.memoryOrigin);
+
+      record.resourcePressure.totalPressureCycles = _record.resourceTotalPressureCycles;
+      record.resourcePressure.associatedResources.reserve(_record.resourceDependencies.count);
+
+      for (size_t k = _record.resourceDependencies.begin; k < _record.resourceDependencies.begin + _record.resourceDependencies.count; k++)
+      {
+        const FlowFileResourceDependency &_dependency = view.pResourceDependencies[k];
+
+        ResourceTypeDependencyInfo &dependency = record.resourcePressure.associatedResources.emplace_back((size_t)_dependency.resourceTypeIndex, (size_t)_dependency.firstMatchingPortIndex, getString(_dependency.name));
+        dependency.pressureCycles = _dependency.pressureCycles;
+        dependency.origin = getOrigin(_dependency.origin);
+      }
+    }
+
+    InstructionStatistics &statistics = instruction.statistics;
+    statistics.iterations = _instruction.iterations;
+    statistics.totalDispatched = _instruction.totalDispatched;
+    statistics.totalPending = _instruction.totalPending;
+    statistics.totalReady = _instruction.totalReady;
+    statistics.totalExecuting = _instruction.totalExecuting;
+    statistics.totalRetiring = _instruction.totalRetiring;
+    statistics.minLatency = _instruction.minLatency;
+    statistics.maxLatency = _instruction.maxLatency;
+    statistics.stallCount = _instruction.stallCount;
+  }
+
+  flow.firstRetainedIteration = header.firstRetainedIteration;
+
+  if (header.codeAddress != FlowFileNone)
+    flow.codeAddress = header.codeAddress;
+
+  FlowStatistics &statistics = flow.statistics;
+  statistics.retiredIterations = header.retiredIterations;
+  statistics.firstDispatch = header.firstDispatch;
+  statistics.lastRetire = header.lastRetire;
+  statistics.firstIssued = header.firstIssued;
+  statistics.lastExecuted = header.lastExecuted;
+  statistics.totalUOps = header.totalUOps;
+  statistics.portPressureCycles.assign(view.pPortPressureCycles, view.pPortPressureCycles + view.count(FFS_PortPressureCycles));
+  statistics.portBusyCycles.assign(view.pPortBusyCycles, view.pPortBusyCycles + view.count(FFS_PortBusyCycles));
+  statistics.simulatedCycles = header.simulatedCycles;
+  statistics.reorderBufferSize = header.reorderBufferSize;
+  statistics.maxInFlightInstructions = header.maxInFlightInstructions;
+  statistics.maxInFlightUOps = header.maxInFlightUOps;
+  statistics.totalInFlightInstructionCycles = header.totalInFlightInstructionCycles;
+  statistics.totalInFlightUOpCycles = header.totalInFlightUOpCycles;
+
+  for (size_t i = 0; i < _ST_Count; i++)
+    statistics.stallCounts[i] = (size_t)header.stallCounts[i];
+  statistics.inFlightUOpHistogram.assign(view.pInFlightUOpHistogram, view.pInFlightUOpHistogram + view.count(FFS_InFlightUOpHistogram));
+
+  flow.steadyState.converged = header.converged != 0;
+  flow.steadyState.warmUpIterations = header.warmUpIterations;
+  flow.steadyState.simulatedIterations = header.simulatedIterations;
+  flow.steadyState.cyclesPerIteration = header.cyclesPerIteration;
+  flow.steadyState.iterationLatency = header.iterationLatency;
+
+  const size_t timelinePortCount = view.count(FFS_TimelineOffsets) - 1;
+  flow.cycleTimeline.portBusyIntervals.resize(timelinePortCount);
+
+  for (size_t i = 0; i < timelinePortCount; i++)
+  {
+    std::vector<CycleInterval> &intervals = flow.cycleTimeline.portBusyIntervals[i];
+    intervals.reserve(view.pTimelineOffsets[i + 1] - view.pTimelineOffsets[i]);
+
+    for (size_t j = view.pTimelineOffsets[i]; j < view.pTimelineOffsets[i + 1]; j++)
+      intervals.emplace_back(view.pTimelineIntervals[j].firstCycle, view.pTimelineIntervals[j].cycleCount);
+  }
+
+  *pFlow = std::move(flow);
+
+  return true;
+}
+
+bool flow_file_save(const PortUsageFlow &flow, const uint64_t key, const char *filename)
+{
+  if (filename == nullptr)
+    return false;
+
+  std::vector<uint8_t> bytes;
+
+  if (!flow_file_write(flow, key, bytes))
+    return false;
+
+  int fd = -1;
+  llvm::SmallString<256> temporaryPath;
+
+  if (llvm::sys::fs::createUniqueFile(llvm::Twine(filename) + ".%%%%%%%%.tmp", fd, temporaryPath))
+    return false;
+
+  bool failed = false;
+
+  {
+    llvm::raw_fd_ostream stream(fd, true);
+    stream.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    stream.close();
+
+    if (stream.has_error())
+    {
+      stream.clear_error();
+      failed = true;
+    }
+  }
+
+  if (failed || llvm::sys::fs::rename(temporaryPath, filename))
+  {
+    llvm::sys::fs::remove(temporaryPath);
+    return false;
+  }
+
+  return true;
+}
+
+bool execution_flow_save(const PortUsageFlow &flow, const char *filename)
+{
+  return flow_file_save(flow, 0, filename);
+}
+
+bool execution_flow_load(const char *filename, FlowFileView **ppView)
+{
+  if (filename == nullptr || ppView == nullptr)
+    return false;
+
+  llvm::Expected<llvm::sys::fs::file_t> file = llvm::sys::fs::openNativeFileForRead(filename);
+
+  if (!file)
+  {
+    llvm::consumeError(file.takeError());
+    return false;
+  }
+
+  llvm::sys::fs::file_status status;
+  std::error_code error = llvm::sys::fs::status(*file, status);
+
+  if (error || status.getSize() < sizeof(FlowFileHeader))
+  {
+    llvm::sys::fs::closeFile(*file);
+    return false;
+  }
+
+  const size_t size = (size_t)status.getSize();
+
+  std::unique_ptr<FlowFileMappedView> view = std::make_unique<FlowFileMappedView>();
+
+  // The mapping stays valid after the file has been closed.
+  view->region = llvm::sys::fs::mapped_file_region(*file, llvm::sys::fs::mapped_file_region::readonly, size, 0, error);
+  llvm::sys::fs::closeFile(*file);
+
+  if (error || !flow_file_init_view(view->region.const_data(), size, *view))
+    return false;
+
+  *ppView = view.release();
+
+  return true;
+}
+
+bool execution_flow_load(const void *pData, const size_t size, FlowFileView **ppView)
+{
+  if (ppView == nullptr)
+    return false;
+
+  std::unique_ptr<FlowFileMappedView> view = std::make_unique<FlowFileMappedView>();
+
+  if (!flow_file_init_view(pData, size, *view))
+    return false;
+
+  *ppView = view.release();
+
+  return true;
+}
+
+void execution_flow_view_destroy(FlowFileView **ppView)
+{
+  if (ppView == nullptr || *ppView == nullptr)
+    return;
+
+  // All views are created as `FlowFileMappedView`.
+  delete static_cast<FlowFileMappedView *>(*ppView);
+  *ppView = nullptr;
+}
+////////////////////////////////////////////////////////////////////////////////
+
+static FlowFileString flow_file_add_string(FlowFileBuilder &builder, const std::string &string)
+{
+  const auto &entry = builder.internedStrings.try_emplace(string, FlowFileString{ (uint32_t)builder.strings.size(), (uint32_t)string.size() });
+
+  if (entry.second)
+  {
+    if (builder.strings.size() + string.size() > UINT32_MAX)
+      builder.overflow = true;
+
+    builder.strings.append(string);
+  }
+
+  return entry.first->second;
+}
+
+static FlowFileOrigin flow_file_to_origin(const std::optional<DependencyOrigin> &origin)
+{
+  if (!origin.has_value())
+    return { FlowFileNone, FlowFileNone };
+
+  return { origin.value().iterationIndex, origin.value().instructionIndex };
+}
+
+static FlowFileClocks flow_file_to_clocks(const BasicInstructionInfo &info)
+{
+  return { info.clockDispatched, info.clockPending, info.clockReady, info.clockIssued, info.clockExecuted, info.clockRetired, info.uOps };
+}
+
+static FlowFileRange flow_file_add_usage(FlowFileBuilder &builder, const std::vector<ResourcePressureInfo> &usage)
+{
+  const FlowFileRange range = { builder.usage.size(), usage.size() };
+
+  for (const auto &_usage : usage)
+    builder.usage.push_back({ _usage.resourceIndex, _usage.pressure });
+
+  return range;
+}
+
+static void flow_file_add_record(FlowFileBuilder &builder, const LoopInstructionInfo &info)
+{
+  FlowFileRecord record;
+  memset(&record, 0, sizeof(record));
+
+  record.clocks = flow_file_to_clocks(info);
+  record.usage = flow_file_add_usage(builder, info.usage);
+  record.totalPressureCycles = info.totalPressureCycles;
+
+  record.registerTotalPressureCycles = info.registerPressure.totalPressureCycles;
+  record.registerSelfPressureCycles = info.registerPressure.selfPressureCycles;
+  record.registerOrigin = flow_file_to_origin(info.registerPressure.origin);
+  record.registerName = flow_file_add_string(builder, info.registerPressure.registerName);
+
+  record.memoryTotalPressureCycles = info.memoryPressure.totalPressureCycles;
+  record.memorySelfPressureCycles = info.memoryPressure.selfPressureCycles;
+  record.memoryOrigin = flow_file_to_origin(info.memoryPressure.origin);
+
+  record.resourceTotalPressureCycles = info.resourcePressure.totalPressureCycles;
+  record.resourceDependencies.begin = builder.resourceDependencies.size();
+
+  for (const auto &_dependency : info.resourcePressure.associatedResources)
+    builder.resourceDependencies.push_back({ _dependency.resourceTypeIndex, _dependency.firstMatchingPortIndex, flow_file_add_string(builder, _dependency.resourceName), _dependency.pressureCycles, flow_file_to_origin(_dependency.origin) });
+
+  record.resourceDependencies.count = builder.resourceDependencies.size() - record.resourceDependencies.begin;
+
+  builder.records.push_back(record);
+}
+
+// Expands a record of `PortUsageFlow::columns` back into a `LoopInstructionInfo`, with origins turned into absolute iteration indices.
+static void flow_file_get_column_record(const PortUsageFlow &flow, const size_t record, LoopInstructionInfo &info)
+{
+  const FlowColumns &columns = flow.columns;
+
+  auto getOrigin = [&](const uint32_t originRecord) -> std::optional<DependencyOrigin>
+  {
+    if (originRecord == FlowColumns::None)
+      return std::nullopt;
+
+    return DependencyOrigin(flow.firstRetainedIteration + originRecord / columns.instructionCount, originRecord % columns.instructionCount);
+  };
+
+  auto getName = [&](const uint32_t nameId) -> const std::string &
+  {
+    static const std::string empty;
+    return nameId < columns.names.size() ? columns.names[nameId] : empty;
+  };
+
+  info = LoopInstructionInfo();
+
+  info.clockDispatched = columns.clockDispatched[record];
+  info.clockPending = columns.clockPending[record];
+  info.clockReady = columns.clockReady[record];
+  info.clockIssued = columns.clockIssued[record];
+  info.clockExecuted = columns.clockExecuted[record];
+  info.clockRetired = columns.clockRetired[record];
+  info.uOps = columns.uOps[record];
+
+  for (size_t i = columns.usageBegin[record]; i < (size_t)columns.usageBegin[record] + columns.usageCount[record]; i++)
+    info.usage.emplace_back(columns.usage[i].portIndex, columns.usage[i].pressure);
+
+  info.registerPressure.totalPressureCycles = columns.registerTotalPressureCycles[record];
+  info.registerPressure.selfPressureCycles = columns.registerPressureCycles[record];
+  info.registerPressure.origin = getOrigin(columns.registerOrigin[record]);
+  info.registerPressure.registerName = getName(columns.registerNameId[record]);
+
+  info.memoryPressure.totalPressureCycles = columns.memoryTotalPressureCycles[record];
+  info.memoryPressure.selfPressureCycles = columns.memoryPressureCycles[record];
+  info.memoryPressure.origin = getOrigin(columns.memoryOrigin[record]);
+
+  info.resourcePressure.totalPressureCycles = columns.resourceTotalPressureCycles[record];
+
+  for (uint32_t link = columns.resourceDependencyHead[record]; link != FlowColumns::None; link = columns.resourceDependencies[link].next)
+  {
+    const FlowColumnResourceDependency &_dependency = columns.resourceDependencies[link];
+
+    ResourceTypeDependencyInfo &dependency = info.resourcePressure.associatedResources.emplace_back(_dependency.resourceTypeIndex == FlowColumns::None ? (size_t)-1 : _dependency.resourceTypeIndex, _dependency.firstMatchingPortIndex == FlowColumns::None ? (size_t)-1 : _dependency.firstMatchingPortIndex, getName(_dependency.nameId));
+    dependency.pressureCycles = _dependency.pressureCycles;
+    dependency.origin = getOrigin(_dependency.origin);
+  }
+}
+
+template <typename T>
+static void flow_file_append_section(std::vector<uint8_t> &bytes, FlowFileHeader &header, const FlowFileSectionType type, const T *pData, const size_t count)
+{
+  bytes.resize((bytes.size() + 7) & ~(size_t)7);
+
+  header.sections[type].offset = bytes.size();
+  header.sections[type].count = count;
+
+  if (count != 0)
+  {
+    const size_t offset = bytes.size();
+    bytes.resize(offset + sizeof(T) * count);
+    memcpy(bytes.data() + offset, pData, sizeof(T) * count);
+  }
+}
+
+template <typename T>
+static bool flow_file_get_section(const uint8_t *pData, const FlowFileHeader &header, const FlowFileSectionType type, const T **ppSection)
+{
+  const FlowFileSection &section = header.sections[type];
+
+  if ((section.offset & 7) != 0 || section.offset < sizeof(FlowFileHeader) || section.offset > header.fileSize || section.count > (header.fileSize - section.offset) / sizeof(T))
+    return false;
+
+  *ppSection = reinterpret_cast<const T *>(pData + section.offset);
+
+  return true;
+}
+
+// Validates everything once, so neither `execution_flow_view_get_flow` nor any other consumer of the view has to check ranges again.
+static bool flow_file_init_view(const void *pData, const size_t size, FlowFileView &view)
+{
+  if constexpr (llvm::sys::IsBigEndianHost)
+    return false;
+
+  // Sections are accessed in place, so the data has to be at least as aligned as the file.
+  if (pData == nullptr || ((uintptr_t)pData & 7) != 0 || size < sizeof(FlowFileHeader))
+    return false;
+
+  const uint8_t *pBytes = reinterpret_cast<const uint8_t *>(pData);
+  const FlowFileHeader &header = *reinterpret_cast<const FlowFileHeader *>(pBytes);
+
+  if (memcmp(header.magic, FlowFileMagic, sizeof(FlowFileMagic)) != 0 || header.version != FlowFileVersion || header.headerSize != sizeof(FlowFileHeader) || header.fileSize != size)
+    return false;
+
+  if (!flow_file_get_section(pBytes, header, FFS_Strings, &view.pStrings)
+    || !flow_file_get_section(pBytes, header, FFS_Ports, &view.pPorts)
+    || !flow_file_get_section(pBytes, header, FFS_Registers, &view.pRegisters)
+    || !flow_file_get_section(pBytes, header, FFS_Instructions, &view.pInstructions)
+    || !flow_file_get_section(pBytes, header, FFS_Records, &view.pRecords)
+    || !flow_file_get_section(pBytes, header, FFS_Usage, &view.pUsage)
+    || !flow_file_get_section(pBytes, header, FFS_ResourceDependencies, &view.pResourceDependencies)
+    || !flow_file_get_section(pBytes, header, FFS_StallInfo, &view.pStallInfo)
+    || !flow_file_get_section(pBytes, header, FFS_ObstructedRegisters, &view.pObstructedRegisters)
+    || !flow_file_get_section(pBytes, header, FFS_PortPressureCycles, &view.pPortPressureCycles)
+    || !flow_file_get_section(pBytes, header, FFS_PortBusyCycles, &view.pPortBusyCycles)
+    || !flow_file_get_section(pBytes, header, FFS_InFlightUOpHistogram, &view.pInFlightUOpHistogram)
+    || !flow_file_get_section(pBytes, header, FFS_TimelineOffsets, &view.pTimelineOffsets)
+    || !flow_file_get_section(pBytes, header, FFS_TimelineIntervals, &view.pTimelineIntervals))
+    return false;
+
+  const uint64_t stringsSize = header.sections[FFS_Strings].count;
+
+  auto isValidString = [&](const FlowFileString &string)
+  {
+    return (uint64_t)string.offset + string.length <= stringsSize;
+  };
+
+  auto isValidRange = [&](const FlowFileRange &range, const FlowFileSectionType type)
+  {
+    const uint64_t count = header.sections[type].count;
+    return range.begin <= count && range.count <= count - range.begin;
+  };
+
+  for (uint64_t i = 0; i < header.sections[FFS_Ports].count; i++)
+    if (!isValidString(view.pPorts[i].name))
+      return false;
+
+  for (uint64_t i = 0; i < header.sections[FFS_Registers].count; i++)
+    if (!isValidString(view.pRegisters[i].name))
+      return false;
+
+  for (uint64_t i = 0; i < header.sections[FFS_StallInfo].count; i++)
+    if (!isValidString(view.pStallInfo[i]))
+      return false;
+
+  // Indices into other sections are used as subscripts by consumers (e.g. `PortUsageFlow::ports[ResourcePressureInfo::resourceIndex]`), so they have to be in range as well.
+  const uint64_t portCount = header.sections[FFS_Ports].count;
+  const uint64_t instructionCount = header.sections[FFS_Instructions].count;
+
+  auto isValidOrigin = [&](const FlowFileOrigin &origin)
+  {
+    return origin.instructionIndex == FlowFileNone || origin.instructionIndex < instructionCount;
+  };
+
+  for (uint64_t i = 0; i < instructionCount; i++)
+  {
+    const FlowFileInstruction &instruction = view.pInstructions[i];
+
+    if (instruction.instructionIndex != i || !isValidString(instruction.disassembly) || !isValidRange(instruction.usage, FFS_Usage) || !isValidRange(instruction.stallInfo, FFS_StallInfo) || !isValidRange(instruction.obstructedRegisters, FFS_ObstructedRegisters) || !isValidRange(instruction.records, FFS_Records))
+      return false;
+  }
+
+  for (uint64_t i = 0; i < header.sections[FFS_Records].count; i++)
+  {
+    const FlowFileRecord &record = view.pRecords[i];
+
+    if (!isValidString(record.registerName) || !isValidRange(record.usage, FFS_Usage) || !isValidRange(record.resourceDependencies, FFS_ResourceDependencies) || !isValidOrigin(record.registerOrigin) || !isValidOrigin(record.memoryOrigin))
+      return false;
+  }
+
+  for (uint64_t i = 0; i < header.sections[FFS_Usage].count; i++)
+    if (view.pUsage[i].portIndex >= portCount)
+      return false;
+
+  for (uint64_t i = 0; i < header.sections[FFS_ResourceDependencies].count; i++)
+  {
+    const FlowFileResourceDependency &dependency = view.pResourceDependencies[i];
+
+    if (!isValidString(dependency.name) || !isValidOrigin(dependency.origin))
+      return false;
+
+    // Resource types without a matching port have neither index.
+    if (dependency.firstMatchingPortIndex == FlowFileNone ? dependency.resourceTypeIndex != FlowFileNone : (dependency.firstMatchingPortIndex >= portCount || dependency.resourceTypeIndex != view.pPorts[dependency.firstMatchingPortIndex].resourceTypeIndex))
+      return false;
+  }
+
+  // Per-port statistics are either not collected or available for every port.
+  if ((header.sections[FFS_PortPressureCycles].count != 0 && header.sections[FFS_PortPressureCycles].count != portCount) || (header.sections[FFS_PortBusyCycles].count != 0 && header.sections[FFS_PortBusyCycles].count != portCount))
+    return false;
+
+  // One offset per port + the end of the last port.
+  const uint64_t timelineOffsetCount = header.sections[FFS_TimelineOffsets].count;
+
+  if (timelineOffsetCount == 0 || (timelineOffsetCount != 1 && timelineOffsetCount != portCount + 1) || view.pTimelineOffsets[0] != 0 || view.pTimelineOffsets[timelineOffsetCount - 1] != header.sections[FFS_TimelineIntervals].count)
+    return false;
+
+  for (uint64_t i = 0; i + 1 < timelineOffsetCount; i++)
+    if (view.pTimelineOffsets[i] > view.pTimelineOffsets[i + 1])
+      return false;
+
+  view.pHeader = &header;
+
+  return true;
+}
@@ -28,8 +28,12 @@
 
 #include "FlowView.h"
 
+#include "llvm/ADT/SmallString.h"
 #include "llvm/MCA/Support.h"
 
+#include <algorithm>
+#include <cmath>
+
 #ifdef _MSC_VER
 
 #ifdef assert
@@ -52,6 +56,8 @@ void FlowView::onEvent(const llvm::mca::HWInstructionEvent &evnt)
   const size_t instructionIndex = evnt.IR.getSourceIndex() % instructionCount;
   const size_t runIndex = evnt.IR.getSourceIndex() / instructionCount;
 
+  const size_t record = evnt.IR.getSourceIndex();
+
   InstructionInfo &instructionInfo = pFlow->instructionExecutionInfo[instructionIndex];
 
   if (!hasFirstObservedInstructionClock)
@@ -60,6 +66,9 @@ void FlowView::onEvent(const llvm::mca::HWInstructionEvent &evnt)
     firstObservedInstructionClock = instructionClock;
   }
 
+  // In `CollectionLevel::Summary` only the in-flight record is kept & folded into the statistics on retirement.
+  const bool collectIterations = (collectionLevel == CollectionLevel::Full);
+
   switch (evnt.Type)
   {
   case llvm::mca::HWInstructionEvent::Dispatched:
@@ -83,14 +92,20 @@ void FlowView::onEvent(const llvm::mca::HWInstructionEvent &evnt)
       }
     }
 
-    if (instructionInfo.perIteration.size() <= runIndex)
-      instructionInfo.perIteration.resize(runIndex + 1);
-
-    instructionInfo.perIteration[runIndex].clockDispatched = instructionClock;
-    instructionInfo.perIteration[runIndex].uOps = dispatchedEvent.MicroOpcodes;
+    if (pColumns != nullptr)
+    {
+      pColumns->clockDispatched[record] = (uint32_t)instructionClock;
+      pColumns->uOps[record] = dispatchedEvent.MicroOpcodes;
+    }
+    else if (collectIterations)
+    {
+      LoopInstructionInfo &iterationInfo = getIterationInfo(instructionInfo, runIndex);
+      iterationInfo.clockDispatched = instructionClock;
+      iterationInfo.uOps = dispatchedEvent.MicroOpcodes;
+    }
 
-    // Keep this instruction in-flight till it's been executed.
-    inFlightInstructions.insert(std::make_pair(std::make_pair(runIndex, instructionIndex), true));
+    // Keep this instruction in-flight till it's been retired.
+    addInFlightInstruction(record, dispatchedEvent.MicroOpcodes);
 
     break;
   }
@@ -100,10 +115,12 @@ void FlowView::onEvent(const llvm::mca::HWInstructionEvent &evnt)
     if (runIndex == relevantIteration)
       instructionInfo.clockReady = instructionClock - firstObservedInstructionClock;
 
-    if (instructionInfo.perIteration.size() <= runIndex)
-      instructionInfo.perIteration.resize(runIndex + 1);
+    getInFlightInstruction(record).clockReady = instructionClock;
 
-    instructionInfo.perIteration[runIndex].clockReady = instructionClock;
+    if (pColumns != nullptr)
+      pColumns->clockReady[record] = (uint32_t)instructionClock;
+    else if (collectIterations)
+      getIterationInfo(instructionInfo, runIndex).clockReady = instructionClock;
 
     break;
   }
@@ -113,12 +130,19 @@ void FlowView::onEvent(const llvm::mca::HWInstructionEvent &evnt)
     if (runIndex == relevantIteration)
       instructionInfo.clockExecuted = instructionClock - firstObservedInstructionClock;
 
-    if (instructionInfo.perIteration.size() <= runIndex)
-      instructionInfo.perIteration.resize(runIndex + 1);
+    InFlightInstruction &inFlight = getInFlightInstruction(record);
+    inFlight.clockExecuted = instructionClock;
+
+    // The ports aren't busy with this instruction anymore.
+    for (const uint32_t _port : inFlight.ports)
+      busyPortInstructionCount[_port]--;
 
-    instructionInfo.perIteration[runIndex].clockExecuted = instructionClock;
+    inFlight.ports.clear();
 
-    inFlightInstructions.erase(std::make_pair(runIndex, instructionIndex));
+    if (pColumns != nullptr)
+      pColumns->clockExecuted[record] = (uint32_t)instructionClock;
+    else if (collectIterations)
+      getIterationInfo(instructionInfo, runIndex).clockExecuted = instructionClock;
 
     break;
   }
@@ -128,10 +152,13 @@ void FlowView::onEvent(const llvm::mca::HWInstructionEvent &evnt)
     if (runIndex == relevantIteration)
       instructionInfo.clockPending = instructionClock - firstObservedInstructionClock;
 
-    if (instructionInfo.perIteration.size() <= runIndex)
-      instructionInfo.perIteration.resize(runIndex + 1);
+    getInFlightInstruction(record).clockPending = instructionClock;
+
+    if (pColumns != nullptr)
+      pColumns->clockPending[record] = (uint32_t)instructionClock;
+    else if (collectIterations)
+      getIterationInfo(instructionInfo, runIndex).clockPending = instructionClock;
 
-    instructionInfo.perIteration[runIndex].clockPending = instructionClock;
     break;
   }
 
@@ -143,10 +170,29 @@ void FlowView::onEvent(const llvm::mca::HWInstructionEvent &evnt)
     if (runIndex == relevantIteration)
       instructionInfo.clockRetired = instructionClock - firstObservedInstructionClock;
 
-    if (instructionInfo.perIteration.size() <= runIndex)
-      instructionInfo.perIteration.resize(runIndex + 1);
+    if (pColumns != nullptr)
+      pColumns->clockRetired[record] = (uint32_t)instructionClock;
+    else if (collectIterations)
+      getIterationInfo(instructionInfo, runIndex).clockRetired = instructionClock;
+
+    const InFlightInstruction &inFlight = getInFlightInstruction(record);
+
+    BasicInstructionInfo iterationInfo;
+    iterationInfo.clockDispatched = inFlight.clockDispatched;
+    iterationInfo.clockPending = inFlight.clockPending;
+    iterationInfo.clockReady = inFlight.clockReady;
+    iterationInfo.clockIssued = inFlight.clockIssued;
+    iterationInfo.clockExecuted = inFlight.clockExecuted;
+    iterationInfo.clockRetired = instructionClock;
+    iterationInfo.uOps = inFlight.uOps;
+
+    addToStatistics(instructionInfo, iterationInfo);
 
-    instructionInfo.perIteration[runIndex].clockRetired = instructionClock;
+    removeInFlightInstruction(record);
+
+    // Instructions retire in order, so once the last one has retired, the entire iteration is done.
+    if (instructionIndex + 1 == instructionCount)
+      onIterationRetired(runIndex);
 
     break;
   }
@@ -158,27 +204,53 @@ void FlowView::onEvent(const llvm::mca::HWInstructionEvent &evnt)
     if (runIndex == relevantIteration)
       instructionInfo.clockIssued = instructionClock - firstObservedInstructionClock;
 
-    if (instructionInfo.perIteration.size() <= runIndex)
-      instructionInfo.perIteration.resize(runIndex + 1);
+    InFlightInstruction &inFlight = getInFlightInstruction(record);
+    inFlight.clockIssued = instructionClock;
 
-    instructionInfo.perIteration[runIndex].clockIssued = instructionClock;
+    LoopInstructionInfo *pIterationInfo = nullptr;
+
+    if (pColumns != nullptr)
+    {
+      pColumns->clockIssued[record] = (uint32_t)instructionClock;
+      pColumns->usageBegin[record] = (uint32_t)pColumns->usage.size();
+    }
+    else if (collectIterations)
+    {
+      pIterationInfo = &getIterationInfo(instructionInfo, runIndex);
+      pIterationInfo->clockIssued = instructionClock;
+    }
 
     for (const auto &resourceUsage : issuedEvent.UsedResources)
     {
-      if (!llvmResource2ListedResourceIdx.contains(resourceUsage.first))
+      const size_t portIndex = getPortIndex(resourceUsage.first.first, resourceUsage.first.second);
+
+      if (portIndex == (size_t)-1)
       {
         assert(false && "The resource lookup doesn't contain this resource.");
         continue;
       }
 
-      const size_t portIndex = llvmResource2ListedResourceIdx[resourceUsage.first];
-
       if (runIndex == relevantIteration)
         instructionInfo.usage.push_back(ResourcePressureInfo(portIndex, (double)resourceUsage.second));
 
-      instructionInfo.perIteration[runIndex].usage.push_back(ResourcePressureInfo(portIndex, (double)resourceUsage.second));
+      if (pColumns != nullptr)
+        pColumns->usage.emplace_back((uint32_t)portIndex, (float)(double)resourceUsage.second);
+      else if (pIterationInfo != nullptr)
+        pIterationInfo->usage.push_back(ResourcePressureInfo(portIndex, (double)resourceUsage.second));
+
+      pFlow->statistics.portPressureCycles[portIndex] += (double)resourceUsage.second;
+
+      // The port is busy till the instruction has been executed.
+      inFlight.ports.push_back((uint32_t)portIndex);
+      busyPortInstructionCount[portIndex]++;
     }
 
+    if (pColumns != nullptr)
+      pColumns->usageCount[record] = (uint32_t)pColumns->usage.size() - pColumns->usageBegin[record];
+
+    if (!collectIterations)
+      break;
+
     const llvm::mca::Instruction *pInstruction = evnt.IR.getInstruction();
     
     // Handle Resource Dependency.
@@ -225,43 +297,67 @@ void FlowView::onEvent(const llvm::mca::HWStallEvent &evnt)
   const size_t runIndex = evnt.IR.getSourceIndex() / instructionCount;
 
   InstructionInfo &instructionInfo = pFlow->instructionExecutionInfo[instructionIndex];
+  instructionInfo.statistics.stallCount++;
+
+  StallType stallType;
 
   switch (evnt.Type)
   {
   case llvm::mca::HWStallEvent::RegisterFileStall:
-    instructionInfo.stallInfo.emplace_back(std::string("Stall in Loop ") + std::to_string(runIndex) + ": Register Unavailable");
+    stallType = ST_RegisterUnavailable;
     break;
 
   case llvm::mca::HWStallEvent::RetireControlUnitStall:
-    instructionInfo.stallInfo.emplace_back(std::string("Stall in Loop ") + std::to_string(runIndex) + ": Retire Tokens Unavailable");
+    stallType = ST_RetireTokensUnavailable;
     break;
 
   case llvm::mca::HWStallEvent::DispatchGroupStall:
-    instructionInfo.stallInfo.emplace_back(std::string("Stall in Loop ") + std::to_string(runIndex) + ": Static Restrictions on the Dispatch Group");
+    stallType = ST_DispatchGroup;
     break;
 
   case llvm::mca::HWStallEvent::SchedulerQueueFull:
-    instructionInfo.stallInfo.emplace_back(std::string("Stall in Loop ") + std::to_string(runIndex) + ": Scheduler Queue Full");
+    stallType = ST_SchedulerQueueFull;
     break;
 
   case llvm::mca::HWStallEvent::LoadQueueFull:
-    instructionInfo.stallInfo.emplace_back(std::string("Stall in Loop ") + std::to_string(runIndex) + ": Load Queue Full");
+    stallType = ST_LoadQueueFull;
     break;
 
   case llvm::mca::HWStallEvent::StoreQueueFull:
-    instructionInfo.stallInfo.emplace_back(std::string("Stall in Loop ") + std::to_string(runIndex) + ": Store Queue Full");
+    stallType = ST_StoreQueueFull;
     break;
 
   case llvm::mca::HWStallEvent::CustomBehaviourStall:
-    instructionInfo.stallInfo.emplace_back(std::string("Stall in Loop ") + std::to_string(runIndex) + ": Structural Hazard");
+    stallType = ST_StructuralHazard;
     break;
+
+  default:
+    return;
   }
+
+  pFlow->statistics.stallCounts[stallType]++;
+
+  if (runIndex < firstStallInfoIteration || collectionLevel != CollectionLevel::Full)
+    return;
+
+  if (stallInfoIterations.size() < instructionCount)
+    stallInfoIterations.resize(instructionCount);
+
+  stallInfoIterations[instructionIndex].push_back(runIndex);
+
+  static const char *StallTypeDescriptions[] = { "Register Unavailable", "Retire Tokens Unavailable", "Static Restrictions on the Dispatch Group", "Scheduler Queue Full", "Load Queue Full", "Store Queue Full", "Structural Hazard" };
+  static_assert(sizeof(StallTypeDescriptions) / sizeof(StallTypeDescriptions[0]) == _ST_Count, "Invalid stall type description count.");
+
+  instructionInfo.stallInfo.emplace_back(std::string("Stall in Loop ") + std::to_string(runIndex) + ": " + StallTypeDescriptions[stallType]);
 }
 
 void FlowView::onEvent(const llvm::mca::HWPressureEvent &evnt)
 {
   const size_t instructionCount = pFlow->instructionExecutionInfo.size();
   assert(instructionCount > 0 && "There should already be a reference to all instructions in this vector.");
+
+  if (collectionLevel != CollectionLevel::Full)
+    return;
   
   for (const llvm::mca::InstRef &_inst : evnt.AffectedInstructions)
   {
@@ -269,17 +365,18 @@ void FlowView::onEvent(const llvm::mca::HWPressureEvent &evnt)
     const size_t runIndex = _inst.getSourceIndex() / instructionCount;
   
     InstructionInfo &instructionInfo = pFlow->instructionExecutionInfo[instructionIndex];
+    const size_t record = _inst.getSourceIndex();
     
-    if (instructionInfo.perIteration.size() <= runIndex)
-      instructionInfo.perIteration.resize(runIndex + 1);
-  
-    LoopInstructionInfo &occurence = instructionInfo.perIteration[runIndex];
+    LoopInstructionInfo *pOccurence = pColumns != nullptr ? nullptr : &getIterationInfo(instructionInfo, runIndex);
   
     switch (evnt.Reason)
     {
     case llvm::mca::HWPressureEvent::RESOURCES:
     {
-      occurence.resourcePressure.totalPressureCycles++;
+      if (pColumns != nullptr)
+        pColumns->resourceTotalPressureCycles[record]++;
+      else
+        pOccurence->resourcePressure.totalPressureCycles++;
   
       const llvm::mca::Instruction *pMcaInstruction = _inst.getInstruction();
       uint64_t criticalResources = pMcaInstruction->getCriticalResourceMask() & evnt.ResourceMask;
@@ -297,11 +394,17 @@ void FlowView::onEvent(const llvm::mca::HWPressureEvent &evnt)
     }
   
     case llvm::mca::HWPressureEvent::REGISTER_DEPS:
-      occurence.registerPressure.totalPressureCycles++;
+      if (pColumns != nullptr)
+        pColumns->registerTotalPressureCycles[record]++;
+      else
+        pOccurence->registerPressure.totalPressureCycles++;
       break;
   
     case llvm::mca::HWPressureEvent::MEMORY_DEPS:
-      occurence.memoryPressure.totalPressureCycles++;
+      if (pColumns != nullptr)
+        pColumns->memoryTotalPressureCycles[record]++;
+      else
+        pOccurence->memoryPressure.totalPressureCycles++;
       break;
 
     default:
@@ -310,9 +413,47 @@ void FlowView::onEvent(const llvm::mca::HWPressureEvent &evnt)
   }
 }
 
-void FlowView::addLLVMResourceToPortIndexLookup(const std::pair<std::pair<size_t, size_t>, size_t> &keyValuePair)
+void FlowView::onCycleEnd()
+{
+  FlowStatistics &stats = pFlow->statistics;
+
+  stats.simulatedCycles++;
+  stats.totalInFlightInstructionCycles += inFlightInstructionCount;
+  stats.totalInFlightUOpCycles += inFlightUOpCount;
+  stats.maxInFlightInstructions = std::max(stats.maxInFlightInstructions, inFlightInstructionCount);
+  stats.maxInFlightUOps = std::max(stats.maxInFlightUOps, inFlightUOpCount);
+
+  if (stats.inFlightUOpHistogram.size() <= inFlightUOpCount)
+    stats.inFlightUOpHistogram.resize(inFlightUOpCount + 1, 0);
+
+  stats.inFlightUOpHistogram[inFlightUOpCount]++;
+
+  for (size_t i = 0; i < busyPortInstructionCount.size(); i++)
+  {
+    if (busyPortInstructionCount[i] == 0)
+      continue;
+
+    stats.portBusyCycles[i]++;
+
+    if (collectionLevel != CollectionLevel::Full)
+      continue;
+
+    // Extend the previous interval if the port was already busy last cycle.
+    std::vector<CycleInterval> &intervals = pFlow->cycleTimeline.portBusyIntervals[i];
+
+    if (!intervals.empty() && (size_t)intervals.back().firstCycle + intervals.back().cycleCount == instructionClock)
+      intervals.back().cycleCount++;
+    else
+      intervals.emplace_back((uint32_t)instructionClock, 1);
+  }
+
+  instructionClock++;
+}
+
+void FlowView::setResourceUnitToPortIndexLookup(const llvm::ArrayRef<uint32_t> lookup, const size_t unitStride)
 {
-  llvmResource2ListedResourceIdx.insert(keyValuePair);
+  resourceUnitToPortIndex = lookup;
+  resourceUnitStride = unitStride;
 }
 
 void FlowView::addRegisterFileRelevancy(const bool isRelevant)
@@ -320,19 +461,262 @@ void FlowView::addRegisterFileRelevancy(const bool isRelevant)
   isRegisterFileRelevant.push_back(isRelevant);
 }
 
+void FlowView::setRetainedIterations(const size_t retainedIterationCount, const size_t totalIterationCount)
+{
+  retainedIterations = retainedIterationCount;
+
+  // Only keep stall info for the iterations that'll still be retained in the end (if we know when that'll be).
+  if (retainedIterationCount != 0 && totalIterationCount > retainedIterationCount && !detectConvergence)
+    firstStallInfoIteration = totalIterationCount - retainedIterationCount;
+  else
+    firstStallInfoIteration = 0;
+}
+
+void FlowView::trimRetainedIterations()
+{
+  if (retainedIterations == 0)
+    return;
+
+  const size_t completedIterations = pFlow->statistics.retiredIterations - pFlow->firstRetainedIteration;
+
+  if (completedIterations <= retainedIterations)
+    return;
+
+  const size_t droppedIterations = completedIterations - retainedIterations;
+
+  for (auto &_instruction : pFlow->instructionExecutionInfo)
+    _instruction.perIteration.erase(_instruction.perIteration.begin(), _instruction.perIteration.begin() + std::min(droppedIterations, _instruction.perIteration.size()));
+
+  pFlow->firstRetainedIteration += droppedIterations;
+
+  // Drop the busy intervals that ended before the first retained iteration was dispatched.
+  {
+    size_t firstRetainedDispatch = (size_t)-1;
+
+    for (const auto &_instruction : pFlow->instructionExecutionInfo)
+      if (!_instruction.perIteration.empty())
+        firstRetainedDispatch = std::min(firstRetainedDispatch, _instruction.perIteration.front().clockDispatched);
+
+    if (firstRetainedDispatch != (size_t)-1)
+    {
+      for (auto &_intervals : pFlow->cycleTimeline.portBusyIntervals)
+      {
+        size_t droppedIntervals = 0;
+
+        while (droppedIntervals < _intervals.size() && (size_t)_intervals[droppedIntervals].firstCycle + _intervals[droppedIntervals].cycleCount <= firstRetainedDispatch)
+          droppedIntervals++;
+
+        _intervals.erase(_intervals.begin(), _intervals.begin() + droppedIntervals);
+      }
+    }
+  }
+
+  // Stalls are reported at dispatch, which happens in order, so the dropped stall info is always at the front.
+  for (size_t i = 0; i < stallInfoIterations.size(); i++)
+  {
+    std::vector<size_t> &iterations = stallInfoIterations[i];
+    std::vector<std::string> &stallInfo = pFlow->instructionExecutionInfo[i].stallInfo;
+
+    size_t droppedStallInfo = 0;
+
+    while (droppedStallInfo < iterations.size() && iterations[droppedStallInfo] < pFlow->firstRetainedIteration)
+      droppedStallInfo++;
+
+    iterations.erase(iterations.begin(), iterations.begin() + droppedStallInfo);
+    stallInfo.erase(stallInfo.begin(), stallInfo.begin() + droppedStallInfo);
+  }
+}
+
+void FlowView::setConvergenceOptions(const ConvergenceOptions &options)
+{
+  convergenceOptions = options;
+  convergenceOptions.stableIterations = std::max((size_t)1, options.stableIterations);
+  detectConvergence = true;
+
+  iterationRetireClocks.resize(convergenceOptions.stableIterations + 1, 0);
+  iterationLatencies.resize(convergenceOptions.stableIterations, 0);
+}
+
+void FlowView::setCollectionLevel(const CollectionLevel level)
+{
+  collectionLevel = level;
+}
+
+void FlowView::setColumnar(const size_t iterationCount)
+{
+  pColumns = &pFlow->columns;
+
+  const size_t instructionCount = pFlow->instructionExecutionInfo.size();
+  const size_t recordCount = iterationCount * instructionCount;
+
+  pColumns->reset(instructionCount, iterationCount);
+  columnNameIds.clear();
+
+  // Most instructions use a port or two.
+  pColumns->usage.reserve(recordCount * 2);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
+LoopInstructionInfo &FlowView::getIterationInfo(InstructionInfo &info, const size_t iterationIndex)
+{
+  assert(iterationIndex >= pFlow->firstRetainedIteration && "This iteration has already been dropped from the retained window.");
+
+  const size_t retainedIndex = iterationIndex - pFlow->firstRetainedIteration;
+
+  if (info.perIteration.size() <= retainedIndex)
+    info.perIteration.resize(retainedIndex + 1);
+
+  return info.perIteration[retainedIndex];
+}
+
+void FlowView::addToStatistics(InstructionInfo &info, const BasicInstructionInfo &iteration)
+{
+  InstructionStatistics &stats = info.statistics;
+  const size_t latency = iteration.clockRetired - iteration.clockDispatched;
+
+  stats.minLatency = stats.iterations == 0 ? latency : std::min(stats.minLatency, latency);
+  stats.maxLatency = std::max(stats.maxLatency, latency);
+  stats.iterations++;
+
+  stats.totalDispatched += iteration.clockPending - iteration.clockDispatched;
+  stats.totalPending += iteration.clockReady - iteration.clockPending;
+  stats.totalReady += iteration.clockIssued - iteration.clockReady;
+  stats.totalExecuting += iteration.clockExecuted - iteration.clockIssued;
+  stats.totalRetiring += iteration.clockRetired - iteration.clockExecuted;
+
+  FlowStatistics &flowStats = pFlow->statistics;
+
+  flowStats.firstDispatch = std::min(flowStats.firstDispatch, iteration.clockDispatched);
+  flowStats.lastRetire = std::max(flowStats.lastRetire, iteration.clockRetired);
+  flowStats.firstIssued = std::min(flowStats.firstIssued, iteration.clockIssued);
+  flowStats.lastExecuted = std::max(flowStats.lastExecuted, iteration.clockExecuted);
+  flowStats.totalUOps += iteration.uOps;
+}
+
+void FlowView::onIterationRetired(const size_t iterationIndex)
+{
+  pFlow->statistics.retiredIterations = iterationIndex + 1;
+
+  if (detectConvergence)
+    updateConvergence(iterationIndex);
+
+  // Drop in batches of `retainedIterations` to not shift the vectors around on every single iteration.
+  if (retainedIterations != 0 && pFlow->statistics.retiredIterations - pFlow->firstRetainedIteration >= retainedIterations * 2)
+    trimRetainedIterations();
+}
+
+void FlowView::updateConvergence(const size_t iterationIndex)
+{
+  SteadyStateInfo &steadyState = pFlow->steadyState;
+  steadyState.simulatedIterations = iterationIndex + 1;
+
+  if (steadyState.converged)
+    return;
+
+  const size_t windowSize = convergenceOptions.stableIterations;
+
+  // The iteration has just retired, so it's still in the retained window.
+  const size_t retireClock = instructionClock;
+  const size_t latency = retireClock - getIterationInfo(pFlow->instructionExecutionInfo[0], iterationIndex).clockDispatched;
+
+  iterationRetireClocks[iterationIndex % (windowSize + 1)] = retireClock;
+
+  iterationLatencySum -= iterationLatencies[iterationIndex % windowSize];
+  iterationLatencies[iterationIndex % windowSize] = latency;
+  iterationLatencySum += latency;
+
+  if (iterationIndex < windowSize)
+    return;
+
+  // Averages over the last `windowSize` iterations, so loops with a periodic pattern across iterations still settle.
+  const size_t windowBaseRetireClock = iterationRetireClocks[(iterationIndex - windowSize) % (windowSize + 1)];
+  const double cyclesPerIteration = (double)(retireClock - windowBaseRetireClock) / (double)windowSize;
+  const double iterationLatency = (double)iterationLatencySum / (double)windowSize;
+
+  const double cyclesTolerance = convergenceOptions.tolerance * referenceCyclesPerIteration;
+  const double latencyTolerance = convergenceOptions.tolerance * referenceIterationLatency;
+
+  if (stableIterationCount == 0 || std::abs(cyclesPerIteration - referenceCyclesPerIteration) > cyclesTolerance || std::abs(iterationLatency - referenceIterationLatency) > latencyTolerance)
+  {
+    // Start over with the current window as the new reference.
+    referenceCyclesPerIteration = cyclesPerIteration;
+    referenceIterationLatency = iterationLatency;
+    stableBaseIteration = iterationIndex - windowSize;
+    stableBaseRetireClock = windowBaseRetireClock;
+    stableIterationCount = 1;
+  }
+  else
+  {
+    stableIterationCount++;
+  }
+
+  steadyState.warmUpIterations = stableBaseIteration + 1;
+  steadyState.cyclesPerIteration = (double)(retireClock - stableBaseRetireClock) / (double)(iterationIndex - stableBaseIteration);
+  steadyState.iterationLatency = iterationLatency;
+  steadyState.converged = (stableIterationCount >= windowSize);
+}
+
+void FlowView::addInFlightInstruction(const size_t sourceIndex, const uint32_t uOps)
+{
+  size_t mask = inFlightInstructions.size() - 1;
+
+  // Instructions without uOps don't count towards the reorder buffer, so there may be more in flight than it could hold.
+  while (inFlightInstructions[sourceIndex & mask].inFlight)
+  {
+    std::vector<InFlightInstruction> previous(inFlightInstructions.size() * 2, InFlightInstruction());
+    std::swap(previous, inFlightInstructions);
+    mask = inFlightInstructions.size() - 1;
+
+    for (const InFlightInstruction &_instruction : previous)
+      if (_instruction.inFlight)
+        inFlightInstructions[_instruction.sourceIndex & mask] = _instruction;
+  }
+
+  InFlightInstruction &slot = inFlightInstructions[sourceIndex & mask];
+  slot.sourceIndex = sourceIndex;
+  slot.clockDispatched = slot.clockPending = slot.clockReady = slot.clockIssued = slot.clockExecuted = instructionClock;
+  slot.uOps = uOps;
+  slot.inFlight = true;
+  slot.ports.clear();
+
+  inFlightInstructionCount++;
+  inFlightUOpCount += uOps;
+}
+
+FlowView::InFlightInstruction &FlowView::getInFlightInstruction(const size_t sourceIndex)
+{
+  InFlightInstruction &slot = inFlightInstructions[sourceIndex & (inFlightInstructions.size() - 1)];
+  assert(slot.inFlight && slot.sourceIndex == sourceIndex && "This instruction isn't in flight.");
+
+  return slot;
+}
+
+void FlowView::removeInFlightInstruction(const size_t sourceIndex)
+{
+  InFlightInstruction &slot = inFlightInstructions[sourceIndex & (inFlightInstructions.size() - 1)];
+
+  if (!slot.inFlight || slot.sourceIndex != sourceIndex)
+  {
+    assert(false && "This instruction isn't in flight.");
+    return;
+  }
+
+  slot.inFlight = false;
+
+  inFlightInstructionCount--;
+  inFlightUOpCount -= slot.uOps;
+}
+
 void FlowView::addResourcePressure(InstructionInfo &info, const size_t iterationIndex, const size_t llvmResourceIndex, const llvm::mca::Instruction &instruction, const bool fromPressureEvent)
 {
   const llvm::MCProcResourceDesc *pResource = schedulerModel.getProcResource(llvmResourceIndex);
   
-  size_t firstMatchingPortIndex = (size_t)-1;
+  size_t firstMatchingPortIndex = getPortIndex(llvmResourceIndex, 1);
   size_t resourceType = (size_t)-1;
-  const llvm::mca::ResourceRef resourceReference(llvmResourceIndex, 1);
   
-  if (llvmResource2ListedResourceIdx.contains(resourceReference))
+  if (firstMatchingPortIndex != (size_t)-1)
   {
-    firstMatchingPortIndex = llvmResource2ListedResourceIdx[resourceReference];
     resourceType = pFlow->ports[firstMatchingPortIndex].resourceTypeIndex;
   }
   else if (pResource->NumUnits > 0 && pResource->SubUnitsIdxBegin != nullptr)
@@ -343,7 +727,24 @@ void FlowView::addResourcePressure(InstructionInfo &info, const size_t iteration
     return;
   }
   
-  ResourceDependencyInfo &pressureContainer = info.perIteration[iterationIndex].resourcePressure;
+  std::optional<DependencyOrigin> origin;
+
+  if (!fromPressureEvent)
+    origin = updateLastResourceUser(llvmResourceIndex, iterationIndex, info.instructionIndex);
+
+  if (pColumns != nullptr)
+  {
+    FlowColumnResourceDependency &dependency = getColumnResourceDependency(pColumns->recordIndex(iterationIndex, info.instructionIndex), resourceType, firstMatchingPortIndex, pResource->Name);
+
+    if (fromPressureEvent)
+      dependency.pressureCycles++;
+    else if (origin.has_value())
+      dependency.origin = (uint32_t)pColumns->recordIndex(origin.value().iterationIndex, origin.value().instructionIndex);
+
+    return;
+  }
+
+  ResourceDependencyInfo &pressureContainer = getIterationInfo(info, iterationIndex).resourcePressure;
   ResourceTypeDependencyInfo *pDependency = nullptr;
   
   for (auto &_dep : pressureContainer.associatedResources)
@@ -362,37 +763,89 @@ void FlowView::addResourcePressure(InstructionInfo &info, const size_t iteration
   }
   
   if (fromPressureEvent)
-  {
     pDependency->pressureCycles++;
+  else if (origin.has_value())
+    pDependency->origin = origin;
+}
+
+std::optional<DependencyOrigin> FlowView::updateLastResourceUser(const size_t llvmResourceIndex, const size_t iterationIndex, const size_t instructionIndex)
+{
+  std::optional<DependencyOrigin> origin;
+
+  if (lastResourceUser.size() <= llvmResourceIndex)
+  {
+    lastResourceUser.resize(llvmResourceIndex + 1, std::make_pair((size_t)-1, (size_t)-1));
+    preLastResourceUser.resize(llvmResourceIndex + 1, std::make_pair((size_t)-1, (size_t)-1));
   }
-  else
+
+  if (lastResourceUser[llvmResourceIndex].first != (size_t)-1)
   {
-    if (lastResourceUser.size() <= llvmResourceIndex)
-    {
-      lastResourceUser.resize(llvmResourceIndex + 1, std::make_pair((size_t)-1, (size_t)-1));
-      preLastResourceUser.resize(llvmResourceIndex + 1, std::make_pair((size_t)-1, (size_t)-1));
-    }
+    if (lastResourceUser[llvmResourceIndex].second != instructionIndex || lastResourceUser[llvmResourceIndex].first != iterationIndex)
+      origin = DependencyOrigin(lastResourceUser[llvmResourceIndex].first, lastResourceUser[llvmResourceIndex].second);
+    else if (preLastResourceUser[llvmResourceIndex].first != (size_t)-1)
+      origin = DependencyOrigin(preLastResourceUser[llvmResourceIndex].first, preLastResourceUser[llvmResourceIndex].second);
+  }
 
-    if (lastResourceUser[llvmResourceIndex].first != (size_t)-1)
-    {
-      if (lastResourceUser[llvmResourceIndex].second != info.instructionIndex || lastResourceUser[llvmResourceIndex].first != iterationIndex)
-        pDependency->origin = DependencyOrigin(lastResourceUser[llvmResourceIndex].first, lastResourceUser[llvmResourceIndex].second);
-      else if (preLastResourceUser[llvmResourceIndex].first != (size_t)-1)
-        pDependency->origin = DependencyOrigin(preLastResourceUser[llvmResourceIndex].first, preLastResourceUser[llvmResourceIndex].second);
-    }
+  // If this is called multiple times for the same function, don't set this again.
+  if (lastResourceUser[llvmResourceIndex].second != instructionIndex || lastResourceUser[llvmResourceIndex].first != iterationIndex)
+  {
+    preLastResourceUser[llvmResourceIndex] = lastResourceUser[llvmResourceIndex];
+    lastResourceUser[llvmResourceIndex] = std::make_pair(iterationIndex, instructionIndex);
+  }
 
-    // If this is called multiple times for the same function, don't set this again.
-    if (lastResourceUser[llvmResourceIndex].second != info.instructionIndex || lastResourceUser[llvmResourceIndex].first != iterationIndex)
-    {
-      preLastResourceUser[llvmResourceIndex] = lastResourceUser[llvmResourceIndex];
-      lastResourceUser[llvmResourceIndex] = std::make_pair(iterationIndex, info.instructionIndex);
-    }
+  return origin;
+}
+
+uint32_t FlowView::getColumnNameId(const llvm::StringRef name)
+{
+  const auto &entry = columnNameIds.try_emplace(name, (uint32_t)pColumns->names.size());
+
+  if (entry.second)
+    pColumns->names.emplace_back(name.str());
+
+  return entry.first->second;
+}
+
+FlowColumnResourceDependency &FlowView::getColumnResourceDependency(const size_t record, const size_t resourceType, const size_t firstMatchingPortIndex, const llvm::StringRef name)
+{
+  const uint32_t resourceTypeIndex = resourceType == (size_t)-1 ? FlowColumns::None : (uint32_t)resourceType;
+  uint32_t *pLink = &pColumns->resourceDependencyHead[record];
+
+  while (*pLink != FlowColumns::None)
+  {
+    FlowColumnResourceDependency &dependency = pColumns->resourceDependencies[*pLink];
+
+    if (dependency.resourceTypeIndex == resourceTypeIndex)
+      return dependency;
+
+    pLink = &dependency.next;
   }
+
+  // Append, so the dependencies stay in the order they've been observed in.
+  *pLink = (uint32_t)pColumns->resourceDependencies.size();
+  pColumns->resourceDependencies.emplace_back(resourceTypeIndex, firstMatchingPortIndex == (size_t)-1 ? FlowColumns::None : (uint32_t)firstMatchingPortIndex, getColumnNameId(name));
+
+  return pColumns->resourceDependencies.back();
 }
 
 void FlowView::addRegisterPressure(InstructionInfo &info, const size_t selfIterationIndex, const size_t dependencyIterationIndex, const size_t dependencyInstructionIndex, const llvm::MCPhysReg &physicalRegister, const size_t dependencyCycles)
 {
-  RegisterDependencyInfo &pressureContainer = info.perIteration[selfIterationIndex].registerPressure;
+  if (pColumns != nullptr)
+  {
+    const size_t record = pColumns->recordIndex(selfIterationIndex, info.instructionIndex);
+
+    llvm::SmallString<32> registerName;
+    llvm::raw_svector_ostream stringStream(registerName);
+    instructionPrinter.printRegName(stringStream, physicalRegister);
+
+    pColumns->registerPressureCycles[record] = (uint32_t)dependencyCycles;
+    pColumns->registerOrigin[record] = (uint32_t)pColumns->recordIndex(dependencyIterationIndex, dependencyInstructionIndex);
+    pColumns->registerNameId[record] = getColumnNameId(registerName);
+
+    return;
+  }
+
+  RegisterDependencyInfo &pressureContainer = getIterationInfo(info, selfIterationIndex).registerPressure;
 
   pressureContainer.selfPressureCycles = dependencyCycles;
   pressureContainer.origin = std::make_optional<DependencyOrigin>(dependencyIterationIndex, dependencyInstructionIndex);
@@ -403,7 +856,17 @@ void FlowView::addRegisterPressure(InstructionInfo &info, const size_t selfItera
 
 void FlowView::addMemoryPressure(InstructionInfo &info, const size_t selfIterationIndex, const size_t dependencyIterationIndex, const size_t dependencyInstructionIndex, const size_t dependencyCycles)
 {
-  DependencyInfo &pressureContainer = info.perIteration[selfIterationIndex].memoryPressure;
+  if (pColumns != nullptr)
+  {
+    const size_t record = pColumns->recordIndex(selfIterationIndex, info.instructionIndex);
+
+    pColumns->memoryPressureCycles[record] = (uint32_t)dependencyCycles;
+    pColumns->memoryOrigin[record] = (uint32_t)pColumns->recordIndex(dependencyIterationIndex, dependencyInstructionIndex);
+
+    return;
+  }
+
+  DependencyInfo &pressureContainer = getIterationInfo(info, selfIterationIndex).memoryPressure;
 
   pressureContainer.selfPressureCycles = dependencyCycles;
   pressureContainer.origin = std::make_optional<DependencyOrigin>(dependencyIterationIndex, dependencyInstructionIndex);
@@ -31,6 +31,8 @@
 
 #include "execution-flow.h"
 
+#include <algorithm>
+
 #ifdef _MSC_VER
 #pragma warning (push, 0)
 #else
@@ -38,9 +40,13 @@
 #pragma GCC diagnostic ignored "-Wall"
 #pragma GCC diagnostic ignored "-Wextra"
 #endif
-#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/bit.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/MC/MCInstPrinter.h"
+#include "llvm/MC/MCSchedule.h"
 #include "llvm/MCA/HWEventListener.h"
+#include "llvm/Support/MathExtras.h"
 #ifdef _MSC_VER
 #pragma warning (pop)
 #else
@@ -55,7 +61,8 @@ private:
   PortUsageFlow *pFlow; // initialized in the constructor.
   size_t relevantIteration; // initialized in the constructor.
   size_t instructionClock = 0;
-  llvm::SmallDenseMap<std::pair<uint64_t, uint64_t>, size_t, 32U> llvmResource2ListedResourceIdx;
+  llvm::ArrayRef<uint32_t> resourceUnitToPortIndex; // `[llvmResourceIndex * resourceUnitStride + unitBit]`, owned by the context.
+  size_t resourceUnitStride = 0;
   bool hasFirstObservedInstructionClock = false;
   size_t firstObservedInstructionClock = 0;
   llvm::SmallVector<bool> isRegisterFileRelevant;
@@ -66,8 +73,68 @@ private:
   llvm::SmallVector<std::pair<size_t, size_t>> lastResourceUser;
   llvm::SmallVector<std::pair<size_t, size_t>> preLastResourceUser; // sometimes the resource has already been made the current resource, so we'll also have the one before that as a backup.
 
-  // TODO: this should be a pool, not a map.
-  llvm::DenseMap<std::pair<size_t, size_t>, bool> inFlightInstructions; // (runIndex, instruction index), bool is meaningless.
+  size_t retainedIterations = 0; // 0 means that all iterations are retained.
+  size_t firstStallInfoIteration = 0;
+  std::vector<std::vector<size_t>> stallInfoIterations; // instructionIndex => iteration of each entry in `stallInfo`.
+
+  ConvergenceOptions convergenceOptions;
+  bool detectConvergence = false;
+  std::vector<size_t> iterationRetireClocks; // ring buffer of the last `stableIterations + 1` iterations.
+  std::vector<size_t> iterationLatencies; // ring buffer of the last `stableIterations` iterations.
+  size_t iterationLatencySum = 0;
+  size_t stableIterationCount = 0;
+  size_t stableBaseIteration = 0; // the stable range starts with the iteration after this one.
+  size_t stableBaseRetireClock = 0;
+  double referenceCyclesPerIteration = 0;
+  double referenceIterationLatency = 0;
+
+  FlowColumns *pColumns = nullptr; // if set, the per-iteration records go here instead of `InstructionInfo::perIteration`.
+  llvm::StringMap<uint32_t> columnNameIds;
+
+  struct InFlightInstruction
+  {
+    size_t sourceIndex;
+    size_t clockDispatched, clockPending, clockReady, clockIssued, clockExecuted;
+    uint32_t uOps;
+    bool inFlight;
+    llvm::SmallVector<uint32_t, 4> ports; // the ports this instruction keeps busy between issue & execution. Reused along with the slot.
+  };
+
+  // Ring buffer indexed by `sourceIndex & (size - 1)`. Sized from the reorder buffer, as only instructions between dispatch & retirement are tracked.
+  std::vector<InFlightInstruction> inFlightInstructions;
+  size_t inFlightInstructionCount = 0;
+  size_t inFlightUOpCount = 0;
+  std::vector<size_t> busyPortInstructionCount; // per port: number of issued instructions that haven't been executed yet.
+
+  CollectionLevel collectionLevel = CollectionLevel::Full;
+
+  LoopInstructionInfo &getIterationInfo(InstructionInfo &info, const size_t iterationIndex);
+  void addToStatistics(InstructionInfo &info, const BasicInstructionInfo &iteration);
+  void onIterationRetired(const size_t iterationIndex);
+  void updateConvergence(const size_t iterationIndex);
+  void addInFlightInstruction(const size_t sourceIndex, const uint32_t uOps);
+  InFlightInstruction &getInFlightInstruction(const size_t sourceIndex);
+  void removeInFlightInstruction(const size_t sourceIndex);
+
+  // Returns `(size_t)-1` if the resource unit isn't one of the ports.
+  inline size_t getPortIndex(const uint64_t llvmResourceIndex, const uint64_t unitMask) const
+  {
+    // Only single units are listed as ports.
+    if (unitMask == 0 || (unitMask & (unitMask - 1)) != 0)
+      return (size_t)-1;
+
+    const uint64_t unitBit = (uint64_t)llvm::countr_zero(unitMask);
+
+    if (unitBit >= resourceUnitStride || llvmResourceIndex * resourceUnitStride + unitBit >= resourceUnitToPortIndex.size())
+      return (size_t)-1;
+
+    const uint32_t portIndex = resourceUnitToPortIndex[llvmResourceIndex * resourceUnitStride + unitBit];
+
+    return portIndex == UINT32_MAX ? (size_t)-1 : (size_t)portIndex;
+  }
+  std::optional<DependencyOrigin> updateLastResourceUser(const size_t llvmResourceIndex, const size_t iterationIndex, const size_t instructionIndex);
+  uint32_t getColumnNameId(const llvm::StringRef name);
+  FlowColumnResourceDependency &getColumnResourceDependency(const size_t record, const size_t resourceType, const size_t firstMatchingPortIndex, const llvm::StringRef name);
 
   void addResourcePressure(InstructionInfo &info, const size_t iterationIndex, const size_t llvmResourceMask, const llvm::mca::Instruction &instruction, const bool fromPressureEvent);
   void addRegisterPressure(InstructionInfo &info, const size_t selfIterationIndex, const size_t dependencyIterationIndex, const size_t dependencyInstructionIndex, const llvm::MCPhysReg &physicalRegister, const size_t dependencyCycles);
@@ -79,16 +146,37 @@ public:
     relevantIteration(relevantIteration),
     schedulerModel(schedulerModel),
     instructionPrinter(instructionPrinter)
-  { }
+  {
+    // Some models don't specify a reorder buffer, the ring buffer will grow if necessary.
+    const size_t reorderBufferSize = schedulerModel.MicroOpBufferSize > 0 ? (size_t)schedulerModel.MicroOpBufferSize : 0;
+
+    pFlow->statistics.reorderBufferSize = reorderBufferSize;
+    busyPortInstructionCount.resize(pFlow->ports.size(), 0);
+    pFlow->cycleTimeline.portBusyIntervals.resize(pFlow->ports.size());
+    inFlightInstructions.resize(llvm::PowerOf2Ceil(std::max(reorderBufferSize, (size_t)64)), InFlightInstruction());
+  }
 
-  inline void onCycleEnd() override { instructionClock++; }
+  void onCycleEnd() override;
 
   void onEvent(const llvm::mca::HWInstructionEvent &evnt) override;
   void onEvent(const llvm::mca::HWStallEvent &evnt) override;
   void onEvent(const llvm::mca::HWPressureEvent &evnt) override;
 
-  void addLLVMResourceToPortIndexLookup(const std::pair<std::pair<size_t, size_t>, size_t> &keyValuePair);
+  void setResourceUnitToPortIndexLookup(const llvm::ArrayRef<uint32_t> lookup, const size_t unitStride);
   void addRegisterFileRelevancy(const bool isRelevant);
+
+  // Only keeps the per-iteration info of the last `retainedIterationCount` retired iterations (plus the ones that are still in flight). Call `trimRetainedIterations` once the simulation is done to drop the surplus.
+  void setRetainedIterations(const size_t retainedIterationCount, const size_t totalIterationCount);
+  void trimRetainedIterations();
+
+  // Fills `PortUsageFlow::steadyState` while the iterations retire.
+  void setConvergenceOptions(const ConvergenceOptions &options);
+  inline bool hasConverged() const { return pFlow->steadyState.converged; }
+
+  void setCollectionLevel(const CollectionLevel level);
+
+  // Stores the per-iteration records in `PortUsageFlow::columns`. Not compatible with `setRetainedIterations`.
+  void setColumnar(const size_t iterationCount);
 };
 
 #endif // FlowView_h__
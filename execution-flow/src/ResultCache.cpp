@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2023, Christoph Stiller. All rights reserved.
+// 
+// Redistribution and use in next and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of next code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation 
+//    and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ResultCache.h"
+#include "FlowFile.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#ifdef _MSC_VER
+#pragma warning (push, 0)
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wall"
+#pragma GCC diagnostic ignored "-Wextra"
+#endif
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
+#ifdef _MSC_VER
+#pragma warning (pop)
+#else
+#pragma GCC diagnostic pop
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void result_cache_get_filename(const ExecutionFlowContext *pContext, const uint64_t key, llvm::SmallString<256> &filename);
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t result_cache_get_key(const ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, const char *mode, const std::initializer_list<uint64_t> parameters)
+{
+  // Don't bother hashing the code if nothing will be looked up.
+  if (pContext->cacheDirectory.empty())
+    return 0;
+
+  llvm::SmallVector<uint8_t, 256> keyData;
+
+  auto append = [&](const void *pData, const size_t size)
+  {
+    keyData.append(reinterpret_cast<const uint8_t *>(pData), reinterpret_cast<const uint8_t *>(pData) + size);
+  };
+
+  auto appendString = [&](const llvm::StringRef string)
+  {
+    const uint64_t length = string.size();
+    append(&length, sizeof(length));
+    append(string.data(), string.size());
+  };
+
+  const uint64_t versions[] = { ResultCacheVersion, FlowFileVersion, (uint64_t)pContext->arch, assembledBytesLength, llvm::xxh3_64bits(llvm::ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(pAssembledBytes), assembledBytesLength)) };
+  append(versions, sizeof(versions));
+
+  appendString(LLVM_VERSION_STRING);
+  appendString(pContext->subtargetInfo->getCPU()); // `CoreArchitecture::_CurrentCPU` depends on the host.
+  appendString(mode);
+
+  const PipelineOptions &pipelineOptions = pContext->pipelineOptions;
+  const uint64_t pipelineParameters[] = { pipelineOptions.dispatchWidth, pipelineOptions.microOpQueueSize, pipelineOptions.decodersThroughput, pipelineOptions.registerFileSize, pipelineOptions.loadQueueSize, pipelineOptions.storeQueueSize, pipelineOptions.assumeNoAlias };
+  append(pipelineParameters, sizeof(pipelineParameters));
+
+  for (const uint64_t parameter : parameters)
+    append(&parameter, sizeof(parameter));
+
+  return llvm::xxh3_64bits(keyData);
+}
+
+bool result_cache_load(const ExecutionFlowContext *pContext, const uint64_t key, PortUsageFlow *pFlow)
+{
+  if (pContext->cacheDirectory.empty())
+    return false;
+
+  llvm::SmallString<256> filename;
+  result_cache_get_filename(pContext, key, filename);
+
+  FlowFileView *pView = nullptr;
+
+  if (!execution_flow_load(filename.c_str(), &pView))
+    return false;
+
+  // The key is repeated in the file, so renamed or foreign files aren't picked up.
+  const bool result = pView->pHeader->key == key && execution_flow_view_get_flow(pView, pFlow);
+
+  execution_flow_view_destroy(&pView);
+
+  return result;
+}
+
+void result_cache_store(const ExecutionFlowContext *pContext, const uint64_t key, const PortUsageFlow &flow)
+{
+  if (pContext->cacheDirectory.empty())
+    return;
+
+  llvm::SmallString<256> filename;
+  result_cache_get_filename(pContext, key, filename);
+
+  flow_file_save(flow, key, filename.c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void result_cache_get_filename(const ExecutionFlowContext *pContext, const uint64_t key, llvm::SmallString<256> &filename)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "%016" PRIx64 ".flow", key);
+
+  filename = pContext->cacheDirectory;
+  llvm::sys::path::append(filename, name);
+}
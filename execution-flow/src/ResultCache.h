@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2023, Christoph Stiller. All rights reserved.
+// 
+// Redistribution and use in next and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of next code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation 
+//    and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ResultCache_h__
+#define ResultCache_h__
+
+#include "execution-flow.h"
+#include "ExecutionFlowContext.h"
+
+#include <initializer_list>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Bump whenever the simulation or the collected data changes, so stale cached results are ignored.
+constexpr uint32_t ResultCacheVersion = 1;
+
+// Hashes everything the result depends on: the code bytes, the architecture, cpu & pipeline options of `pContext`, the kind of analysis (`mode`) and its `parameters`, the file format & the LLVM version.
+// Returns 0 if caching is disabled for `pContext`.
+uint64_t result_cache_get_key(const ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, const char *mode, const std::initializer_list<uint64_t> parameters);
+
+// Returns `false` if caching is disabled for `pContext` or there's no valid entry for `key`.
+bool result_cache_load(const ExecutionFlowContext *pContext, const uint64_t key, PortUsageFlow *pFlow);
+
+// Failing to store an entry isn't fatal, the result will just be recomputed next time.
+void result_cache_store(const ExecutionFlowContext *pContext, const uint64_t key, const PortUsageFlow &flow);
+
+#endif // ResultCache_h__
@@ -0,0 +1,164 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2023, Christoph Stiller. All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation 
+//    and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ThreadPool_h__
+#define ThreadPool_h__
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline size_t thread_pool_worker_count(const size_t taskCount, const size_t threadCount)
+{
+  size_t workerCount = threadCount;
+
+  if (workerCount == 0)
+    workerCount = std::max((size_t)std::thread::hardware_concurrency(), (size_t)1);
+
+  return std::min(workerCount, taskCount);
+}
+
+// Calls `func(workerIndex, taskIndex)` for every task in `[0, taskCount)`.
+// Every worker starts out with a contiguous slice of the tasks and steals half of the largest remaining slice once it runs dry, so uneven task sizes still keep all workers busy.
+// The calling thread participates as worker 0. `workerIndex` is always `< thread_pool_worker_count(taskCount, threadCount)`.
+template <typename TFunc>
+void thread_pool_run(const size_t taskCount, const size_t threadCount, TFunc &&func)
+{
+  const size_t workerCount = thread_pool_worker_count(taskCount, threadCount);
+
+  if (workerCount == 0)
+    return;
+
+  if (workerCount == 1)
+  {
+    for (size_t i = 0; i < taskCount; i++)
+      func((size_t)0, i);
+
+    return;
+  }
+
+  struct TaskRange
+  {
+    std::mutex mutex;
+    size_t begin, end;
+  };
+
+  std::unique_ptr<TaskRange[]> ranges(new TaskRange[workerCount]);
+
+  for (size_t i = 0; i < workerCount; i++)
+  {
+    ranges[i].begin = (taskCount * i) / workerCount;
+    ranges[i].end = (taskCount * (i + 1)) / workerCount;
+  }
+
+  auto worker = [&](const size_t workerIndex)
+  {
+    TaskRange &own = ranges[workerIndex];
+
+    while (true)
+    {
+      size_t taskIndex = (size_t)-1;
+
+      {
+        std::lock_guard<std::mutex> lock(own.mutex);
+
+        if (own.begin < own.end)
+          taskIndex = own.begin++;
+      }
+
+      if (taskIndex != (size_t)-1)
+      {
+        func(workerIndex, taskIndex);
+        continue;
+      }
+
+      // Find the largest remaining range to steal from.
+      size_t victimIndex = (size_t)-1;
+      size_t victimRemaining = 0;
+
+      for (size_t i = 0; i < workerCount; i++)
+      {
+        if (i == workerIndex)
+          continue;
+
+        std::lock_guard<std::mutex> lock(ranges[i].mutex);
+        const size_t remaining = ranges[i].end - ranges[i].begin;
+
+        if (remaining > victimRemaining)
+        {
+          victimRemaining = remaining;
+          victimIndex = i;
+        }
+      }
+
+      if (victimIndex == (size_t)-1)
+        return;
+
+      // Take the back half of the victims range (at least a single task).
+      size_t stolenBegin, stolenEnd;
+
+      {
+        std::lock_guard<std::mutex> victimLock(ranges[victimIndex].mutex);
+        TaskRange &victim = ranges[victimIndex];
+
+        if (victim.begin >= victim.end) // someone was faster.
+          continue;
+
+        const size_t stolenCount = std::max((victim.end - victim.begin) / 2, (size_t)1);
+
+        stolenEnd = victim.end;
+        stolenBegin = victim.end - stolenCount;
+        victim.end = stolenBegin;
+      }
+
+      // Nobody steals from an empty range, so there's no need to hold both locks at once.
+      {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = stolenBegin;
+        own.end = stolenEnd;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(workerCount - 1);
+
+  for (size_t i = 1; i < workerCount; i++)
+    threads.emplace_back(worker, i);
+
+  worker(0);
+
+  for (auto &_thread : threads)
+    _thread.join();
+}
+
+#endif // ThreadPool_h__
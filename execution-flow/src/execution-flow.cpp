@@ -29,10 +29,18 @@
 #include "execution-flow.h"
 
 #include "FlowView.h"
+#include "ExecutionFlowContext.h"
+#include "ResultCache.h"
+#include "ThreadPool.h"
 
 #include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
 #include <queue>
 
+#include <string.h>
+
 #ifdef _MSC_VER
 #pragma warning (push, 0)
 #else
@@ -41,15 +49,27 @@
 #pragma GCC diagnostic ignored "-Wextra"
 #endif
 
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/TargetParser/Host.h"
 #include "llvm/TargetParser/SubtargetFeature.h"
 #include "llvm/MC/MCAsmInfo.h"
+#include "llvm/MC/MCCodeEmitter.h"
 #include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCFixup.h"
 #include "llvm/MC/MCInstBuilder.h"
+#include "llvm/MC/MCObjectFileInfo.h"
+#include "llvm/MC/MCParser/MCAsmLexer.h"
+#include "llvm/MC/MCParser/MCAsmParser.h"
+#include "llvm/MC/MCParser/MCTargetAsmParser.h"
 #include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/MC/MCTargetOptions.h"
 #include "llvm/MC/MCTargetOptionsCommandFlags.h"
@@ -57,9 +77,20 @@
 #include "llvm/MC/TargetRegistry.h"
 #include "llvm/MCA/Context.h"
 #include "llvm/MCA/CustomBehaviour.h"
+#include "llvm/MCA/HardwareUnits/LSUnit.h"
+#include "llvm/MCA/HardwareUnits/RegisterFile.h"
+#include "llvm/MCA/HardwareUnits/RetireControlUnit.h"
+#include "llvm/MCA/HardwareUnits/Scheduler.h"
+#include "llvm/MCA/IncrementalSourceMgr.h"
 #include "llvm/MCA/InstrBuilder.h"
 #include "llvm/MCA/Pipeline.h"
 #include "llvm/MCA/SourceMgr.h"
+#include "llvm/MCA/Support.h"
+#include "llvm/MCA/Stages/DispatchStage.h"
+#include "llvm/MCA/Stages/EntryStage.h"
+#include "llvm/MCA/Stages/ExecuteStage.h"
+#include "llvm/MCA/Stages/MicroOpQueueStage.h"
+#include "llvm/MCA/Stages/RetireStage.h"
 #include "llvm/MCA/Stages/Stage.h"
 #include "llvm/MCA/Stages/InstructionTables.h"
 
@@ -120,206 +151,1971 @@ static_assert(std::size(CoreArchitectureLookup) == (size_t)CoreArchitecture::_Co
 
 const char *core_arch_to_string(const CoreArchitecture arch);
 
+static bool execution_flow_decode(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, std::vector<llvm::MCInst> &decodedInstructions, PortUsageFlow &flow, const bool printInstructions = true);
+static bool execution_flow_assemble(ExecutionFlowContext *pContext, const char *assemblyText, const size_t assemblyTextLength, const AssemblySyntax syntax, std::vector<llvm::MCInst> &assembledInstructions, PortUsageFlow &flow, const bool printInstructions = true);
+static void execution_flow_print_instruction(ExecutionFlowContext *pContext, const llvm::MCInst &instruction, const uint64_t address, std::string &disassembly);
+struct SimulationParameters
+{
+  size_t retainedIterations; // 0 means that all iterations are retained and the instructions aren't streamed.
+  const ConvergenceOptions *pConvergenceOptions; // only supported when streaming.
+  bool columnar;
+  CollectionLevel collectionLevel;
+
+  inline SimulationParameters() :
+    retainedIterations(0),
+    pConvergenceOptions(nullptr),
+    columnar(false),
+    collectionLevel(CollectionLevel::Full)
+  { }
+};
+
+static bool execution_flow_simulate(ExecutionFlowContext *pContext, const llvm::ArrayRef<llvm::MCInst> decodedInstructions, PortUsageFlow &flow, const size_t iterations, const size_t relevantIteration, const SimulationParameters &parameters = SimulationParameters());
+static bool execution_flow_create_mca_instructions(ExecutionFlowContext *pContext, const llvm::ArrayRef<llvm::MCInst> decodedInstructions, llvm::SmallVector<std::unique_ptr<llvm::mca::Instruction>> &mcaInstructions);
+static void execution_flow_enumerate_ports(const llvm::MCSchedModel &schedulerModel, std::vector<ResourceInfo> &ports, std::vector<uint32_t> &resourceUnitToPortIndex, size_t &resourceUnitStride);
+static void execution_flow_prepare_flow(const ExecutionFlowContext *pContext, PortUsageFlow &flow);
+static void execution_flow_prepare_flow_view(const ExecutionFlowContext *pContext, FlowView &flowView);
+struct SweepModel;
+static bool execution_flow_simulate_with_model(const ExecutionFlowContext *pContext, const SweepModel &model, const llvm::ArrayRef<std::unique_ptr<llvm::mca::Instruction>> mcaInstructions, const size_t iterations, PortUsageFlow &flow);
+static size_t execution_flow_merge_intervals(std::vector<std::pair<size_t, size_t>> &intervals);
+static bool execution_flow_run_streaming(llvm::mca::IncrementalSourceMgr &source, llvm::mca::Pipeline &pipeline, const FlowView &flowView, llvm::SmallVector<std::unique_ptr<llvm::mca::Instruction>> &mcaInstructions, const size_t iterations);
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr size_t MaxRetainedInstructions = 1024 * 64;
+constexpr size_t StreamingInstructionsPerBatch = 256;
+
 ////////////////////////////////////////////////////////////////////////////////
 
-bool execution_flow_create(const void *pAssembledBytes, const size_t assembledBytesLength, PortUsageFlow *pFlow, const CoreArchitecture arch, const size_t iterations, const size_t relevantIteration)
+// The target registry & command line flags are global LLVM state, so they must only be initialized once, even if multiple threads create contexts concurrently.
+static void execution_flow_initialize_llvm()
 {
-  if (pFlow == nullptr || pAssembledBytes == nullptr || (uint64_t)arch > (uint64_t)CoreArchitecture::_Count || relevantIteration >= iterations || iterations > UINT32_MAX)
+  static std::once_flag initializedFlag;
+
+  std::call_once(initializedFlag, []()
+    {
+      static llvm::mc::RegisterMCTargetOptionsFlags targetOptionFlags;
+
+      LLVMInitializeX86TargetInfo();
+      LLVMInitializeX86TargetMC();
+      LLVMInitializeX86Target();
+      LLVMInitializeX86Disassembler();
+      LLVMInitializeX86AsmParser();
+    });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool execution_flow_context_create(ExecutionFlowContext **ppContext, const CoreArchitecture arch)
+{
+  if (ppContext == nullptr || (uint64_t)arch >= (uint64_t)CoreArchitecture::_Count)
     return false;
 
-  static llvm::mc::RegisterMCTargetOptionsFlags targetOptionFlags;
+  execution_flow_initialize_llvm();
 
-  LLVMInitializeX86TargetInfo();
-  LLVMInitializeX86TargetMC();
-  LLVMInitializeX86Target();
-  LLVMInitializeX86Disassembler();
+  std::unique_ptr<ExecutionFlowContext> ctx = std::make_unique<ExecutionFlowContext>(arch);
 
   // Get Target Triple from the current host.
-  const std::string targetTripleName = llvm::Triple::normalize(llvm::sys::getDefaultTargetTriple());
-  const llvm::Triple targetTriple(targetTripleName);
+  ctx->targetTriple = llvm::Triple(llvm::Triple::normalize(llvm::sys::getDefaultTargetTriple()));
 
   // Look up the target triple to get a hold of the target.
   std::string errorString;
-  const llvm::Target *pTarget(llvm::TargetRegistry::lookupTarget(targetTriple.str(), errorString));
+  ctx->pTarget = llvm::TargetRegistry::lookupTarget(ctx->targetTriple.str(), errorString);
 
   // Did we get one? (I sure hope so!)
-  if (pTarget == nullptr)
+  if (ctx->pTarget == nullptr)
     return false;
 
   // Create everything the context wants.
-  llvm::MCTargetOptions targetOptions(llvm::mc::InitMCTargetOptionsFromFlags());
-  std::unique_ptr<llvm::MCRegisterInfo> registerInfo(pTarget->createMCRegInfo(targetTriple.str()));
-  std::unique_ptr<llvm::MCAsmInfo> asmInfo(pTarget->createMCAsmInfo(*registerInfo, targetTriple.str(), targetOptions));
-  std::unique_ptr<llvm::MCSubtargetInfo> subtargetInfo;
-  
+  ctx->targetOptions = llvm::mc::InitMCTargetOptionsFromFlags();
+  ctx->registerInfo.reset(ctx->pTarget->createMCRegInfo(ctx->targetTriple.str()));
+
+  if (ctx->registerInfo == nullptr)
+    return false;
+
+  ctx->asmInfo.reset(ctx->pTarget->createMCAsmInfo(*ctx->registerInfo, ctx->targetTriple.str(), ctx->targetOptions));
+
   if (arch == CoreArchitecture::_CurrentCPU)
-    subtargetInfo = std::unique_ptr<llvm::MCSubtargetInfo>(pTarget->createMCSubtargetInfo(targetTriple.str(), llvm::sys::getHostCPUName(), ""));
+    ctx->subtargetInfo.reset(ctx->pTarget->createMCSubtargetInfo(ctx->targetTriple.str(), llvm::sys::getHostCPUName(), ""));
   else
-    subtargetInfo = std::unique_ptr<llvm::MCSubtargetInfo>(pTarget->createMCSubtargetInfo(targetTriple.str(), core_arch_to_string(arch), ""));
+    ctx->subtargetInfo.reset(ctx->pTarget->createMCSubtargetInfo(ctx->targetTriple.str(), core_arch_to_string(arch), ""));
+
+  if (ctx->asmInfo == nullptr || ctx->subtargetInfo == nullptr)
+    return false;
 
   // Create Machine Code Context from the triple.
-  llvm::MCContext context(targetTriple, asmInfo.get(), registerInfo.get(), subtargetInfo.get());
+  ctx->context = std::make_unique<llvm::MCContext>(ctx->targetTriple, ctx->asmInfo.get(), ctx->registerInfo.get(), ctx->subtargetInfo.get());
 
   // Get the disassembler.
-  std::unique_ptr<llvm::MCDisassembler> disasm(pTarget->createMCDisassembler(*subtargetInfo, context));
+  ctx->disassembler.reset(ctx->pTarget->createMCDisassembler(*ctx->subtargetInfo, *ctx->context));
 
-  // Construct `ArrayRef` to feed the disassembler with.
-  llvm::ArrayRef<uint8_t> bytes(reinterpret_cast<const uint8_t *>(pAssembledBytes), assembledBytesLength);
+  if (ctx->disassembler == nullptr)
+    return false;
 
-  bool result = true;
+  // Prepare everything for the instruction builder in order to retrieve `llvm::mca::Instruction`s from the `llvm::Inst`s.
+  ctx->instructionInfo.reset(ctx->pTarget->createMCInstrInfo());
+  ctx->instructionAnalysis.reset(ctx->pTarget->createMCInstrAnalysis(ctx->instructionInfo.get()));
+  ctx->instrumentManager.reset(ctx->pTarget->createInstrumentManager(*ctx->subtargetInfo, *ctx->instructionInfo));
 
-  std::vector<llvm::MCInst> decodedInstructions;
-  PortUsageFlow flow;
+  if (ctx->instrumentManager == nullptr)
+    ctx->instrumentManager = std::make_unique<llvm::mca::InstrumentManager>(*ctx->subtargetInfo, *ctx->instructionInfo);
+
+  ctx->instructionBuilder = std::make_unique<llvm::mca::InstrBuilder>(*ctx->subtargetInfo, *ctx->instructionInfo, *ctx->registerInfo, ctx->instructionAnalysis.get(), *ctx->instrumentManager);
+
+  // Create instruction printer for the FlowView.
+  ctx->instructionPrinter.reset(ctx->pTarget->createMCInstPrinter(ctx->targetTriple, 1, *ctx->asmInfo, *ctx->instructionInfo, *ctx->registerInfo));
+
+  if (ctx->instructionPrinter == nullptr)
+    return false;
+
+  const llvm::MCSchedModel &schedulerModel = ctx->subtargetInfo->getSchedModel();
+
+  // Get Stages from Scheduler model.
+  execution_flow_enumerate_ports(schedulerModel, ctx->ports, ctx->resourceUnitToPortIndex, ctx->resourceUnitStride);
 
-  // Disassemble bytes.
+  // Get Register Types and Counts from scheduler extra info.
+  if (schedulerModel.hasExtraProcessorInfo())
   {
-    for (size_t i = 0; i < assembledBytesLength;)
+    const llvm::MCExtraProcessorInfo &extraInfo = schedulerModel.getExtraProcessorInfo();
+
+    for (size_t i = 0; i < extraInfo.NumRegisterFiles; i++)
     {
-      size_t instructionSize = 1;
+      const llvm::MCRegisterFileDesc &registerFile = extraInfo.RegisterFiles[i];
+      const bool registerFileRelevant = (registerFile.NumPhysRegs != 0);
 
-      llvm::MCInst retrievedInstruction;
-      const llvm::MCDisassembler::DecodeStatus status = disasm->getInstruction(retrievedInstruction, instructionSize, bytes.slice(i), i, llvm::nulls());
+      // Let the flow view know if we're using that register file.
+      ctx->registerFileRelevancy.push_back(registerFileRelevant);
 
-      switch (status)
-      {
-      case llvm::MCDisassembler::Fail: // let's try to squeeze out as many instructions as we can find...
-        instructionSize = std::max(instructionSize, (size_t)1);
-        result = false;
-        break;
-
-      default: // we ignore soft-fails.
-        flow.instructionExecutionInfo.emplace_back(decodedInstructions.size(), i);
-        decodedInstructions.push_back(retrievedInstruction);
-        break;
-      }
+      if (!registerFileRelevant)
+        continue;
 
-      i += instructionSize;
+      ctx->hardwareRegisters.emplace_back(registerFile.Name, registerFile.NumPhysRegs);
     }
+  }
 
-    // Have we found something?
-    if (decodedInstructions.size() == 0)
-      return false;
+  // `llvm-mca` passes 0 for everything and lets the pipeline fall back to the scheduling model, the same values are made explicit here so they can be inspected & overridden.
+  {
+    ctx->defaultPipelineOptions.dispatchWidth = std::max(schedulerModel.IssueWidth, 1u);
+
+    if (schedulerModel.hasExtraProcessorInfo())
+    {
+      const llvm::MCExtraProcessorInfo &extraInfo = schedulerModel.getExtraProcessorInfo();
+
+      if (extraInfo.LoadQueueID != 0)
+        ctx->defaultPipelineOptions.loadQueueSize = (uint32_t)std::max(schedulerModel.getProcResource(extraInfo.LoadQueueID)->BufferSize, 0);
+
+      if (extraInfo.StoreQueueID != 0)
+        ctx->defaultPipelineOptions.storeQueueSize = (uint32_t)std::max(schedulerModel.getProcResource(extraInfo.StoreQueueID)->BufferSize, 0);
+    }
+
+    ctx->pipelineOptions = ctx->defaultPipelineOptions;
   }
 
-  // Prepare everything for the instruction builder in order to retrieve `llvm::mca::Instruction`s from the `llvm::Inst`s.
-  std::unique_ptr<llvm::MCInstrInfo> instructionInfo(pTarget->createMCInstrInfo());
-  std::unique_ptr<llvm::MCInstrAnalysis> instructionAnalysis(pTarget->createMCInstrAnalysis(instructionInfo.get()));
-  llvm::mca::InstrPostProcess postProcess(*subtargetInfo, *instructionInfo);
-  std::unique_ptr<llvm::mca::InstrumentManager> instrumentManager(pTarget->createInstrumentManager(*subtargetInfo, *instructionInfo));
+  *ppContext = ctx.release();
 
-  if (instrumentManager == nullptr)
-    instrumentManager = std::make_unique<llvm::mca::InstrumentManager>(*subtargetInfo, *instructionInfo);
+  return true;
+}
 
-  llvm::mca::InstrPostProcess instructionPostProcess(*subtargetInfo, *instructionInfo);
-  llvm::mca::InstrBuilder instructionBuilder(*subtargetInfo, *instructionInfo, *registerInfo, instructionAnalysis.get(), *instrumentManager);
-  
-  instructionPostProcess.resetState();
+void execution_flow_context_destroy(ExecutionFlowContext **ppContext)
+{
+  if (ppContext == nullptr || *ppContext == nullptr)
+    return;
 
-  llvm::SmallVector<std::unique_ptr<llvm::mca::Instruction>> mcaInstructions;
+  delete *ppContext;
+  *ppContext = nullptr;
+}
 
-  // Retrieve `llvm::mca::Instruction`s.
-  for (const auto &instr : decodedInstructions)
+bool execution_flow_context_set_cache_directory(ExecutionFlowContext *pContext, const char *directory)
+{
+  if (pContext == nullptr)
+    return false;
+
+  if (directory == nullptr || directory[0] == '\0')
   {
-    llvm::Expected<std::unique_ptr<llvm::mca::Instruction>> mcaInstr = instructionBuilder.createInstruction(instr, llvm::SmallVector<llvm::mca::Instrument *>()); // from debugging llvm-mca it appears that the second parameter (vector) can be empty (at least whenever there aren't any jumps / calls in the active region.
+    pContext->cacheDirectory.clear();
+    return true;
+  }
 
-    if (!mcaInstr)
-    {
-      result = false;
-      break;
-    }
+  if (llvm::sys::fs::create_directories(directory))
+    return false;
 
-    postProcess.postProcessInstruction(mcaInstr.get(), instr);
-    mcaInstructions.emplace_back(std::move(mcaInstr.get()));
-  }
+  pContext->cacheDirectory = directory;
 
-  // Create source for the `Pipeline` & `HWEventListener`.
-  llvm::mca::CircularSourceMgr source(mcaInstructions, (uint32_t)iterations);
+  return true;
+}
 
-  // Create custom behaviour.
-  std::unique_ptr<llvm::mca::CustomBehaviour> customBehaviour(pTarget->createCustomBehaviour(*subtargetInfo, source, *instructionInfo));
+bool execution_flow_context_get_default_pipeline_options(const ExecutionFlowContext *pContext, PipelineOptions *pOptions)
+{
+  if (pContext == nullptr || pOptions == nullptr)
+    return false;
 
-  if (customBehaviour == nullptr)
-    customBehaviour = std::make_unique<llvm::mca::CustomBehaviour>(*subtargetInfo, source, *instructionInfo);
+  *pOptions = pContext->defaultPipelineOptions;
 
-  // Create MCA context.
-  llvm::mca::Context mcaContext(*registerInfo, *subtargetInfo);
+  return true;
+}
 
-  const llvm::MCSchedModel &schedulerModel = subtargetInfo->getSchedModel();
-  llvm::mca::PipelineOptions pipelineOptions(0, 0, 0, 0, 0, 0, true, true); // this seems very wrong, but that's what llvm-mca is doing and I don't see a way of retrieving the information from the `subtargetInfo` or `schedulerModel`.
+bool execution_flow_context_get_pipeline_options(const ExecutionFlowContext *pContext, PipelineOptions *pOptions)
+{
+  if (pContext == nullptr || pOptions == nullptr)
+    return false;
 
-  // Create and fill the pipeline with the source.
-  std::unique_ptr<llvm::mca::Pipeline> pipeline(mcaContext.createDefaultPipeline(pipelineOptions, source, *customBehaviour));
+  *pOptions = pContext->pipelineOptions;
 
-  // Create instruction printer for the FlowView.
-  std::unique_ptr<llvm::MCInstPrinter> instructionPrinter(pTarget->createMCInstPrinter(targetTriple, 1, *asmInfo, *instructionInfo, *registerInfo));
+  return true;
+}
 
-  // Create event handler to observe simulated hardware events.
-  FlowView flowView(&flow, schedulerModel, *instructionPrinter, relevantIteration);
-  pipeline->addEventListener(&flowView);
+bool execution_flow_context_set_pipeline_options(ExecutionFlowContext *pContext, const PipelineOptions &options)
+{
+  if (pContext == nullptr || options.dispatchWidth == 0)
+    return false;
 
-  // Get Stages from Scheduler model.
-  {
-    const size_t resourceTypeCount = schedulerModel.getNumProcResourceKinds();
-    size_t validTypeIndex = (size_t)-1;
+  pContext->pipelineOptions = options;
 
-    for (size_t i = 1; i < resourceTypeCount; i++) // index 0 appears to be used as `null`-index.
-    {
-      const llvm::MCProcResourceDesc *pResource = schedulerModel.getProcResource((uint32_t)i);
-      const size_t perResourcePortCount = pResource->NumUnits;
+  return true;
+}
 
-      if (perResourcePortCount == 0 || pResource->SubUnitsIdxBegin != nullptr) // if `SubUnitsIdxBegin` isn't `nullptr`, there'll be another resource that doesn't indicate *all* of the resources, but the sub-resources individually.
-        continue;
+bool execution_flow_create(const void *pAssembledBytes, const size_t assembledBytesLength, PortUsageFlow *pFlow, const CoreArchitecture arch, const size_t iterations, const size_t relevantIteration, const CollectionLevel collectionLevel /* = CollectionLevel::Full */)
+{
+  ExecutionFlowContext *pContext = nullptr;
 
-      ++validTypeIndex;
+  if (!execution_flow_context_create(&pContext, arch))
+    return false;
 
-      for (size_t j = 0; j < perResourcePortCount; j++)
-      {
-        std::string name = pResource->Name;
+  const bool result = execution_flow_create(pContext, pAssembledBytes, assembledBytesLength, pFlow, iterations, relevantIteration, collectionLevel);
 
-        if (perResourcePortCount > 1)
-          name = name + " " + std::to_string(j + 1);
+  execution_flow_context_destroy(&pContext);
 
-        flowView.addLLVMResourceToPortIndexLookup({ {i, (uint32_t)1 << j }, { flow.ports.size() }});
-        flow.ports.emplace_back(validTypeIndex, j, name);
-      }
-    }
-  }
+  return result;
+}
 
-  // Get Register Types and Counts from scheduler extra info.
-  if (schedulerModel.hasExtraProcessorInfo())
-  {
-    const llvm::MCExtraProcessorInfo &extraInfo = schedulerModel.getExtraProcessorInfo();
-    
-    for (size_t i = 0; i < extraInfo.NumRegisterFiles; i++)
+bool execution_flow_create_batch(const AssembledCodeRange *pCodeRanges, const size_t count, PortUsageFlow *pFlows, const CoreArchitecture arch, const size_t iterations, const size_t relevantIteration, bool *pSucceeded /* = nullptr */, const size_t threadCount /* = 0 */, const CollectionLevel collectionLevel /* = CollectionLevel::Full */)
+{
+  if (pCodeRanges == nullptr || pFlows == nullptr || (uint64_t)arch >= (uint64_t)CoreArchitecture::_Count || relevantIteration >= iterations || iterations > UINT32_MAX)
+    return false;
+
+  if (count == 0)
+    return true;
+
+  // Every worker lazily creates its own context, as they can't be shared between threads.
+  std::vector<ExecutionFlowContext *> contexts(thread_pool_worker_count(count, threadCount), nullptr);
+  std::atomic<bool> allSucceeded = true;
+
+  thread_pool_run(count, threadCount, [&](const size_t workerIndex, const size_t taskIndex)
     {
-      const llvm::MCRegisterFileDesc &registerFile = extraInfo.RegisterFiles[i];
-      const bool registerFileRelevant = (registerFile.NumPhysRegs != 0);
+      bool result = false;
 
-      // Let the flow view know if we're using that register file.
-      flowView.addRegisterFileRelevancy(registerFileRelevant);
+      if (contexts[workerIndex] != nullptr || execution_flow_context_create(&contexts[workerIndex], arch))
+        result = execution_flow_create(contexts[workerIndex], pCodeRanges[taskIndex].pAssembledBytes, pCodeRanges[taskIndex].assembledBytesLength, &pFlows[taskIndex], iterations, relevantIteration, collectionLevel);
 
-      if (!registerFileRelevant)
-        continue;
+      if (pSucceeded != nullptr)
+        pSucceeded[taskIndex] = result;
 
-      flow.hardwareRegisters.emplace_back(registerFile.Name, registerFile.NumPhysRegs);
-    }
-  }
+      if (!result)
+        allSucceeded = false;
+    });
 
-  // Run the pipeline.
-  llvm::Expected<uint32_t> cycles = pipeline->run();
+  for (auto &_context : contexts)
+    execution_flow_context_destroy(&_context);
 
-  if (!cycles)
-    result = false;
+  return allSucceeded;
+}
+
+bool execution_flow_create(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, PortUsageFlow *pFlow, const size_t iterations, const size_t relevantIteration, const CollectionLevel collectionLevel /* = CollectionLevel::Full */)
+{
+  if (pContext == nullptr || pFlow == nullptr || pAssembledBytes == nullptr || relevantIteration >= iterations || iterations > UINT32_MAX)
+    return false;
+
+  const uint64_t cacheKey = result_cache_get_key(pContext, pAssembledBytes, assembledBytesLength, "create", { iterations, relevantIteration, (uint64_t)collectionLevel });
+
+  if (result_cache_load(pContext, cacheKey, pFlow))
+    return true;
+
+  std::vector<llvm::MCInst> decodedInstructions;
+  PortUsageFlow flow;
+
+  bool result = execution_flow_decode(pContext, pAssembledBytes, assembledBytesLength, decodedInstructions, flow, collectionLevel == CollectionLevel::Full);
+
+  // Have we found something?
+  if (decodedInstructions.size() == 0)
+    return false;
+
+  SimulationParameters parameters;
+  parameters.collectionLevel = collectionLevel;
+
+  result &= execution_flow_simulate(pContext, decodedInstructions, flow, iterations, relevantIteration, parameters);
+
+  // Only complete results are cached, so failures are reported every time.
+  if (result)
+    result_cache_store(pContext, cacheKey, flow);
 
   *pFlow = std::move(flow);
 
   return result;
 }
 
-const char *core_arch_to_string(const CoreArchitecture arch)
+bool execution_flow_create_from_assembly(ExecutionFlowContext *pContext, const char *assemblyText, const size_t assemblyTextLength, const AssemblySyntax syntax, PortUsageFlow *pFlow, const size_t iterations, const size_t relevantIteration, const CollectionLevel collectionLevel /* = CollectionLevel::Full */)
 {
-  if ((size_t)arch >= std::size(CoreArchitectureLookup))
-    return nullptr;
+  if (pContext == nullptr || pFlow == nullptr || assemblyText == nullptr || relevantIteration >= iterations || iterations > UINT32_MAX)
+    return false;
 
-  return CoreArchitectureLookup[(size_t)arch];
+  const uint64_t cacheKey = result_cache_get_key(pContext, assemblyText, assemblyTextLength, "assembly", { iterations, relevantIteration, (uint64_t)collectionLevel, (uint64_t)syntax });
+
+  if (result_cache_load(pContext, cacheKey, pFlow))
+    return true;
+
+  std::vector<llvm::MCInst> assembledInstructions;
+  PortUsageFlow flow;
+
+  bool result = execution_flow_assemble(pContext, assemblyText, assemblyTextLength, syntax, assembledInstructions, flow, collectionLevel == CollectionLevel::Full);
+
+  // Have we found something?
+  if (assembledInstructions.size() == 0)
+    return false;
+
+  SimulationParameters parameters;
+  parameters.collectionLevel = collectionLevel;
+
+  result &= execution_flow_simulate(pContext, assembledInstructions, flow, iterations, relevantIteration, parameters);
+
+  if (result)
+    result_cache_store(pContext, cacheKey, flow);
+
+  *pFlow = std::move(flow);
+
+  return result;
+}
+
+bool execution_flow_create_streaming(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, PortUsageFlow *pFlow, const size_t iterations, const size_t relevantIteration, const size_t retainedIterations)
+{
+  if (pContext == nullptr || pFlow == nullptr || pAssembledBytes == nullptr || relevantIteration >= iterations || retainedIterations == 0)
+    return false;
+
+  const uint64_t cacheKey = result_cache_get_key(pContext, pAssembledBytes, assembledBytesLength, "streaming", { iterations, relevantIteration, retainedIterations });
+
+  if (result_cache_load(pContext, cacheKey, pFlow))
+    return true;
+
+  std::vector<llvm::MCInst> decodedInstructions;
+  PortUsageFlow flow;
+
+  bool result = execution_flow_decode(pContext, pAssembledBytes, assembledBytesLength, decodedInstructions, flow);
+
+  // Have we found something?
+  if (decodedInstructions.size() == 0)
+    return false;
+
+  // The `IncrementalSourceMgr` counts the instructions it has handed out in an `unsigned`.
+  if (iterations > UINT32_MAX / decodedInstructions.size())
+    return false;
+
+  SimulationParameters parameters;
+  parameters.retainedIterations = std::min(retainedIterations, iterations);
+
+  result &= execution_flow_simulate(pContext, decodedInstructions, flow, iterations, relevantIteration, parameters);
+
+  if (result)
+    result_cache_store(pContext, cacheKey, flow);
+
+  *pFlow = std::move(flow);
+
+  return result;
+}
+
+bool execution_flow_create_until_converged(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, PortUsageFlow *pFlow, const ConvergenceOptions &options, const size_t retainedIterations)
+{
+  if (pContext == nullptr || pFlow == nullptr || pAssembledBytes == nullptr || retainedIterations == 0 || options.maxIterations == 0 || options.tolerance < 0)
+    return false;
+
+  uint64_t tolerance;
+  static_assert(sizeof(tolerance) == sizeof(options.tolerance));
+  memcpy(&tolerance, &options.tolerance, sizeof(tolerance));
+
+  const uint64_t cacheKey = result_cache_get_key(pContext, pAssembledBytes, assembledBytesLength, "converged", { options.stableIterations, tolerance, options.maxIterations, retainedIterations });
+
+  if (result_cache_load(pContext, cacheKey, pFlow))
+    return true;
+
+  std::vector<llvm::MCInst> decodedInstructions;
+  PortUsageFlow flow;
+
+  bool result = execution_flow_decode(pContext, pAssembledBytes, assembledBytesLength, decodedInstructions, flow);
+
+  // Have we found something?
+  if (decodedInstructions.size() == 0)
+    return false;
+
+  // The `IncrementalSourceMgr` counts the instructions it has handed out in an `unsigned`.
+  const size_t maxIterations = std::min(options.maxIterations, (size_t)UINT32_MAX / decodedInstructions.size());
+
+  SimulationParameters parameters;
+  parameters.retainedIterations = std::min(retainedIterations, maxIterations);
+  parameters.pConvergenceOptions = &options;
+
+  result &= execution_flow_simulate(pContext, decodedInstructions, flow, maxIterations, 0, parameters);
+
+  if (result)
+    result_cache_store(pContext, cacheKey, flow);
+
+  *pFlow = std::move(flow);
+
+  return result;
+}
+
+bool execution_flow_create_columnar(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, PortUsageFlow *pFlow, const size_t iterations, const size_t relevantIteration)
+{
+  if (pContext == nullptr || pFlow == nullptr || pAssembledBytes == nullptr || relevantIteration >= iterations)
+    return false;
+
+  std::vector<llvm::MCInst> decodedInstructions;
+  PortUsageFlow flow;
+
+  bool result = execution_flow_decode(pContext, pAssembledBytes, assembledBytesLength, decodedInstructions, flow);
+
+  // Have we found something?
+  if (decodedInstructions.size() == 0)
+    return false;
+
+  // Records are indexed with `uint32_t`s.
+  if (iterations > UINT32_MAX / decodedInstructions.size())
+    return false;
+
+  SimulationParameters parameters;
+  parameters.columnar = true;
+
+  result &= execution_flow_simulate(pContext, decodedInstructions, flow, iterations, relevantIteration, parameters);
+
+  *pFlow = std::move(flow);
+
+  return result;
+}
+
+bool execution_flow_create_for_architectures(const void *pAssembledBytes, const size_t assembledBytesLength, const CoreArchitecture *pArchs, const size_t archCount, PortUsageFlow *pFlows, ArchitectureThroughput *pThroughput, const size_t iterations, const size_t relevantIteration, const size_t threadCount /* = 0 */)
+{
+  if (pAssembledBytes == nullptr || pArchs == nullptr || pFlows == nullptr || archCount == 0 || relevantIteration >= iterations || iterations > UINT32_MAX)
+    return false;
+
+  for (size_t i = 0; i < archCount; i++)
+    if ((uint64_t)pArchs[i] >= (uint64_t)CoreArchitecture::_Count)
+      return false;
+
+  // Every architecture needs a context of its own anyway, so the first one is also used for decoding.
+  std::vector<ExecutionFlowContext *> contexts(archCount, nullptr);
+
+  if (!execution_flow_context_create(&contexts[0], pArchs[0]))
+    return false;
+
+  // Decode only once. The X86 disassembler doesn't depend on the subtarget, so the decoded instructions are valid for every architecture.
+  std::vector<llvm::MCInst> decodedInstructions;
+  PortUsageFlow decodedFlow;
+
+  const bool decodedCompletely = execution_flow_decode(contexts[0], pAssembledBytes, assembledBytesLength, decodedInstructions, decodedFlow);
+
+  if (decodedInstructions.size() == 0)
+  {
+    execution_flow_context_destroy(&contexts[0]);
+    return false;
+  }
+
+  std::atomic<bool> allSucceeded = decodedCompletely;
+
+  thread_pool_run(archCount, threadCount, [&](const size_t, const size_t archIndex)
+    {
+      PortUsageFlow flow;
+      flow.instructionExecutionInfo = decodedFlow.instructionExecutionInfo;
+
+      bool result = false;
+
+      if (contexts[archIndex] != nullptr || execution_flow_context_create(&contexts[archIndex], pArchs[archIndex]))
+        result = execution_flow_simulate(contexts[archIndex], decodedInstructions, flow, iterations, relevantIteration);
+
+      if (pThroughput != nullptr)
+        pThroughput[archIndex] = execution_flow_get_throughput(flow, pArchs[archIndex], result);
+
+      pFlows[archIndex] = std::move(flow);
+
+      if (!result)
+        allSucceeded = false;
+
+      execution_flow_context_destroy(&contexts[archIndex]);
+    });
+
+  return allSucceeded;
 }
+
+// A copy of the scheduling model of a context with some of its limits replaced. `Context::createDefaultPipeline` always uses the model of the subtarget, so sweeps assemble the pipeline themselves.
+struct SweepModel
+{
+  llvm::MCSchedModel model;
+  llvm::MCExtraProcessorInfo extraInfo;
+  std::vector<llvm::MCProcResourceDesc> resources;
+  PipelineOptions options;
+
+  inline SweepModel(const llvm::MCSchedModel &original, const PipelineOptions &options) :
+    model(original),
+    extraInfo(),
+    resources(original.ProcResourceTable, original.ProcResourceTable + original.NumProcResourceKinds),
+    options(options)
+  {
+    model.ProcResourceTable = resources.data();
+
+    if (original.hasExtraProcessorInfo())
+    {
+      extraInfo = original.getExtraProcessorInfo();
+      model.ExtraProcessorInfo = &extraInfo;
+    }
+  }
+
+  SweepModel(const SweepModel &) = delete;
+  SweepModel &operator=(const SweepModel &) = delete;
+};
+
+static uint32_t execution_flow_get_sweep_value(const SweepModel &model, const SweepParameter &parameter, const size_t resourceIndex)
+{
+  switch (parameter.type)
+  {
+  case SPT_DispatchWidth: return model.options.dispatchWidth;
+  case SPT_MicroOpQueueSize: return model.options.microOpQueueSize;
+  case SPT_DecodersThroughput: return model.options.decodersThroughput;
+  case SPT_RegisterFileSize: return model.options.registerFileSize;
+  case SPT_LoadQueueSize: return model.options.loadQueueSize;
+  case SPT_StoreQueueSize: return model.options.storeQueueSize;
+  case SPT_ResourceUnits: return model.resources[resourceIndex].NumUnits;
+
+  case SPT_ReorderBufferSize:
+    // The retire control unit prefers the size from the extra processor info.
+    if (model.model.hasExtraProcessorInfo() && model.extraInfo.ReorderBufferSize != 0)
+      return model.extraInfo.ReorderBufferSize;
+    else
+      return model.model.MicroOpBufferSize;
+
+  default: return 0;
+  }
+}
+
+static void execution_flow_set_sweep_value(SweepModel &model, const SweepParameter &parameter, const size_t resourceIndex, const uint32_t value)
+{
+  switch (parameter.type)
+  {
+  case SPT_DispatchWidth: model.options.dispatchWidth = value; break;
+  case SPT_MicroOpQueueSize: model.options.microOpQueueSize = value; break;
+  case SPT_DecodersThroughput: model.options.decodersThroughput = value; break;
+  case SPT_RegisterFileSize: model.options.registerFileSize = value; break;
+  case SPT_LoadQueueSize: model.options.loadQueueSize = value; break;
+  case SPT_StoreQueueSize: model.options.storeQueueSize = value; break;
+  case SPT_ResourceUnits: model.resources[resourceIndex].NumUnits = value; break;
+
+  case SPT_ReorderBufferSize:
+    model.model.MicroOpBufferSize = value;
+
+    if (model.model.hasExtraProcessorInfo())
+      model.extraInfo.ReorderBufferSize = value;
+
+    break;
+
+  default: break;
+  }
+}
+
+bool execution_flow_sweep(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, const SweepParameter *pParameters, const size_t parameterCount, const size_t iterations, SweepResult *pResult, const size_t threadCount /* = 0 */)
+{
+  if (pContext == nullptr || pAssembledBytes == nullptr || pResult == nullptr || (pParameters == nullptr && parameterCount > 0) || iterations == 0 || iterations > UINT32_MAX)
+    return false;
+
+  const llvm::MCSchedModel &schedulerModel = pContext->subtargetInfo->getSchedModel();
+
+  if (!schedulerModel.isOutOfOrder())
+    return false;
+
+  const SweepModel baselineModel(schedulerModel, pContext->pipelineOptions);
+
+  // Validate the grid & look up the resources.
+  std::vector<size_t> resourceIndices(parameterCount, 0);
+  size_t configurationCount = 1;
+
+  for (size_t i = 0; i < parameterCount; i++)
+  {
+    const SweepParameter &parameter = pParameters[i];
+
+    if ((uint64_t)parameter.type >= (uint64_t)_SPT_Count || parameter.values.empty())
+      return false;
+
+    if (parameter.type == SPT_ResourceUnits)
+    {
+      for (size_t j = 1; j < schedulerModel.getNumProcResourceKinds(); j++)
+      {
+        const llvm::MCProcResourceDesc *pResource = schedulerModel.getProcResource((uint32_t)j);
+
+        if (pResource->NumUnits != 0 && pResource->SubUnitsIdxBegin == nullptr && parameter.resourceName == pResource->Name)
+        {
+          resourceIndices[i] = j;
+          break;
+        }
+      }
+
+      if (resourceIndices[i] == 0)
+        return false;
+    }
+
+    for (const uint32_t _value : parameter.values)
+    {
+      if (_value == 0 && (parameter.type == SPT_DispatchWidth || parameter.type == SPT_ReorderBufferSize || parameter.type == SPT_ResourceUnits))
+        return false;
+
+      // The units of a resource are tracked as bits of a 64 bit mask.
+      if (_value > 64 && parameter.type == SPT_ResourceUnits)
+        return false;
+    }
+
+    if (configurationCount > UINT32_MAX / parameter.values.size())
+      return false;
+
+    configurationCount *= parameter.values.size();
+  }
+
+  // Decode & build the simulated instructions only once, the pipelines only copy them.
+  std::vector<llvm::MCInst> decodedInstructions;
+  PortUsageFlow decodedFlow;
+
+  if (!execution_flow_decode(pContext, pAssembledBytes, assembledBytesLength, decodedInstructions, decodedFlow, false) || decodedInstructions.size() == 0)
+    return false;
+
+  llvm::SmallVector<std::unique_ptr<llvm::mca::Instruction>> mcaInstructions;
+
+  if (!execution_flow_create_mca_instructions(pContext, decodedInstructions, mcaInstructions))
+    return false;
+
+  pResult->baselineValues.resize(parameterCount);
+
+  for (size_t i = 0; i < parameterCount; i++)
+    pResult->baselineValues[i] = execution_flow_get_sweep_value(baselineModel, pParameters[i], resourceIndices[i]);
+
+  pResult->configurations.clear();
+  pResult->configurations.resize(configurationCount);
+
+  // Task 0 is the baseline.
+  std::atomic<bool> allSucceeded = true;
+
+  thread_pool_run(configurationCount + 1, threadCount, [&](const size_t, const size_t taskIndex)
+    {
+      SweepModel model(schedulerModel, pContext->pipelineOptions);
+      std::vector<uint32_t> values;
+
+      if (taskIndex > 0)
+      {
+        values.resize(parameterCount);
+
+        for (size_t i = parameterCount, remainder = taskIndex - 1; i-- > 0; remainder /= pParameters[i].values.size())
+        {
+          values[i] = pParameters[i].values[remainder % pParameters[i].values.size()];
+          execution_flow_set_sweep_value(model, pParameters[i], resourceIndices[i], values[i]);
+        }
+      }
+
+      PortUsageFlow flow;
+      flow.instructionExecutionInfo = decodedFlow.instructionExecutionInfo;
+
+      const bool result = execution_flow_simulate_with_model(pContext, model, mcaInstructions, iterations, flow);
+      const ArchitectureThroughput throughput = execution_flow_get_throughput(flow, pContext->arch, result);
+
+      if (taskIndex == 0)
+      {
+        pResult->baseline = throughput;
+      }
+      else
+      {
+        pResult->configurations[taskIndex - 1].values = std::move(values);
+        pResult->configurations[taskIndex - 1].throughput = throughput;
+      }
+
+      if (!result)
+        allSucceeded = false;
+    });
+
+  return allSucceeded;
+}
+
+// `InstrDesc` can't be copied and every `mca::Instruction` references its descriptor, so cheaper variants of an instruction are rebuilt around a modified copy of the descriptor.
+// Latencies & resource cycles only live in the descriptor, `InstrPostProcess` & `CustomBehaviour` can't change them.
+struct CheaperInstruction
+{
+  llvm::mca::InstrDesc desc;
+  std::unique_ptr<llvm::mca::Instruction> instruction;
+};
+
+static void execution_flow_copy_instruction_desc(const llvm::mca::InstrDesc &originalDesc, llvm::mca::InstrDesc &desc)
+{
+  desc.Writes = originalDesc.Writes;
+  desc.Reads = originalDesc.Reads;
+  desc.Resources = originalDesc.Resources;
+  desc.UsedBuffers = originalDesc.UsedBuffers;
+  desc.UsedProcResUnits = originalDesc.UsedProcResUnits;
+  desc.UsedProcResGroups = originalDesc.UsedProcResGroups;
+  desc.MaxLatency = originalDesc.MaxLatency;
+  desc.NumMicroOps = originalDesc.NumMicroOps;
+  desc.SchedClassID = originalDesc.SchedClassID;
+  desc.MustIssueImmediately = originalDesc.MustIssueImmediately;
+  desc.IsRecyclable = originalDesc.IsRecyclable;
+  desc.HasPartiallyOverlappingGroups = originalDesc.HasPartiallyOverlappingGroups;
+}
+
+// Rebuilds `original` around the (already modified) `cheaper.desc`. Unless `recreateWrites` is set, the write descriptors have to be identical to the ones of the original.
+static bool execution_flow_rebuild_instruction(const llvm::MCInst &instruction, const llvm::mca::Instruction &original, const bool recreateWrites, CheaperInstruction &cheaper)
+{
+  const llvm::mca::InstrDesc &desc = cheaper.desc;
+
+  cheaper.instruction = std::make_unique<llvm::mca::Instruction>(desc, original.getOpcode());
+  llvm::mca::Instruction &rebuilt = *cheaper.instruction;
+
+  if (!recreateWrites)
+  {
+    rebuilt.getDefs().append(original.getDefs().begin(), original.getDefs().end());
+  }
+  else
+  {
+    // Writes reference their descriptor, so they're recreated. The `InstrBuilder` creates them in descriptor order, but skips some (e.g. optional definitions without a register).
+    size_t writeIndex = 0;
+
+    for (const auto &_originalWrite : original.getDefs())
+    {
+      for (; writeIndex < desc.Writes.size(); writeIndex++)
+      {
+        const llvm::mca::WriteDescriptor &write = desc.Writes[writeIndex];
+        llvm::MCPhysReg reg = write.RegisterID;
+
+        if (!write.isImplicitWrite())
+          reg = ((size_t)write.OpIndex < instruction.getNumOperands() && instruction.getOperand(write.OpIndex).isReg()) ? instruction.getOperand(write.OpIndex).getReg() : 0;
+
+        if (reg == _originalWrite.getRegisterID())
+          break;
+      }
+
+      if (writeIndex == desc.Writes.size())
+        return false;
+
+      rebuilt.getDefs().emplace_back(desc.Writes[writeIndex], _originalWrite.getRegisterID(), _originalWrite.clearsSuperRegisters(), _originalWrite.isWriteZero());
+      writeIndex++;
+    }
+  }
+
+  // Reads reference the original descriptor, which is identical & outlives the simulation.
+  rebuilt.getUses().append(original.getUses().begin(), original.getUses().end());
+
+  for (size_t i = 0; i < instruction.getNumOperands(); i++)
+    if (const llvm::mca::MCAOperand *pOperand = original.getOperand((uint32_t)i))
+      rebuilt.addOperand(*pOperand);
+
+  if (original.isOptimizableMove())
+    rebuilt.setOptimizableMove();
+
+  rebuilt.setUsedBuffers(original.getUsedBuffers());
+  rebuilt.setLoadBarrier(original.isALoadBarrier());
+  rebuilt.setStoreBarrier(original.isAStoreBarrier());
+  rebuilt.setMayLoad(original.getMayLoad());
+  rebuilt.setMayStore(original.getMayStore());
+  rebuilt.setHasSideEffects(original.getHasSideEffects());
+  rebuilt.setBeginGroup(original.getBeginGroup());
+  rebuilt.setEndGroup(original.getEndGroup());
+  rebuilt.setRetireOOO(original.getRetireOOO());
+
+  return true;
+}
+
+static bool execution_flow_create_cheaper_instruction(const llvm::MCInst &instruction, const llvm::mca::Instruction &original, const bool halveLatency, CheaperInstruction &cheaper)
+{
+  llvm::mca::InstrDesc &desc = cheaper.desc;
+  execution_flow_copy_instruction_desc(original.getDesc(), desc);
+
+  // Both are rounded up, so 1 cycle latencies & resource cycles stay the same & the two variants are comparable.
+  if (halveLatency)
+  {
+    for (auto &_write : desc.Writes)
+      _write.Latency = (_write.Latency + 1) / 2;
+
+    desc.MaxLatency = (desc.MaxLatency + 1) / 2;
+  }
+  else
+  {
+    for (auto &_resource : desc.Resources)
+      _resource.second.CS = llvm::mca::CycleSegment(0, (_resource.second.size() + 1) / 2, _resource.second.isReserved());
+  }
+
+  // Writes reference their descriptor, so they only have to be recreated if their latency changed.
+  return execution_flow_rebuild_instruction(instruction, original, halveLatency, cheaper);
+}
+
+bool execution_flow_get_sensitivity(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, const size_t iterations, SensitivityResult *pResult, const size_t threadCount /* = 0 */)
+{
+  if (pContext == nullptr || pAssembledBytes == nullptr || pResult == nullptr || iterations == 0 || iterations > UINT32_MAX)
+    return false;
+
+  const llvm::MCSchedModel &schedulerModel = pContext->subtargetInfo->getSchedModel();
+
+  if (!schedulerModel.isOutOfOrder())
+    return false;
+
+  // Decode & build the simulated instructions only once, every variant only replaces a single one of them.
+  std::vector<llvm::MCInst> decodedInstructions;
+  PortUsageFlow decodedFlow;
+
+  if (!execution_flow_decode(pContext, pAssembledBytes, assembledBytesLength, decodedInstructions, decodedFlow, false) || decodedInstructions.size() == 0)
+    return false;
+
+  llvm::SmallVector<std::unique_ptr<llvm::mca::Instruction>> mcaInstructions;
+
+  if (!execution_flow_create_mca_instructions(pContext, decodedInstructions, mcaInstructions))
+    return false;
+
+  const size_t instructionCount = mcaInstructions.size();
+
+  // Task 0 is the baseline, followed by the halved latency & halved resource cycles variant of every instruction.
+  std::vector<ArchitectureThroughput> throughput(instructionCount * 2 + 1);
+
+  thread_pool_run(throughput.size(), threadCount, [&](const size_t, const size_t taskIndex)
+    {
+      const SweepModel model(schedulerModel, pContext->pipelineOptions);
+      CheaperInstruction cheaper;
+      size_t replacedIndex = (size_t)-1;
+
+      if (taskIndex > 0)
+      {
+        replacedIndex = (taskIndex - 1) / 2;
+
+        if (!execution_flow_create_cheaper_instruction(decodedInstructions[replacedIndex], *mcaInstructions[replacedIndex], (taskIndex - 1) % 2 == 0, cheaper))
+          return;
+      }
+
+      llvm::SmallVector<std::unique_ptr<llvm::mca::Instruction>> instructions;
+
+      for (size_t i = 0; i < instructionCount; i++)
+        instructions.emplace_back(std::make_unique<llvm::mca::Instruction>(i == replacedIndex ? *cheaper.instruction : *mcaInstructions[i]));
+
+      PortUsageFlow flow;
+      flow.instructionExecutionInfo = decodedFlow.instructionExecutionInfo;
+
+      const bool result = execution_flow_simulate_with_model(pContext, model, instructions, iterations, flow);
+      throughput[taskIndex] = execution_flow_get_throughput(flow, pContext->arch, result);
+    });
+
+  pResult->baseline = throughput[0];
+  pResult->instructions.clear();
+
+  bool allSucceeded = throughput[0].succeeded;
+
+  for (size_t i = 0; i < instructionCount; i++)
+  {
+    InstructionSensitivity sensitivity(i);
+    const ArchitectureThroughput &halvedLatency = throughput[i * 2 + 1];
+    const ArchitectureThroughput &halvedResourceCycles = throughput[i * 2 + 2];
+
+    sensitivity.succeeded = throughput[0].succeeded && halvedLatency.succeeded && halvedResourceCycles.succeeded;
+
+    if (sensitivity.succeeded)
+    {
+      sensitivity.halvedLatencyDelta = halvedLatency.cyclesPerIteration - throughput[0].cyclesPerIteration;
+      sensitivity.halvedResourceCyclesDelta = halvedResourceCycles.cyclesPerIteration - throughput[0].cyclesPerIteration;
+    }
+
+    allSucceeded &= sensitivity.succeeded;
+    pResult->instructions.push_back(sensitivity);
+  }
+
+  std::stable_sort(pResult->instructions.begin(), pResult->instructions.end(), [](const InstructionSensitivity &a, const InstructionSensitivity &b)
+    {
+      if (a.succeeded != b.succeeded)
+        return a.succeeded;
+
+      return a.bestDelta() < b.bestDelta();
+    });
+
+  return allSucceeded;
+}
+
+bool execution_flow_get_port_sensitivity(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, const size_t iterations, PortSensitivityResult *pResult, const size_t threadCount /* = 0 */)
+{
+  if (pContext == nullptr || pAssembledBytes == nullptr || pResult == nullptr || iterations == 0 || iterations > UINT32_MAX)
+    return false;
+
+  const llvm::MCSchedModel &schedulerModel = pContext->subtargetInfo->getSchedModel();
+
+  if (!schedulerModel.isOutOfOrder())
+    return false;
+
+  // Decode & build the simulated instructions only once, every variant only replaces the ones that use the resource.
+  std::vector<llvm::MCInst> decodedInstructions;
+  PortUsageFlow decodedFlow;
+
+  if (!execution_flow_decode(pContext, pAssembledBytes, assembledBytesLength, decodedInstructions, decodedFlow, false) || decodedInstructions.size() == 0)
+    return false;
+
+  llvm::SmallVector<std::unique_ptr<llvm::mca::Instruction>> mcaInstructions;
+
+  if (!execution_flow_create_mca_instructions(pContext, decodedInstructions, mcaInstructions))
+    return false;
+
+  // The same resources that have been enumerated into `PortUsageFlow::ports`.
+  std::vector<uint64_t> resourceMasks(schedulerModel.getNumProcResourceKinds(), 0);
+  llvm::mca::computeProcResourceMasks(schedulerModel, resourceMasks);
+
+  std::vector<size_t> llvmResourceIndices;
+  pResult->resources.clear();
+
+  for (size_t i = 1; i < schedulerModel.getNumProcResourceKinds(); i++)
+  {
+    const llvm::MCProcResourceDesc *pResource = schedulerModel.getProcResource((uint32_t)i);
+
+    if (pResource->NumUnits == 0 || pResource->SubUnitsIdxBegin != nullptr)
+      continue;
+
+    pResult->resources.emplace_back(llvmResourceIndices.size(), pResource->Name, pResource->NumUnits);
+    llvmResourceIndices.push_back(i);
+  }
+
+  const size_t resourceCount = pResult->resources.size();
+  const size_t instructionCount = mcaInstructions.size();
+
+  // Task 0 is the baseline, followed by the one-more-unit & zero-occupancy variant of every resource.
+  std::vector<ArchitectureThroughput> throughput(resourceCount * 2 + 1);
+
+  thread_pool_run(throughput.size(), threadCount, [&](const size_t, const size_t taskIndex)
+    {
+      SweepModel model(schedulerModel, pContext->pipelineOptions);
+      std::vector<std::unique_ptr<CheaperInstruction>> cheaper(instructionCount);
+
+      if (taskIndex > 0)
+      {
+        const size_t llvmResourceIndex = llvmResourceIndices[(taskIndex - 1) / 2];
+
+        if ((taskIndex - 1) % 2 == 0)
+        {
+          // The units of a resource are tracked as bits of a 64 bit mask.
+          if (model.resources[llvmResourceIndex].NumUnits >= 64)
+            return;
+
+          // The added unit is listed as a port of its own, since `execution_flow_simulate_with_model` enumerates the ports of the modified model.
+          model.resources[llvmResourceIndex].NumUnits++;
+        }
+        else
+        {
+          // Only the direct uses are dropped, uops that may be issued to any unit of a group containing the resource can still be issued to it.
+          const uint64_t mask = resourceMasks[llvmResourceIndex];
+
+          for (size_t i = 0; i < instructionCount; i++)
+          {
+            const llvm::mca::InstrDesc &originalDesc = mcaInstructions[i]->getDesc();
+
+            if (std::none_of(originalDesc.Resources.begin(), originalDesc.Resources.end(), [mask](const auto &resource) { return resource.first == mask; }))
+              continue;
+
+            cheaper[i] = std::make_unique<CheaperInstruction>();
+            llvm::mca::InstrDesc &desc = cheaper[i]->desc;
+            execution_flow_copy_instruction_desc(originalDesc, desc);
+
+            desc.Resources.erase(std::remove_if(desc.Resources.begin(), desc.Resources.end(), [mask](const auto &resource) { return resource.first == mask; }), desc.Resources.end());
+            desc.UsedProcResUnits &= ~mask;
+
+            if (!execution_flow_rebuild_instruction(decodedInstructions[i], *mcaInstructions[i], false, *cheaper[i]))
+              return;
+          }
+        }
+      }
+
+      llvm::SmallVector<std::unique_ptr<llvm::mca::Instruction>> instructions;
+
+      for (size_t i = 0; i < instructionCount; i++)
+        instructions.emplace_back(std::make_unique<llvm::mca::Instruction>(cheaper[i] != nullptr ? *cheaper[i]->instruction : *mcaInstructions[i]));
+
+      PortUsageFlow flow;
+      flow.instructionExecutionInfo = decodedFlow.instructionExecutionInfo;
+
+      const bool result = execution_flow_simulate_with_model(pContext, model, instructions, iterations, flow);
+      throughput[taskIndex] = execution_flow_get_throughput(flow, pContext->arch, result);
+    });
+
+  pResult->baseline = throughput[0];
+
+  bool allSucceeded = throughput[0].succeeded;
+
+  for (size_t i = 0; i < resourceCount; i++)
+  {
+    PortSensitivity &sensitivity = pResult->resources[i];
+    const ArchitectureThroughput &extraUnit = throughput[i * 2 + 1];
+    const ArchitectureThroughput &zeroOccupancy = throughput[i * 2 + 2];
+
+    sensitivity.succeeded = throughput[0].succeeded && extraUnit.succeeded && zeroOccupancy.succeeded;
+
+    if (sensitivity.succeeded)
+    {
+      sensitivity.extraUnitDelta = extraUnit.cyclesPerIteration - throughput[0].cyclesPerIteration;
+      sensitivity.zeroOccupancyDelta = zeroOccupancy.cyclesPerIteration - throughput[0].cyclesPerIteration;
+    }
+
+    allSucceeded &= sensitivity.succeeded;
+  }
+
+  std::stable_sort(pResult->resources.begin(), pResult->resources.end(), [](const PortSensitivity &a, const PortSensitivity &b)
+    {
+      if (a.succeeded != b.succeeded)
+        return a.succeeded;
+
+      return a.bestDelta() < b.bestDelta();
+    });
+
+  return allSucceeded;
+}
+
+// Resource cycles that may be spread over a set of resources that aren't groups (the bits of `unitMask` are indices into the list of these resources).
+struct PortPressureDemand
+{
+  uint64_t unitMask;
+  double cycles;
+};
+
+// Checks whether the demands fit if no unit may be busy for more than `bound` cycles by finding the maximum flow from the demands through the units they may use.
+// `flowPerResource` receives the resource cycles assigned to every resource.
+static bool execution_flow_assign_port_pressure(const llvm::ArrayRef<PortPressureDemand> demands, const llvm::ArrayRef<uint32_t> unitsPerResource, const double bound, std::vector<double> &flowPerResource)
+{
+  const size_t demandCount = demands.size();
+  const size_t resourceCount = unitsPerResource.size();
+  const size_t nodeCount = demandCount + resourceCount + 2;
+  const size_t source = 0;
+  const size_t sink = nodeCount - 1;
+
+  std::vector<double> capacity(nodeCount * nodeCount, 0);
+  double totalDemand = 0;
+
+  for (size_t i = 0; i < demandCount; i++)
+  {
+    capacity[source * nodeCount + 1 + i] = demands[i].cycles;
+    totalDemand += demands[i].cycles;
+
+    for (size_t j = 0; j < resourceCount; j++)
+      if (demands[i].unitMask & (1ULL << j))
+        capacity[(1 + i) * nodeCount + 1 + demandCount + j] = demands[i].cycles;
+  }
+
+  for (size_t j = 0; j < resourceCount; j++)
+    capacity[(1 + demandCount + j) * nodeCount + sink] = bound * unitsPerResource[j];
+
+  const std::vector<double> initialCapacity = capacity;
+  const double epsilon = 1e-9 * std::max(totalDemand, 1.0);
+  double totalFlow = 0;
+
+  // Edmonds-Karp: the graph only has a few dozen nodes.
+  std::vector<size_t> previous(nodeCount);
+  std::queue<size_t> queue;
+
+  while (true)
+  {
+    std::fill(previous.begin(), previous.end(), (size_t)-1);
+    previous[source] = source;
+    queue.push(source);
+
+    while (!queue.empty() && previous[sink] == (size_t)-1)
+    {
+      const size_t node = queue.front();
+      queue.pop();
+
+      for (size_t next = 0; next < nodeCount; next++)
+      {
+        if (previous[next] == (size_t)-1 && capacity[node * nodeCount + next] > epsilon)
+        {
+          previous[next] = node;
+          queue.push(next);
+        }
+      }
+    }
+
+    queue = std::queue<size_t>();
+
+    if (previous[sink] == (size_t)-1)
+      break;
+
+    double pathFlow = std::numeric_limits<double>::max();
+
+    for (size_t node = sink; node != source; node = previous[node])
+      pathFlow = std::min(pathFlow, capacity[previous[node] * nodeCount + node]);
+
+    for (size_t node = sink; node != source; node = previous[node])
+    {
+      capacity[previous[node] * nodeCount + node] -= pathFlow;
+      capacity[node * nodeCount + previous[node]] += pathFlow;
+    }
+
+    totalFlow += pathFlow;
+  }
+
+  flowPerResource.resize(resourceCount);
+
+  for (size_t j = 0; j < resourceCount; j++)
+  {
+    const size_t edge = (1 + demandCount + j) * nodeCount + sink;
+    flowPerResource[j] = initialCapacity[edge] - capacity[edge];
+  }
+
+  return totalFlow >= totalDemand - epsilon * nodeCount;
+}
+
+bool execution_flow_get_throughput_bounds(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, ThroughputBounds *pBounds)
+{
+  if (pContext == nullptr || pAssembledBytes == nullptr || pBounds == nullptr)
+    return false;
+
+  *pBounds = ThroughputBounds();
+
+  std::vector<llvm::MCInst> decodedInstructions;
+  PortUsageFlow decodedFlow;
+
+  if (!execution_flow_decode(pContext, pAssembledBytes, assembledBytesLength, decodedInstructions, decodedFlow, false) || decodedInstructions.size() == 0)
+    return false;
+
+  llvm::SmallVector<std::unique_ptr<llvm::mca::Instruction>> mcaInstructions;
+
+  if (!execution_flow_create_mca_instructions(pContext, decodedInstructions, mcaInstructions))
+    return false;
+
+  const llvm::MCSchedModel &schedulerModel = pContext->subtargetInfo->getSchedModel();
+  pBounds->instructionCount = mcaInstructions.size();
+
+  // Port pressure: the resources that aren't groups are the ones that have been enumerated into `PortUsageFlow::ports`.
+  {
+    std::vector<uint64_t> resourceMasks(schedulerModel.getNumProcResourceKinds(), 0);
+    llvm::mca::computeProcResourceMasks(schedulerModel, resourceMasks);
+
+    std::vector<size_t> llvmResourceIndices;
+    std::vector<uint32_t> unitsPerResource;
+    uint64_t resourceMaskToUnitMask[64] = {}; // by the bit index of the mask of a resource that isn't a group.
+
+    for (size_t i = 1; i < schedulerModel.getNumProcResourceKinds(); i++)
+    {
+      const llvm::MCProcResourceDesc *pResource = schedulerModel.getProcResource((uint32_t)i);
+
+      if (pResource->NumUnits == 0 || pResource->SubUnitsIdxBegin != nullptr || llvm::popcount(resourceMasks[i]) != 1)
+        continue;
+
+      resourceMaskToUnitMask[llvm::countr_zero(resourceMasks[i])] = 1ULL << llvmResourceIndices.size();
+      llvmResourceIndices.push_back(i);
+      unitsPerResource.push_back(pResource->NumUnits);
+    }
+
+    if (llvmResourceIndices.size() > 64)
+      return false;
+
+    std::vector<PortPressureDemand> demands;
+    double totalDemand = 0;
+
+    for (const auto &_instruction : mcaInstructions)
+    {
+      for (const auto &_resource : _instruction->getDesc().Resources)
+      {
+        // Reserved groups don't consume any cycles themselves, their units are listed separately.
+        if (_resource.second.isReserved() || _resource.second.size() == 0)
+          continue;
+
+        // The mask of a group also contains the bit of the group itself, which is its most significant one.
+        uint64_t mask = _resource.first;
+
+        if (llvm::popcount(mask) > 1)
+          mask ^= 1ULL << (63 - llvm::countl_zero(mask));
+
+        uint64_t unitMask = 0;
+
+        for (; mask != 0; mask &= mask - 1)
+          unitMask |= resourceMaskToUnitMask[llvm::countr_zero(mask)];
+
+        if (unitMask == 0)
+          continue;
+
+        const double cycles = (double)_resource.second.size() * _resource.second.NumUnits;
+        auto demand = std::find_if(demands.begin(), demands.end(), [unitMask](const PortPressureDemand &d) { return d.unitMask == unitMask; });
+
+        if (demand == demands.end())
+          demands.push_back({ unitMask, cycles });
+        else
+          demand->cycles += cycles;
+
+        totalDemand += cycles;
+      }
+    }
+
+    std::vector<double> flowPerResource(llvmResourceIndices.size(), 0);
+
+    if (totalDemand > 0)
+    {
+      // Bisect the smallest bound that all the demands fit into. Every resource has at least one unit, so the total demand always fits.
+      double low = 0;
+      double high = totalDemand;
+
+      while (high - low > 1e-4 * high)
+      {
+        const double mid = (low + high) * 0.5;
+
+        if (execution_flow_assign_port_pressure(demands, unitsPerResource, mid, flowPerResource))
+          high = mid;
+        else
+          low = mid;
+      }
+
+      execution_flow_assign_port_pressure(demands, unitsPerResource, high, flowPerResource);
+      pBounds->bounds[TBT_PortPressure] = high;
+    }
+
+    pBounds->portPressureCycles.resize(pContext->ports.size(), 0);
+
+    for (size_t i = 0; i < llvmResourceIndices.size(); i++)
+    {
+      // The maximum flow isn't necessarily balanced, but no unit exceeds the bound.
+      const double perUnit = flowPerResource[i] / unitsPerResource[i];
+
+      for (size_t j = 0; j < unitsPerResource[i] && j < pContext->resourceUnitStride; j++)
+      {
+        const uint32_t portIndex = pContext->resourceUnitToPortIndex[llvmResourceIndices[i] * pContext->resourceUnitStride + j];
+
+        if (portIndex < pBounds->portPressureCycles.size())
+          pBounds->portPressureCycles[portIndex] = perUnit;
+      }
+    }
+
+    double maxPressure = 0;
+
+    for (size_t i = 0; i < pBounds->portPressureCycles.size(); i++)
+    {
+      if (pBounds->portPressureCycles[i] > maxPressure)
+      {
+        maxPressure = pBounds->portPressureCycles[i];
+        pBounds->bottleneckPort = i;
+      }
+    }
+
+    if (pBounds->bottleneckPort != (size_t)-1)
+      pBounds->bottleneckPortName = pContext->ports[pBounds->bottleneckPort].name;
+  }
+
+  // Loop-carried dependencies: run the body with unlimited resources & measure how fast the completion time grows once the chains that aren't carried have settled.
+  {
+    constexpr size_t SettleIterations = 32;
+    constexpr size_t MeasuredIterations = 32;
+
+    std::vector<uint64_t> readyCycle(pContext->registerInfo->getNumRegUnits(), 0);
+    uint64_t latestCycle = 0;
+    uint64_t settledCycle = 0;
+
+    for (size_t iteration = 0; iteration < SettleIterations + MeasuredIterations; iteration++)
+    {
+      if (iteration == SettleIterations)
+        settledCycle = latestCycle;
+
+      for (const auto &_instruction : mcaInstructions)
+      {
+        uint64_t startCycle = 0;
+
+        for (const auto &_use : _instruction->getUses())
+          if (_use.getRegisterID() != 0 && !_use.isIndependentFromDef())
+            for (const llvm::MCRegUnit _unit : pContext->registerInfo->regunits(_use.getRegisterID()))
+              startCycle = std::max(startCycle, readyCycle[_unit]);
+
+        for (const auto &_def : _instruction->getDefs())
+        {
+          if (_def.getRegisterID() == 0)
+            continue;
+
+          const uint64_t cycle = startCycle + _def.getLatency();
+          latestCycle = std::max(latestCycle, cycle);
+
+          for (const llvm::MCRegUnit _unit : pContext->registerInfo->regunits(_def.getRegisterID()))
+            readyCycle[_unit] = cycle;
+        }
+      }
+    }
+
+    pBounds->bounds[TBT_LoopCarriedDependency] = (latestCycle - settledCycle) / (double)MeasuredIterations;
+  }
+
+  // Dispatch width.
+  {
+    for (const auto &_instruction : mcaInstructions)
+      pBounds->uOpsPerIteration += _instruction->getDesc().NumMicroOps;
+
+    pBounds->bounds[TBT_DispatchWidth] = pBounds->uOpsPerIteration / (double)pContext->pipelineOptions.dispatchWidth;
+  }
+
+  for (size_t i = 0; i < _TBT_Count; i++)
+  {
+    if (pBounds->bounds[i] > pBounds->cyclesPerIteration)
+    {
+      pBounds->cyclesPerIteration = pBounds->bounds[i];
+      pBounds->binding = (ThroughputBoundType)i;
+    }
+  }
+
+  pBounds->succeeded = true;
+
+  return true;
+}
+
+ArchitectureThroughput execution_flow_get_throughput(const PortUsageFlow &flow, const CoreArchitecture arch, const bool succeeded)
+{
+  ArchitectureThroughput throughput(arch);
+  throughput.succeeded = succeeded;
+
+  // The flow statistics cover every iteration, even if `perIteration` hasn't been collected or only holds a window.
+  const size_t earliestDispatch = flow.statistics.firstDispatch;
+  const size_t lastRetire = flow.statistics.lastRetire;
+  const size_t iterations = flow.statistics.retiredIterations;
+
+  for (const auto &_instruction : flow.instructionExecutionInfo)
+    throughput.uOpsPerIteration += _instruction.uOpCount;
+
+  if (iterations == 0 || lastRetire < earliestDispatch)
+    return throughput;
+
+  throughput.totalCycles = lastRetire - earliestDispatch;
+  throughput.cyclesPerIteration = throughput.totalCycles / (double)iterations;
+
+  if (throughput.totalCycles > 0)
+  {
+    throughput.instructionsPerCycle = (flow.instructionExecutionInfo.size() * iterations) / (double)throughput.totalCycles;
+    throughput.uOpsPerCycle = (throughput.uOpsPerIteration * iterations) / (double)throughput.totalCycles;
+  }
+
+  return throughput;
+}
+
+bool execution_flow_get_columns(const PortUsageFlow &flow, FlowColumns *pColumns)
+{
+  if (pColumns == nullptr)
+    return false;
+
+  const size_t instructionCount = flow.instructionExecutionInfo.size();
+  size_t iterationCount = 0;
+
+  for (const auto &_instruction : flow.instructionExecutionInfo)
+    iterationCount = std::max(iterationCount, _instruction.perIteration.size());
+
+  if (instructionCount != 0 && iterationCount > UINT32_MAX / instructionCount)
+    return false;
+
+  FlowColumns columns;
+  columns.reset(instructionCount, iterationCount);
+
+  llvm::StringMap<uint32_t> nameIds;
+
+  auto getNameId = [&](const std::string &name) -> uint32_t
+  {
+    const auto &entry = nameIds.try_emplace(name, (uint32_t)columns.names.size());
+
+    if (entry.second)
+      columns.names.push_back(name);
+
+    return entry.first->second;
+  };
+
+  // Origins are absolute iteration indices, records are relative to the retained window.
+  auto getOriginRecord = [&](const std::optional<DependencyOrigin> &origin) -> uint32_t
+  {
+    if (!origin.has_value() || origin.value().iterationIndex == (size_t)-1 || origin.value().iterationIndex < flow.firstRetainedIteration || origin.value().iterationIndex - flow.firstRetainedIteration >= iterationCount)
+      return FlowColumns::None;
+
+    return (uint32_t)columns.recordIndex(origin.value().iterationIndex - flow.firstRetainedIteration, origin.value().instructionIndex);
+  };
+
+  for (size_t iteration = 0; iteration < iterationCount; iteration++)
+  {
+    for (size_t instruction = 0; instruction < instructionCount; instruction++)
+    {
+      const auto &perIteration = flow.instructionExecutionInfo[instruction].perIteration;
+
+      if (perIteration.size() <= iteration)
+        continue;
+
+      const LoopInstructionInfo &it = perIteration[iteration];
+      const size_t record = columns.recordIndex(iteration, instruction);
+
+      columns.clockDispatched[record] = (uint32_t)it.clockDispatched;
+      columns.clockPending[record] = (uint32_t)it.clockPending;
+      columns.clockReady[record] = (uint32_t)it.clockReady;
+      columns.clockIssued[record] = (uint32_t)it.clockIssued;
+      columns.clockExecuted[record] = (uint32_t)it.clockExecuted;
+      columns.clockRetired[record] = (uint32_t)it.clockRetired;
+      columns.uOps[record] = (uint32_t)it.uOps;
+
+      columns.usageBegin[record] = (uint32_t)columns.usage.size();
+      columns.usageCount[record] = (uint32_t)it.usage.size();
+
+      for (const auto &_usage : it.usage)
+        columns.usage.emplace_back((uint32_t)_usage.resourceIndex, (float)_usage.pressure);
+
+      columns.registerTotalPressureCycles[record] = (uint32_t)it.registerPressure.totalPressureCycles;
+      columns.registerPressureCycles[record] = (uint32_t)it.registerPressure.selfPressureCycles;
+      columns.registerOrigin[record] = getOriginRecord(it.registerPressure.origin);
+
+      if (it.registerPressure.origin.has_value())
+        columns.registerNameId[record] = getNameId(it.registerPressure.registerName);
+
+      columns.memoryTotalPressureCycles[record] = (uint32_t)it.memoryPressure.totalPressureCycles;
+      columns.memoryPressureCycles[record] = (uint32_t)it.memoryPressure.selfPressureCycles;
+      columns.memoryOrigin[record] = getOriginRecord(it.memoryPressure.origin);
+
+      columns.resourceTotalPressureCycles[record] = (uint32_t)it.resourcePressure.totalPressureCycles;
+
+      uint32_t *pLink = &columns.resourceDependencyHead[record];
+
+      for (const auto &_dependency : it.resourcePressure.associatedResources)
+      {
+        *pLink = (uint32_t)columns.resourceDependencies.size();
+
+        FlowColumnResourceDependency &dependency = columns.resourceDependencies.emplace_back(_dependency.resourceTypeIndex == (size_t)-1 ? FlowColumns::None : (uint32_t)_dependency.resourceTypeIndex, _dependency.firstMatchingPortIndex == (size_t)-1 ? FlowColumns::None : (uint32_t)_dependency.firstMatchingPortIndex, getNameId(_dependency.resourceName));
+        dependency.pressureCycles = (uint32_t)_dependency.pressureCycles;
+        dependency.origin = getOriginRecord(_dependency.origin);
+
+        pLink = &dependency.next;
+      }
+    }
+  }
+
+  *pColumns = std::move(columns);
+
+  return true;
+}
+
+bool execution_flow_get_state_statistics(const FlowColumns &columns, const size_t portCount, FlowStateStatistics *pStatistics, const size_t maxIterations /* = (size_t)-1 */)
+{
+  if (pStatistics == nullptr)
+    return false;
+
+  const size_t iterationCount = std::min(columns.iterationCount, maxIterations);
+
+  FlowStateStatistics statistics;
+  statistics.perIteration.resize(iterationCount);
+  statistics.total.distinctPortCycles.resize(portCount, 0);
+
+  // `[begin, end)` clock intervals per state & port. The merged intervals of every iteration are collected for the total.
+  std::vector<std::pair<size_t, size_t>> stateIntervals[_ES_Count];
+  std::vector<std::pair<size_t, size_t>> allStateIntervals[_ES_Count];
+  std::vector<std::vector<std::pair<size_t, size_t>>> portIntervals(portCount);
+  std::vector<std::vector<std::pair<size_t, size_t>>> allPortIntervals(portCount);
+
+  for (size_t i = 0; i < iterationCount; i++)
+  {
+    ExecutionStateStatistics &stats = statistics.perIteration[i];
+    stats.distinctPortCycles.resize(portCount, 0);
+
+    const size_t firstRecord = columns.recordIndex(i, 0);
+    const size_t lastRecord = firstRecord + columns.instructionCount;
+
+    for (size_t r = firstRecord; r < lastRecord; r++)
+    {
+      const size_t clocks[_ES_Count + 1] = { columns.clockDispatched[r], columns.clockPending[r], columns.clockReady[r], columns.clockIssued[r], columns.clockExecuted[r], columns.clockRetired[r] };
+
+      stats.earliestDispatch = std::min(stats.earliestDispatch, clocks[ES_Dispatched]);
+      stats.lastRetire = std::max(stats.lastRetire, clocks[_ES_Count]);
+      stats.earliestIssued = std::min(stats.earliestIssued, clocks[ES_Executing]);
+      stats.lastExecuted = std::max(stats.lastExecuted, clocks[ES_Retiring]);
+
+      for (size_t state = 0; state < _ES_Count; state++)
+      {
+        stats.totalStateCycles[state] += clocks[state + 1] - clocks[state];
+
+        if (clocks[state] < clocks[state + 1])
+          stateIntervals[state].emplace_back(clocks[state], clocks[state + 1]);
+      }
+
+      if (clocks[ES_Executing] < clocks[ES_Retiring])
+      {
+        for (size_t u = columns.usageBegin[r]; u < columns.usageBegin[r] + columns.usageCount[r]; u++)
+        {
+          const size_t portIndex = columns.usage[u].portIndex;
+
+          if (portIndex < portCount)
+            portIntervals[portIndex].emplace_back(clocks[ES_Executing], clocks[ES_Retiring]);
+        }
+      }
+    }
+
+    for (size_t state = 0; state < _ES_Count; state++)
+    {
+      stats.distinctStateCycles[state] = execution_flow_merge_intervals(stateIntervals[state]);
+      statistics.total.totalStateCycles[state] += stats.totalStateCycles[state];
+
+      allStateIntervals[state].insert(allStateIntervals[state].end(), stateIntervals[state].begin(), stateIntervals[state].end());
+      stateIntervals[state].clear();
+    }
+
+    for (size_t port = 0; port < portCount; port++)
+    {
+      stats.distinctPortCycles[port] = execution_flow_merge_intervals(portIntervals[port]);
+
+      allPortIntervals[port].insert(allPortIntervals[port].end(), portIntervals[port].begin(), portIntervals[port].end());
+      portIntervals[port].clear();
+    }
+
+    statistics.total.earliestDispatch = std::min(statistics.total.earliestDispatch, stats.earliestDispatch);
+    statistics.total.lastRetire = std::max(statistics.total.lastRetire, stats.lastRetire);
+    statistics.total.earliestIssued = std::min(statistics.total.earliestIssued, stats.earliestIssued);
+    statistics.total.lastExecuted = std::max(statistics.total.lastExecuted, stats.lastExecuted);
+  }
+
+  for (size_t state = 0; state < _ES_Count; state++)
+    statistics.total.distinctStateCycles[state] = execution_flow_merge_intervals(allStateIntervals[state]);
+
+  for (size_t port = 0; port < portCount; port++)
+    statistics.total.distinctPortCycles[port] = execution_flow_merge_intervals(allPortIntervals[port]);
+
+  *pStatistics = std::move(statistics);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool execution_flow_decode(ExecutionFlowContext *pContext, const void *pAssembledBytes, const size_t assembledBytesLength, std::vector<llvm::MCInst> &decodedInstructions, PortUsageFlow &flow, const bool printInstructions /* = true */)
+{
+  // Construct `ArrayRef` to feed the disassembler with.
+  llvm::ArrayRef<uint8_t> bytes(reinterpret_cast<const uint8_t *>(pAssembledBytes), assembledBytesLength);
+
+  bool result = true;
+
+  for (size_t i = 0; i < assembledBytesLength;)
+  {
+    size_t instructionSize = 1;
+
+    llvm::MCInst retrievedInstruction;
+    const llvm::MCDisassembler::DecodeStatus status = pContext->disassembler->getInstruction(retrievedInstruction, instructionSize, bytes.slice(i), i, llvm::nulls());
+
+    switch (status)
+    {
+    case llvm::MCDisassembler::Fail: // let's try to squeeze out as many instructions as we can find...
+      instructionSize = std::max(instructionSize, (size_t)1);
+      result = false;
+      break;
+
+    default: // we ignore soft-fails.
+    {
+      InstructionInfo &info = flow.instructionExecutionInfo.emplace_back(decodedInstructions.size(), i, instructionSize, (uint32_t)retrievedInstruction.getOpcode());
+
+      // Print it right away, so tools don't have to decode the bytes again.
+      if (printInstructions)
+        execution_flow_print_instruction(pContext, retrievedInstruction, i, info.disassembly);
+
+      decodedInstructions.push_back(retrievedInstruction);
+      break;
+    }
+    }
+
+    i += instructionSize;
+  }
+
+  return result;
+}
+
+// Collects the instructions emitted by the assembly parser. Labels, data & section directives are ignored.
+class InstructionCollector final : public llvm::MCStreamer
+{
+public:
+  std::vector<llvm::MCInst> instructions;
+
+  inline InstructionCollector(llvm::MCContext &context) :
+    llvm::MCStreamer(context)
+  { }
+
+  inline void emitInstruction(const llvm::MCInst &instruction, const llvm::MCSubtargetInfo &) override { instructions.push_back(instruction); }
+
+  inline bool emitSymbolAttribute(llvm::MCSymbol *, llvm::MCSymbolAttr) override { return true; }
+  inline void emitCommonSymbol(llvm::MCSymbol *, uint64_t, llvm::Align) override { }
+  inline void emitZerofill(llvm::MCSection *, llvm::MCSymbol *, uint64_t, llvm::Align, llvm::SMLoc) override { }
+};
+
+static bool execution_flow_assemble(ExecutionFlowContext *pContext, const char *assemblyText, const size_t assemblyTextLength, const AssemblySyntax syntax, std::vector<llvm::MCInst> &assembledInstructions, PortUsageFlow &flow, const bool printInstructions /* = true */)
+{
+  llvm::SourceMgr sourceManager;
+  sourceManager.AddNewSourceBuffer(llvm::MemoryBuffer::getMemBuffer(llvm::StringRef(assemblyText, assemblyTextLength), "<assembly>", false), llvm::SMLoc());
+
+  // Labels & symbols are defined in the `MCContext`, so every call gets a fresh one instead of the one the disassembler uses.
+  llvm::MCContext context(pContext->targetTriple, pContext->asmInfo.get(), pContext->registerInfo.get(), pContext->subtargetInfo.get(), &sourceManager, &pContext->targetOptions);
+  std::unique_ptr<llvm::MCObjectFileInfo> objectFileInfo(pContext->pTarget->createMCObjectFileInfo(context, false));
+  context.setObjectFileInfo(objectFileInfo.get());
+
+  // The target parser expects a target streamer for directives like `.seh_*` or `.cv_fpo_*`. Whatever it prints is discarded. Has to outlive `collector`, which owns the target streamer.
+  llvm::formatted_raw_ostream formattedNulls(llvm::nulls());
+
+  InstructionCollector collector(context);
+  pContext->pTarget->createAsmTargetStreamer(collector, formattedNulls, nullptr, true);
+
+  std::unique_ptr<llvm::MCAsmParser> parser(llvm::createMCAsmParser(sourceManager, context, collector, *pContext->asmInfo));
+  std::unique_ptr<llvm::MCTargetAsmParser> targetParser(pContext->pTarget->createMCAsmParser(*pContext->subtargetInfo, *parser, *pContext->instructionInfo, pContext->targetOptions));
+  std::unique_ptr<llvm::MCCodeEmitter> codeEmitter(pContext->pTarget->createMCCodeEmitter(*pContext->instructionInfo, context));
+
+  if (targetParser == nullptr || codeEmitter == nullptr)
+    return false;
+
+  // `.att_syntax` & `.intel_syntax` directives in the text still take precedence.
+  if (syntax == AssemblySyntax::Intel)
+  {
+    parser->setAssemblerDialect(1);
+    parser->getLexer().setLexMasmIntegers(true); // like `05h` & `101b`.
+  }
+
+  parser->setTargetParser(*targetParser);
+
+  // Errors are reported to `stderr` by the `SourceMgr`. Whatever has been parsed up to that point is still simulated.
+  const bool result = !parser->Run(false);
+
+  llvm::SmallVector<char, 16> encodedBytes;
+  llvm::SmallVector<llvm::MCFixup, 4> fixups;
+  size_t byteOffset = 0;
+
+  for (llvm::MCInst &instruction : collector.instructions)
+  {
+    // Only encoded to get the instruction lengths & offsets, fixups for labels are irrelevant.
+    encodedBytes.clear();
+    fixups.clear();
+    codeEmitter->encodeInstruction(instruction, encodedBytes, fixups, *pContext->subtargetInfo);
+
+    InstructionInfo &info = flow.instructionExecutionInfo.emplace_back(assembledInstructions.size(), byteOffset, encodedBytes.size(), (uint32_t)instruction.getOpcode());
+
+    if (printInstructions)
+      execution_flow_print_instruction(pContext, instruction, byteOffset, info.disassembly);
+
+    // Expressions are allocated by `context`, but the instructions are retained by the `ExecutionFlowContext`. The simulation doesn't care about the values anyways.
+    for (llvm::MCOperand &operand : instruction)
+    {
+      if (operand.isExpr())
+      {
+        int64_t value = 0;
+        operand.getExpr()->evaluateAsAbsolute(value);
+        operand = llvm::MCOperand::createImm(value);
+      }
+    }
+
+    byteOffset += encodedBytes.size();
+    assembledInstructions.push_back(instruction);
+  }
+
+  return result;
+}
+
+static void execution_flow_print_instruction(ExecutionFlowContext *pContext, const llvm::MCInst &instruction, const uint64_t address, std::string &disassembly)
+{
+  llvm::raw_string_ostream stream(disassembly);
+  pContext->instructionPrinter->printInst(&instruction, address, "", *pContext->subtargetInfo, stream);
+  stream.flush();
+
+  // The printer separates the mnemonic & operands with tabs.
+  const size_t firstCharacter = disassembly.find_first_not_of(" \t");
+  disassembly.erase(0, std::min(firstCharacter, disassembly.size()));
+  std::replace(disassembly.begin(), disassembly.end(), '\t', ' ');
+}
+
+static bool execution_flow_simulate(ExecutionFlowContext *pContext, const llvm::ArrayRef<llvm::MCInst> decodedInstructions, PortUsageFlow &flow, const size_t iterations, const size_t relevantIteration, const SimulationParameters &parameters /* = SimulationParameters() */)
+{
+  llvm::SmallVector<std::unique_ptr<llvm::mca::Instruction>> mcaInstructions;
+  bool result = execution_flow_create_mca_instructions(pContext, decodedInstructions, mcaInstructions);
+
+  // Create source for the `Pipeline` & `HWEventListener`.
+  std::unique_ptr<llvm::mca::SourceMgr> source;
+  llvm::mca::IncrementalSourceMgr *pIncrementalSource = nullptr;
+
+  if (parameters.retainedIterations == 0)
+  {
+    source = std::make_unique<llvm::mca::CircularSourceMgr>(mcaInstructions, (uint32_t)iterations);
+  }
+  else
+  {
+    // The streamed instructions are fed individually, so every one of them has to be there.
+    if (mcaInstructions.size() != decodedInstructions.size())
+      return false;
+
+    std::unique_ptr<llvm::mca::IncrementalSourceMgr> incrementalSource = std::make_unique<llvm::mca::IncrementalSourceMgr>();
+    pIncrementalSource = incrementalSource.get();
+    source = std::move(incrementalSource);
+  }
+
+  // Create custom behaviour.
+  std::unique_ptr<llvm::mca::CustomBehaviour> customBehaviour(pContext->pTarget->createCustomBehaviour(*pContext->subtargetInfo, *source, *pContext->instructionInfo));
+
+  if (customBehaviour == nullptr)
+    customBehaviour = std::make_unique<llvm::mca::CustomBehaviour>(*pContext->subtargetInfo, *source, *pContext->instructionInfo);
+
+  // Create MCA context.
+  llvm::mca::Context mcaContext(*pContext->registerInfo, *pContext->subtargetInfo);
+
+  const llvm::MCSchedModel &schedulerModel = pContext->subtargetInfo->getSchedModel();
+  const PipelineOptions &options = pContext->pipelineOptions;
+  llvm::mca::PipelineOptions pipelineOptions(options.microOpQueueSize, options.decodersThroughput, options.dispatchWidth, options.registerFileSize, options.loadQueueSize, options.storeQueueSize, options.assumeNoAlias, true);
+
+  // Create and fill the pipeline with the source.
+  std::unique_ptr<llvm::mca::Pipeline> pipeline(mcaContext.createDefaultPipeline(pipelineOptions, *source, *customBehaviour));
+
+  execution_flow_prepare_flow(pContext, flow);
+
+  // Create event handler to observe simulated hardware events.
+  FlowView flowView(&flow, schedulerModel, *pContext->instructionPrinter, relevantIteration);
+  pipeline->addEventListener(&flowView);
+
+  execution_flow_prepare_flow_view(pContext, flowView);
+  flowView.setCollectionLevel(parameters.collectionLevel);
+
+  if (parameters.columnar)
+    flowView.setColumnar(iterations);
+
+  // Run the pipeline.
+  if (pIncrementalSource == nullptr)
+  {
+    llvm::Expected<uint32_t> cycles = pipeline->run();
+
+    if (!cycles)
+    {
+      llvm::consumeError(cycles.takeError());
+      result = false;
+    }
+  }
+  else
+  {
+    if (parameters.pConvergenceOptions != nullptr)
+      flowView.setConvergenceOptions(*parameters.pConvergenceOptions);
+
+    flowView.setRetainedIterations(parameters.retainedIterations, iterations);
+    result &= execution_flow_run_streaming(*pIncrementalSource, *pipeline, flowView, mcaInstructions, iterations);
+    flowView.trimRetainedIterations();
+  }
+
+  return result;
+}
+
+static bool execution_flow_create_mca_instructions(ExecutionFlowContext *pContext, const llvm::ArrayRef<llvm::MCInst> decodedInstructions, llvm::SmallVector<std::unique_ptr<llvm::mca::Instruction>> &mcaInstructions)
+{
+  // The `InstrBuilder` only ever grows its descriptor cache, so we'll occasionally start over to keep the retained instructions in check.
+  // Clearing it invalidates the descriptors of all instructions that have been created before, so this has to happen before any of the new ones are created.
+  if (pContext->retainedInstructions.size() > MaxRetainedInstructions)
+  {
+    pContext->instructionBuilder->clear();
+    pContext->retainedInstructions.clear();
+  }
+
+  const size_t firstRetainedInstruction = pContext->retainedInstructions.size();
+  pContext->retainedInstructions.insert(pContext->retainedInstructions.end(), decodedInstructions.begin(), decodedInstructions.end());
+
+  llvm::mca::InstrPostProcess instructionPostProcess(*pContext->subtargetInfo, *pContext->instructionInfo);
+  instructionPostProcess.resetState();
+
+  // Retrieve `llvm::mca::Instruction`s.
+  for (size_t i = firstRetainedInstruction; i < pContext->retainedInstructions.size(); i++)
+  {
+    const llvm::MCInst &instr = pContext->retainedInstructions[i];
+    llvm::Expected<std::unique_ptr<llvm::mca::Instruction>> mcaInstr = pContext->instructionBuilder->createInstruction(instr, llvm::SmallVector<llvm::mca::Instrument *>()); // from debugging llvm-mca it appears that the second parameter (vector) can be empty (at least whenever there aren't any jumps / calls in the active region.
+
+    if (!mcaInstr)
+    {
+      llvm::consumeError(mcaInstr.takeError());
+      return false;
+    }
+
+    instructionPostProcess.postProcessInstruction(mcaInstr.get(), instr);
+    mcaInstructions.emplace_back(std::move(mcaInstr.get()));
+  }
+
+  return true;
+}
+
+static void execution_flow_enumerate_ports(const llvm::MCSchedModel &schedulerModel, std::vector<ResourceInfo> &ports, std::vector<uint32_t> &resourceUnitToPortIndex, size_t &resourceUnitStride)
+{
+  const size_t resourceTypeCount = schedulerModel.getNumProcResourceKinds();
+  size_t validTypeIndex = (size_t)-1;
+
+  ports.clear();
+  resourceUnitStride = 0;
+
+  // The port lookup is a flat table of all units of all resources, as it's hit for every resource of every issued instruction.
+  for (size_t i = 1; i < resourceTypeCount; i++)
+    resourceUnitStride = std::max(resourceUnitStride, (size_t)schedulerModel.getProcResource((uint32_t)i)->NumUnits);
+
+  resourceUnitToPortIndex.assign(resourceTypeCount * resourceUnitStride, UINT32_MAX);
+
+  for (size_t i = 1; i < resourceTypeCount; i++) // index 0 appears to be used as `null`-index.
+  {
+    const llvm::MCProcResourceDesc *pResource = schedulerModel.getProcResource((uint32_t)i);
+    const size_t perResourcePortCount = pResource->NumUnits;
+
+    if (perResourcePortCount == 0 || pResource->SubUnitsIdxBegin != nullptr) // if `SubUnitsIdxBegin` isn't `nullptr`, there'll be another resource that doesn't indicate *all* of the resources, but the sub-resources individually.
+      continue;
+
+    ++validTypeIndex;
+
+    for (size_t j = 0; j < perResourcePortCount; j++)
+    {
+      std::string name = pResource->Name;
+
+      if (perResourcePortCount > 1)
+        name = name + " " + std::to_string(j + 1);
+
+      resourceUnitToPortIndex[i * resourceUnitStride + j] = (uint32_t)ports.size();
+      ports.emplace_back(validTypeIndex, j, name);
+    }
+  }
+}
+
+static void execution_flow_prepare_flow(const ExecutionFlowContext *pContext, PortUsageFlow &flow)
+{
+  // Ports & Register Files have already been enumerated by the context.
+  flow.ports = pContext->ports;
+  flow.hardwareRegisters = pContext->hardwareRegisters;
+  flow.statistics.portPressureCycles.resize(flow.ports.size(), 0);
+  flow.statistics.portBusyCycles.resize(flow.ports.size(), 0);
+}
+
+static void execution_flow_prepare_flow_view(const ExecutionFlowContext *pContext, FlowView &flowView)
+{
+  flowView.setResourceUnitToPortIndexLookup(pContext->resourceUnitToPortIndex, pContext->resourceUnitStride);
+
+  for (const bool _relevant : pContext->registerFileRelevancy)
+    flowView.addRegisterFileRelevancy(_relevant);
+}
+
+static bool execution_flow_simulate_with_model(const ExecutionFlowContext *pContext, const SweepModel &model, const llvm::ArrayRef<std::unique_ptr<llvm::mca::Instruction>> mcaInstructions, const size_t iterations, PortUsageFlow &flow)
+{
+  const llvm::MCSchedModel &schedulerModel = model.model;
+  const PipelineOptions &options = model.options;
+
+  // The source only hands out the instructions to the `EntryStage`, which copies them. That way the pipelines can share them.
+  llvm::mca::CircularSourceMgr source(mcaInstructions, (uint32_t)iterations);
+
+  // The same hardware units & stages as `Context::createDefaultPipeline` builds for out-of-order models. The units have to outlive the pipeline.
+  llvm::mca::RetireControlUnit retireControlUnit(schedulerModel);
+  llvm::mca::RegisterFile registerFile(schedulerModel, *pContext->registerInfo, options.registerFileSize);
+  llvm::mca::LSUnit loadStoreUnit(schedulerModel, options.loadQueueSize, options.storeQueueSize, options.assumeNoAlias);
+  llvm::mca::Scheduler scheduler(schedulerModel, loadStoreUnit);
+
+  execution_flow_prepare_flow(pContext, flow);
+
+  // Sweeps & port sensitivities may add units that the context never listed, so the ports are enumerated from the modified model.
+  std::vector<uint32_t> resourceUnitToPortIndex;
+  size_t resourceUnitStride = 0;
+  execution_flow_enumerate_ports(schedulerModel, flow.ports, resourceUnitToPortIndex, resourceUnitStride);
+
+  flow.statistics.portPressureCycles.assign(flow.ports.size(), 0);
+  flow.statistics.portBusyCycles.assign(flow.ports.size(), 0);
+
+  FlowView flowView(&flow, schedulerModel, *pContext->instructionPrinter, 0);
+  execution_flow_prepare_flow_view(pContext, flowView);
+  flowView.setResourceUnitToPortIndexLookup(resourceUnitToPortIndex, resourceUnitStride);
+  flowView.setCollectionLevel(CollectionLevel::Summary);
+
+  llvm::mca::Pipeline pipeline;
+  pipeline.appendStage(std::make_unique<llvm::mca::EntryStage>(source));
+
+  if (options.microOpQueueSize != 0)
+    pipeline.appendStage(std::make_unique<llvm::mca::MicroOpQueueStage>(options.microOpQueueSize, options.decodersThroughput));
+
+  pipeline.appendStage(std::make_unique<llvm::mca::DispatchStage>(*pContext->subtargetInfo, *pContext->registerInfo, options.dispatchWidth, retireControlUnit, registerFile));
+  pipeline.appendStage(std::make_unique<llvm::mca::ExecuteStage>(scheduler, true));
+  pipeline.appendStage(std::make_unique<llvm::mca::RetireStage>(retireControlUnit, registerFile, loadStoreUnit));
+  pipeline.addEventListener(&flowView);
+
+  llvm::Expected<uint32_t> cycles = pipeline.run();
+
+  if (!cycles)
+  {
+    llvm::consumeError(cycles.takeError());
+    return false;
+  }
+
+  return true;
+}
+
+static bool execution_flow_run_streaming(llvm::mca::IncrementalSourceMgr &source, llvm::mca::Pipeline &pipeline, const FlowView &flowView, llvm::SmallVector<std::unique_ptr<llvm::mca::Instruction>> &mcaInstructions, const size_t iterations)
+{
+  const size_t instructionCount = mcaInstructions.size();
+
+  // The `EntryStage` copies every instruction it takes from the source, so the source instructions are just templates that can be handed out again as soon as they've been freed.
+  // Instructions are freed in the order they were added, so the n-th freed instruction always belongs to `n % instructionCount`.
+  std::vector<llvm::SmallVector<llvm::mca::Instruction *, 4>> recycledInstructions(instructionCount);
+  std::vector<const llvm::mca::Instruction *> templateInstructions(instructionCount);
+  size_t freedInstructionCount = 0;
+
+  source.setOnInstFreedCallback([&](llvm::mca::Instruction *pInstruction)
+    {
+      recycledInstructions[freedInstructionCount % instructionCount].push_back(pInstruction);
+      freedInstructionCount++;
+    });
+
+  for (size_t i = 0; i < instructionCount; i++)
+  {
+    templateInstructions[i] = mcaInstructions[i].get();
+    source.addInst(std::move(mcaInstructions[i]));
+  }
+
+  // Feed enough instructions at once to not pause the pipeline every couple of cycles.
+  const size_t iterationsPerBatch = std::max((size_t)1, StreamingInstructionsPerBatch / instructionCount);
+  size_t fedIterations = 1;
+
+  while (true)
+  {
+    // Once the steady state has been found, only the instructions that are already in flight are simulated.
+    const size_t batchEnd = flowView.hasConverged() ? fedIterations : std::min(fedIterations + iterationsPerBatch, iterations);
+
+    for (; fedIterations < batchEnd; fedIterations++)
+    {
+      for (size_t i = 0; i < instructionCount; i++)
+      {
+        if (recycledInstructions[i].size() > 0)
+          source.addRecycledInst(recycledInstructions[i].pop_back_val());
+        else // None of them have been freed yet, so let's duplicate the template. The source keeps ownership of it.
+          source.addInst(std::make_unique<llvm::mca::Instruction>(*templateInstructions[i]));
+      }
+    }
+
+    if (fedIterations == batchEnd && (fedIterations == iterations || flowView.hasConverged()))
+      source.endOfStream();
+
+    llvm::Expected<uint32_t> cycles = pipeline.run();
+
+    if (cycles)
+      return true;
+
+    if (!cycles.errorIsA<llvm::mca::InstStreamPause>())
+    {
+      llvm::consumeError(cycles.takeError());
+      return false;
+    }
+
+    // The pipeline ran dry & wants more instructions.
+    llvm::consumeError(cycles.takeError());
+  }
+}
+
+// Sorts & merges the `[begin, end)` intervals in place and returns the number of distinct cycles they cover.
+static size_t execution_flow_merge_intervals(std::vector<std::pair<size_t, size_t>> &intervals)
+{
+  if (intervals.empty())
+    return 0;
+
+  std::sort(intervals.begin(), intervals.end());
+
+  size_t merged = 0;
+  size_t cycles = 0;
+
+  for (size_t i = 1; i < intervals.size(); i++)
+  {
+    if (intervals[i].first <= intervals[merged].second)
+    {
+      intervals[merged].second = std::max(intervals[merged].second, intervals[i].second);
+    }
+    else
+    {
+      cycles += intervals[merged].second - intervals[merged].first;
+      intervals[++merged] = intervals[i];
+    }
+  }
+
+  cycles += intervals[merged].second - intervals[merged].first;
+  intervals.resize(merged + 1);
+
+  return cycles;
+}
+
+const char *core_arch_to_string(const CoreArchitecture arch)
+{
+  if ((size_t)arch >= std::size(CoreArchitectureLookup))
+    return nullptr;
+
+  return CoreArchitectureLookup[(size_t)arch];
+}
+
@@ -18,3 +18,4 @@ solution "execution-flow"
 
   dofile "execution-flow/project.lua"
   dofile "execution-flow-html/project.lua"
+  dofile "execution-flow-bench/project.lua"